@@ -14,6 +14,7 @@ class GraylogLoggerConan(ConanFile):
         "include/*",
         "cmake/*",
         "console_logger/*",
+        "graylog_relay/*",
         "unit_tests/*",
         "performance_test/*",
         "conanfile.py",
@@ -30,6 +31,7 @@ class GraylogLoggerConan(ConanFile):
         "benchmark/1.6.1",
         "concurrentqueue/1.0.3",
         "fmt/8.1.1",
+        "zlib/1.2.13",
     )
     
     generators = "CMakeDeps", "CMakeToolchain"
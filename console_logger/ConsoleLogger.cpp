@@ -7,14 +7,20 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include <array>
 #include <chrono>
 #include <ciso646>
 #include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <graylog_logger/BinaryLogReader.hpp>
 #include <graylog_logger/ConsoleInterface.hpp>
 #include <graylog_logger/FileInterface.hpp>
 #include <graylog_logger/GraylogInterface.hpp>
 #include <graylog_logger/Log.hpp>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #ifdef _WIN32
@@ -24,6 +30,8 @@
 #endif
 
 void PrintAlternatives();
+bool ParseTime(const std::string &Value, Log::system_time &Time);
+int DecodeFile(const std::string &FileName, const Log::BinaryLogQuery &Query);
 
 int main(int argc, char **argv) {
   using namespace Log;
@@ -35,6 +43,10 @@ int main(int argc, char **argv) {
   float timeout = 1.0;
   std::string extraKey;
   AdditionalField extraField;
+  FileFormat fileFormat = FileFormat::Text;
+  std::string decodeFileName;
+  bool levelSet = false;
+  BinaryLogQuery query;
   static struct option long_options[]{
       {"help", no_argument, nullptr, 'h'},
       {"file", optional_argument, nullptr, 'f'},
@@ -44,10 +56,16 @@ int main(int argc, char **argv) {
       {"level", required_argument, nullptr, 'l'},
       {"message", required_argument, nullptr, 'm'},
       {"extra", optional_argument, nullptr, 'e'},
+      {"binary", no_argument, nullptr, 'b'},
+      {"json", no_argument, nullptr, 'j'},
+      {"decode", required_argument, nullptr, 'd'},
+      {"from", required_argument, nullptr, 'F'},
+      {"to", required_argument, nullptr, 'T'},
+      {nullptr, 0, nullptr, 0},
   };
   int option_index = 0;
   while (true) {
-    int c = getopt_long(argc, argv, "hf::p:t:l:m:a::e:", long_options,
+    int c = getopt_long(argc, argv, "hf::p:t:l:m:a::e:bjd:F:T:", long_options,
                         &option_index);
     if (c == -1) {
       break;
@@ -110,11 +128,29 @@ int main(int argc, char **argv) {
           PrintAlternatives();
           return 0;
         }
-        if (sevLevel < 0 or sevLevel > 7) {
-          std::cout << "Level is not a value between 0 and 7.\n";
+        if (sevLevel < 0 or sevLevel > 8) {
+          std::cout << "Level is not a value between 0 and 8.\n";
           PrintAlternatives();
           return 0;
         }
+        levelSet = true;
+      }
+      break;
+    case 'b':
+      fileFormat = FileFormat::Binary;
+      break;
+    case 'j':
+      fileFormat = FileFormat::Json;
+      break;
+    case 'd':
+      decodeFileName = std::string(optarg);
+      break;
+    case 'F':
+    case 'T':
+      if (not ParseTime(optarg, c == 'F' ? query.From : query.To)) {
+        std::cout << "Unable to parse time: \"" << optarg << "\"\n";
+        PrintAlternatives();
+        return 0;
       }
       break;
     case 'e':
@@ -134,6 +170,12 @@ int main(int argc, char **argv) {
       break;
     }
   }
+  if (not decodeFileName.empty()) {
+    if (levelSet) {
+      query.MinimumSeverity = Severity(sevLevel);
+    }
+    return DecodeFile(decodeFileName, query);
+  }
   if (msg.empty()) {
     PrintAlternatives();
     return 0;
@@ -148,7 +190,10 @@ int main(int argc, char **argv) {
   Log::AddLogHandler(std::make_shared<ConsoleInterface>());
 
   if (not fileName.empty()) {
-    Log::AddLogHandler(std::make_shared<FileInterface>(fileName));
+    FileConfig fileConfig;
+    fileConfig.Name = fileName;
+    fileConfig.Format = fileFormat;
+    Log::AddLogHandler(std::make_shared<FileInterface>(fileConfig));
   }
 
   if (not address1.empty()) {
@@ -174,12 +219,98 @@ int main(int argc, char **argv) {
   return 0;
 }
 
+/// \brief Parse a local time ("YYYY-mm-dd HH:MM:SS") or the number of
+/// seconds since the epoch.
+bool ParseTime(const std::string &Value, Log::system_time &Time) {
+  if (not Value.empty() and
+      Value.find_first_not_of("0123456789") == std::string::npos) {
+    Time = std::chrono::system_clock::from_time_t(std::stoll(Value));
+    return true;
+  }
+  std::tm LocalTime{};
+  std::istringstream Input(Value);
+  Input >> std::get_time(&LocalTime, "%Y-%m-%d %H:%M:%S");
+  if (Input.fail()) {
+    return false;
+  }
+  LocalTime.tm_isdst = -1;
+  Time = std::chrono::system_clock::from_time_t(std::mktime(&LocalTime));
+  return true;
+}
+
+/// \brief Print the messages in a binary log file matching the query, in the
+/// format used for text files followed by the additional fields.
+int DecodeFile(const std::string &FileName, const Log::BinaryLogQuery &Query) {
+  using namespace Log;
+  BinaryLogReader Reader(FileName);
+  if (not Reader.isValid()) {
+    std::cout << "Unable to read binary log file: \"" << FileName << "\"\n";
+    return 1;
+  }
+  static const std::array<const char *, 9> SeverityNames{
+      {"EMERGENCY", "ALERT", "CRITICAL", "ERROR", "WARNING", "Notice", "Info",
+       "Debug", "Trace"}};
+  std::string Output;
+  std::time_t CachedTime{-1};
+  std::string CachedTimeString;
+  Reader.read(Query, [&](const LogMessage &Message) {
+    auto Time = std::chrono::system_clock::to_time_t(Message.Timestamp);
+    if (Time != CachedTime) {
+      std::tm LocalTime{};
+#ifdef _WIN32
+      localtime_s(&LocalTime, &Time);
+#else
+      localtime_r(&Time, &LocalTime);
+#endif
+      std::array<char, 50> TimeBuffer{};
+      auto Length = std::strftime(TimeBuffer.data(), TimeBuffer.size(),
+                                  "%F %T", &LocalTime);
+      CachedTimeString.assign(TimeBuffer.data(), Length);
+      CachedTime = Time;
+    }
+    Output.append(CachedTimeString);
+    Output.append(" (");
+    Output.append(Message.Host);
+    Output.append(") ");
+    auto Level = static_cast<size_t>(Message.SeverityLevel);
+    Output.append(Level < SeverityNames.size() ? SeverityNames[Level]
+                                               : "Unknown");
+    Output.append(": ");
+    Output.append(Message.MessageString);
+    for (auto &Field : Message.AdditionalFields) {
+      Output.append(" ");
+      Output.append(Field.first);
+      Output.append("=");
+      switch (Field.second.FieldType) {
+      case AdditionalField::Type::typeStr:
+        Output.append(Field.second.strVal);
+        break;
+      case AdditionalField::Type::typeInt:
+        Output.append(std::to_string(Field.second.intVal));
+        break;
+      case AdditionalField::Type::typeDbl:
+        Output.append(std::to_string(Field.second.dblVal));
+        break;
+      }
+    }
+    Output.push_back('\n');
+    if (Output.size() >= 64 * 1024) {
+      std::fwrite(Output.data(), 1, Output.size(), stdout);
+      Output.clear();
+    }
+  });
+  std::fwrite(Output.data(), 1, Output.size(), stdout);
+  return 0;
+}
+
 void PrintAlternatives() {
   std::cout << "\nusage: console_logger [-h] [-f<file_name>] [-a<address>] "
                "[-p<port>]\n";
   std::cout << "                      [-t<timeout in s>] [-l <level>] "
                "[-m<message>]\n";
-  std::cout << "                      [-e<key>:<value>]\n\n";
+  std::cout << "                      [-e<key>:<value>] [-b|-j]\n";
+  std::cout << "       console_logger -d<file_name> [-l <level>] "
+               "[-F<time>] [-T<time>]\n\n";
   std::cout << "This application will write the log message to file and socket "
                "by default.\n";
   std::cout << "To prevent the application from doing this, use the -f and -a "
@@ -194,5 +325,17 @@ void PrintAlternatives() {
                "field parameter requires\n";
   std::cout << "that the key and value of the field is separated using the "
                "colon character.\n\n";
+  std::cout << "The -j flag writes the log file as JSON lines (GELF).\n";
+  std::cout << "The -b flag writes the log file in the binary format. Binary "
+               "files are printed\n";
+  std::cout << "using the -d (--decode) flag. Messages are then only printed "
+               "if their level is\n";
+  std::cout << "at most the -l parameter (default: 8) and they are from the "
+               "time range given\n";
+  std::cout << "by -F (--from) and -T (--to), either as local time "
+               "(\"YYYY-mm-dd HH:MM:SS\") or\n";
+  std::cout << "as the number of seconds since the epoch.\n\n";
   std::cout << "Example: ./console_logger -t2.0 -m\"This is a log message.\"\n";
+  std::cout << "         ./console_logger -dmessages.bin -l3 "
+               "-F\"2026-10-19 12:00:00\"\n";
 }
@@ -0,0 +1,188 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Relay forwarding GELF messages from the processes of a host to a
+/// Graylog server using a single connection.
+///
+//===----------------------------------------------------------------------===//
+
+#include "RelayServer.hpp"
+#include <ciso646>
+#include <csignal>
+#include <getopt.h>
+#include <graylog_logger/GraylogHttpInterface.hpp>
+#include <graylog_logger/GraylogInterface.hpp>
+#include <graylog_logger/GraylogUdpInterface.hpp>
+#include <iostream>
+#include <string>
+
+void PrintAlternatives();
+
+namespace {
+/// \brief The connection to the Graylog server, independent of transport.
+struct Upstream {
+  Log::RelayServer::MessageHandler Send;
+  std::function<bool(std::chrono::system_clock::duration)> Flush;
+  std::shared_ptr<void> Connection;
+};
+
+template <class ConnectionType> Upstream makeUpstream(ConnectionType *Ptr) {
+  std::shared_ptr<ConnectionType> Connection(Ptr);
+  return {[Connection](std::string Msg) {
+            Connection->sendMessage(std::move(Msg));
+          },
+          [Connection](std::chrono::system_clock::duration TimeOut) {
+            return Connection->flush(TimeOut);
+          },
+          Connection};
+}
+
+bool parseCompression(const std::string &Name, Log::Compression &Type) {
+  if (Name == "none") {
+    Type = Log::Compression::None;
+  } else if (Name == "zlib") {
+    Type = Log::Compression::Zlib;
+  } else if (Name == "gzip") {
+    Type = Log::Compression::Gzip;
+  } else {
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  using namespace Log;
+  std::string socketPath("/tmp/graylog_relay.sock");
+  std::string address("localhost");
+  std::string transport("tcp");
+  std::string spoolDirectory;
+  int port = 12201;
+  size_t queueSize = 100000;
+  CompressionSettings compression;
+  static struct option long_options[]{
+      {"help", no_argument, nullptr, 'h'},
+      {"socket", required_argument, nullptr, 's'},
+      {"address", required_argument, nullptr, 'a'},
+      {"port", required_argument, nullptr, 'p'},
+      {"transport", required_argument, nullptr, 't'},
+      {"compression", required_argument, nullptr, 'c'},
+      {"queue", required_argument, nullptr, 'q'},
+      {"spool", required_argument, nullptr, 'd'},
+      {nullptr, 0, nullptr, 0},
+  };
+  int option_index = 0;
+  while (true) {
+    int c = getopt_long(argc, argv, "hs:a:p:t:c:q:d:", long_options,
+                        &option_index);
+    if (c == -1) {
+      break;
+    }
+    try {
+      switch (c) {
+      case 's':
+        socketPath = optarg;
+        break;
+      case 'a':
+        address = optarg;
+        break;
+      case 'p':
+        port = std::stoi(optarg);
+        break;
+      case 't':
+        transport = optarg;
+        break;
+      case 'c':
+        if (not parseCompression(optarg, compression.Type)) {
+          std::cout << "Unknown compression \"" << optarg << "\".\n";
+          PrintAlternatives();
+          return 1;
+        }
+        break;
+      case 'q':
+        queueSize = std::stoul(optarg);
+        break;
+      case 'd':
+        spoolDirectory = optarg;
+        break;
+      default:
+        PrintAlternatives();
+        return c == 'h' ? 0 : 1;
+      }
+    } catch (std::logic_error &) {
+      std::cout << "Unable to parse the value of option -"
+                << static_cast<char>(c) << ".\n";
+      PrintAlternatives();
+      return 1;
+    }
+  }
+
+  // Block the termination signals in all threads (i.e. before any
+  // thread is created) and wait for them here.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  Upstream upstream;
+  if (transport == "tcp") {
+    ConnectionSettings settings;
+    settings.Spool.Directory = spoolDirectory;
+    upstream = makeUpstream(
+        new GraylogConnection(address, port, queueSize, settings));
+  } else if (transport == "udp") {
+    upstream = makeUpstream(
+        new GraylogUdpConnection(address, port, queueSize, 1420, compression));
+  } else if (transport == "http") {
+    HttpSettings settings;
+    settings.Compression = compression;
+    upstream = makeUpstream(
+        new GraylogHttpConnection(address, port, queueSize, settings));
+  } else {
+    std::cout << "Unknown transport \"" << transport << "\".\n";
+    PrintAlternatives();
+    return 1;
+  }
+
+  try {
+    RelayServer relay(socketPath, upstream.Send);
+    std::cout << "Relaying messages from \"" << socketPath << "\" to "
+              << address << ":" << port << " (" << transport << ").\n";
+    int signal{0};
+    sigwait(&signals, &signal);
+    std::cout << "Received " << relay.messagesReceived()
+              << " messages, discarded " << relay.messagesDiscarded()
+              << " messages.\n";
+  } catch (std::exception &e) {
+    std::cout << "Unable to listen on \"" << socketPath << "\": " << e.what()
+              << "\n";
+    return 1;
+  }
+  if (not upstream.Flush(std::chrono::seconds(5))) {
+    std::cout << "Reached timeout when trying to send messages to "
+                 "Graylog-server.\n";
+  }
+  return 0;
+}
+
+void PrintAlternatives() {
+  std::cout << "\nusage: graylog_relay [-h] [-s<socket>] [-a<address>] "
+               "[-p<port>]\n";
+  std::cout << "                     [-t<tcp|udp|http>] "
+               "[-c<none|zlib|gzip>] [-q<queue size>]\n";
+  std::cout << "                     [-d<spool directory>]\n\n";
+  std::cout << "Forwards the GELF messages written to the Unix domain socket "
+               "by local processes\n";
+  std::cout << "(using UnixSocketInterface) to a Graylog server using a single "
+               "connection. The\n";
+  std::cout << "default socket is \"/tmp/graylog_relay.sock\", the default "
+               "address is \"localhost\"\n";
+  std::cout << "and the default port is 12201. Compression applies to the udp "
+               "and http\n";
+  std::cout << "transports, the spool directory to the tcp transport.\n\n";
+  std::cout << "Example: ./graylog_relay -a graylog.example.com -t http -p "
+               "12202 -c gzip\n";
+}
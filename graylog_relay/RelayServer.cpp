@@ -0,0 +1,93 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the Unix domain socket relay server.
+///
+//===----------------------------------------------------------------------===//
+
+#include "RelayServer.hpp"
+#include <ciso646>
+#include <cstring>
+#include <unistd.h>
+
+namespace Log {
+
+RelayServer::RelayServer(std::string SocketPath, MessageHandler Handler,
+                         size_t MaxMessageSize)
+    : SocketPath(std::move(SocketPath)), Handler(std::move(Handler)),
+      MaxMessageSize(MaxMessageSize), Acceptor(Service) {
+  // Remove the socket of a previous instance.
+  unlink(this->SocketPath.c_str());
+  asio::local::stream_protocol::endpoint Endpoint(this->SocketPath);
+  Acceptor.open(Endpoint.protocol());
+  Acceptor.bind(Endpoint);
+  Acceptor.listen();
+  waitForClient();
+  RelayThread = std::thread([this]() { Service.run(); });
+}
+
+RelayServer::~RelayServer() {
+  Service.stop();
+  RelayThread.join();
+  unlink(SocketPath.c_str());
+}
+
+void RelayServer::waitForClient() {
+  auto NewClient = std::make_shared<Client>(Service);
+  Acceptor.async_accept(NewClient->Socket,
+                        [this, NewClient](const asio::error_code &Error) {
+                          if (Error) {
+                            return;
+                          }
+                          ++Clients;
+                          readFromClient(NewClient);
+                          waitForClient();
+                        });
+}
+
+void RelayServer::readFromClient(Client_P CClient) {
+  auto &Buffer = CClient->ReceiveBuffer;
+  CClient->Socket.async_read_some(
+      asio::buffer(Buffer),
+      [this, CClient](const asio::error_code &Error, std::size_t Size) {
+        if (Error) {
+          // A message without its terminating null byte is incomplete.
+          --Clients;
+          return;
+        }
+        handleData(*CClient, CClient->ReceiveBuffer.data(), Size);
+        readFromClient(CClient);
+      });
+}
+
+void RelayServer::handleData(Client &CClient, const char *Data, size_t Size) {
+  auto End = Data + Size;
+  while (Data < End) {
+    auto Terminator =
+        static_cast<const char *>(std::memchr(Data, '\0', End - Data));
+    auto MessageEnd = Terminator == nullptr ? End : Terminator;
+    if (not CClient.Discarding) {
+      if (CClient.Partial.size() + (MessageEnd - Data) > MaxMessageSize) {
+        CClient.Partial.clear();
+        CClient.Discarding = true;
+        ++MessagesDiscarded;
+      } else {
+        CClient.Partial.append(Data, MessageEnd);
+      }
+    }
+    if (Terminator == nullptr) {
+      return;
+    }
+    if (not CClient.Discarding and not CClient.Partial.empty()) {
+      ++MessagesReceived;
+      Handler(std::move(CClient.Partial));
+    }
+    CClient.Partial.clear();
+    CClient.Discarding = false;
+    Data = Terminator + 1;
+  }
+}
+
+} // namespace Log
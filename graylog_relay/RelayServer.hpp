@@ -0,0 +1,70 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Server accepting GELF messages from local processes over a Unix
+/// domain socket.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace Log {
+
+/// \brief Accepts null byte terminated GELF messages (as written by
+/// UnixSocketInterface) from any number of local clients and hands them to a
+/// single message handler, e.g. the sendMessage() function of a connection
+/// to the Graylog server.
+///
+/// All clients are served by one thread, on which the message handler is
+/// also called.
+class RelayServer {
+public:
+  using MessageHandler = std::function<void(std::string)>;
+  /// \param[in] SocketPath Path of the socket to listen on. An existing
+  /// file at this path is removed.
+  /// \param[in] Handler Called for every received message.
+  /// \param[in] MaxMessageSize Messages larger than this are discarded.
+  RelayServer(std::string SocketPath, MessageHandler Handler,
+              size_t MaxMessageSize = 8 * 1024 * 1024);
+  ~RelayServer();
+  size_t clientCount() const { return Clients.load(); }
+  size_t messagesReceived() const { return MessagesReceived.load(); }
+  size_t messagesDiscarded() const { return MessagesDiscarded.load(); }
+
+private:
+  struct Client {
+    explicit Client(asio::io_service &Service) : Socket(Service) {}
+    asio::local::stream_protocol::socket Socket;
+    std::array<char, 64 * 1024> ReceiveBuffer;
+    /// \brief Start of a message continuing in the next read.
+    std::string Partial;
+    bool Discarding{false};
+  };
+  using Client_P = std::shared_ptr<Client>;
+
+  void waitForClient();
+  void readFromClient(Client_P CClient);
+  void handleData(Client &CClient, const char *Data, size_t Size);
+
+  std::string SocketPath;
+  MessageHandler Handler;
+  size_t MaxMessageSize;
+  std::atomic<size_t> Clients{0};
+  std::atomic<size_t> MessagesReceived{0};
+  std::atomic<size_t> MessagesDiscarded{0};
+  asio::io_service Service;
+  asio::local::stream_protocol::acceptor Acceptor;
+  std::thread RelayThread;
+};
+
+} // namespace Log
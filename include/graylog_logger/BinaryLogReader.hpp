@@ -0,0 +1,88 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Reader of binary log files.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/LogUtil.hpp"
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Log {
+
+/// \brief Selects the messages read from a binary log file.
+struct BinaryLogQuery {
+  system_time From{system_time::min()};
+  system_time To{system_time::max()};
+  /// \brief Only messages of this severity or more severe are read.
+  Severity MinimumSeverity{Severity::Trace};
+};
+
+/// \brief Reads log files written by FileInterface using FileFormat::Binary.
+///
+/// If the file has an index (i.e. it was closed properly), only the blocks of
+/// messages that may match the query are read and decoded. Files without an
+/// index, e.g. while they are being written, are decoded from the start.
+class BinaryLogReader {
+public:
+  explicit BinaryLogReader(const std::string &Name);
+  BinaryLogReader(const BinaryLogReader &) = delete;
+  BinaryLogReader &operator=(const BinaryLogReader &) = delete;
+
+  /// \brief Could the file be opened and is it a binary log file?
+  bool isValid() const { return Valid; }
+
+  /// \brief Does the file end with an index?
+  bool hasIndex() const { return LastIndex != 0; }
+
+  /// \brief Call a function for every message matching the query, in the
+  /// order they are stored in the file.
+  /// \note The same message instance is reused for every call.
+  /// \return The number of messages matching the query.
+  size_t read(const BinaryLogQuery &Query,
+              const std::function<void(const LogMessage &)> &Callback);
+
+  /// \brief Call a function for every message in the file.
+  size_t read(const std::function<void(const LogMessage &)> &Callback) {
+    return read(BinaryLogQuery(), Callback);
+  }
+
+  /// \brief Number of bytes of the file read by the last call to read().
+  std::uint64_t bytesRead() const { return BytesRead; }
+
+private:
+  /// \brief Decode and filter the records in [Begin, End).
+  /// \param[in] DefineStrings If set, String records are added to the table
+  /// of strings and SegmentStart records clear it. Otherwise the table has
+  /// been read from the index.
+  size_t scan(std::uint64_t Begin, std::uint64_t End,
+              const BinaryLogQuery &Query,
+              const std::function<void(const LogMessage &)> &Callback,
+              bool DefineStrings);
+  /// \brief Read the record at Offset into Buffer.
+  /// \return Pointer to the body of the record; nullptr on failure.
+  const char *readRecord(std::uint64_t Offset, std::uint8_t &Type,
+                         size_t &Length);
+  /// \brief Read Size bytes at Offset into Buffer.
+  bool readAt(std::uint64_t Offset, size_t Size);
+
+  std::ifstream File;
+  std::uint64_t Size{0};
+  bool Valid{false};
+  std::uint64_t LastIndex{0};
+  /// \brief Data read from the file.
+  std::string Buffer;
+  std::vector<std::string> Strings;
+  LogMessage Message;
+  std::uint64_t BytesRead{0};
+};
+
+} // namespace Log
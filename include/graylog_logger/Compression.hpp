@@ -0,0 +1,53 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Settings and statistics of the compression of GELF payloads and
+/// log files.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Log {
+
+/// \brief Compression formats supported by the GELF UDP and HTTP inputs.
+enum class Compression {
+  None,
+  Zlib,
+  Gzip,
+};
+
+struct CompressionSettings {
+  Compression Type{Compression::None};
+  /// \brief zlib compression level, 1 (fastest) to 9 (best compression).
+  /// The default (-1) corresponds to level 6.
+  int Level{-1};
+  /// \brief Messages smaller than this (in bytes) are sent uncompressed as
+  /// the overhead of compressing them is not worth the gain.
+  size_t Threshold{256};
+};
+
+struct CompressionStatistics {
+  std::uint64_t MessagesCompressed{0};
+  std::uint64_t MessagesUncompressed{0};
+  /// \brief Size of the compressed messages before compression.
+  std::uint64_t BytesIn{0};
+  /// \brief Size of the compressed messages after compression.
+  std::uint64_t BytesOut{0};
+  /// \brief CPU time spent compressing messages.
+  std::chrono::nanoseconds CpuTime{0};
+
+  /// \brief Achieved compression ratio (uncompressed size divided by
+  /// compressed size) of the compressed messages.
+  double ratio() const {
+    return BytesOut == 0 ? 1.0 : double(BytesIn) / double(BytesOut);
+  }
+};
+
+} // namespace Log
@@ -0,0 +1,86 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Counters and histograms describing the behaviour of a connection
+/// to a Graylog server.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/ConnectionStatus.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Log {
+
+/// \brief Histogram with logarithmic (power of two) buckets. Bucket 0 counts
+/// the value 0, bucket i (i > 0) the values in the range [2^(i-1), 2^i). The
+/// last bucket also counts all larger values.
+struct Histogram {
+  static const size_t NrOfBuckets{32};
+  std::array<std::uint64_t, NrOfBuckets> Counts{};
+
+  /// \brief Total number of values recorded.
+  std::uint64_t count() const {
+    std::uint64_t Sum{0};
+    for (auto Count : Counts) {
+      Sum += Count;
+    }
+    return Sum;
+  }
+
+  /// \brief Upper limit (exclusive) of the bucket containing the given
+  /// fraction of the recorded values, e.g. 0.99 for the 99th percentile.
+  /// Returns 0 if no values have been recorded.
+  std::uint64_t percentile(double Fraction) const {
+    auto Total = count();
+    if (Total == 0) {
+      return 0;
+    }
+    auto Limit = static_cast<std::uint64_t>(Fraction * double(Total));
+    std::uint64_t Sum{0};
+    for (size_t i = 0; i < NrOfBuckets; ++i) {
+      Sum += Counts[i];
+      if (Sum > Limit or Sum == Total) {
+        return std::uint64_t(1) << i;
+      }
+    }
+    return std::uint64_t(1) << (NrOfBuckets - 1);
+  }
+};
+
+/// \brief Snapshot of the metrics of a Graylog connection.
+struct ConnectionMetrics {
+  /// \brief Messages and bytes (including the null byte terminating each
+  /// message) written to the sockets.
+  std::uint64_t MessagesSent{0};
+  std::uint64_t BytesSent{0};
+  /// \brief Messages dropped because the queue (and spool, if used) was
+  /// full.
+  std::uint64_t MessagesDropped{0};
+  /// \brief Number of times a connection to a server was re-established
+  /// after having been lost.
+  std::uint64_t Reconnects{0};
+  /// \brief Time spent in each state, indexed by Log::Status.
+  std::array<std::chrono::nanoseconds, 4> TimeInState{};
+  /// \brief Number of bytes written by each write to a socket.
+  Histogram WriteSizes;
+  /// \brief Time in microseconds from a message being queued until it has
+  /// been written to a socket.
+  Histogram Latency;
+  /// \brief Set if the instance the metrics were taken from shares a
+  /// connection that was created by another instance with a different queue
+  /// size or settings, which are used instead of its own.
+  bool SharedWithDifferentSettings{false};
+
+  std::chrono::nanoseconds timeIn(Status State) const {
+    return TimeInState[static_cast<size_t>(State)];
+  }
+};
+
+} // namespace Log
@@ -0,0 +1,102 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Optional settings of the Graylog (TCP) connection.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Log {
+
+/// \brief Settings of the on-disk spool used for storing messages while the
+/// Graylog server can not be reached.
+struct SpoolSettings {
+  /// \brief Directory of the spool files. The spool is disabled if empty,
+  /// and always on Windows.
+  /// Spool files left in the directory (e.g. after a crash) are sent once
+  /// a connection has been established. A directory must not be shared by
+  /// several connections.
+  std::string Directory;
+  /// \brief Maximum total size (in bytes) of the spool files. Messages are
+  /// dropped when the spool is full.
+  size_t MaxSize{256 * 1024 * 1024};
+  /// \brief Size (in bytes) at which a new spool file is started. Spool files
+  /// are deleted once all their messages have been sent.
+  size_t SegmentSize{16 * 1024 * 1024};
+  /// \brief Maximum number of spooled messages sent per second after the
+  /// connection has been re-established, in addition to new messages.
+  size_t DrainRate{2000};
+};
+
+struct ServerAddress {
+  std::string Host;
+  int Port;
+};
+
+/// \brief Exponential back-off of connection attempts. The delay before
+/// attempt n (counting from zero after the last successful connection) is
+/// min(InitialDelay * Multiplier^n, MaxDelay), randomly varied by +/- Jitter
+/// (a fraction of the delay) so that many clients do not reconnect at the
+/// same time.
+struct ReconnectSettings {
+  std::chrono::milliseconds InitialDelay{100};
+  std::chrono::milliseconds MaxDelay{10000};
+  double Multiplier{2.0};
+  double Jitter{0.2};
+};
+
+/// \brief Options of the TCP sockets, used for detecting dead connections.
+struct SocketSettings {
+  /// \brief Send TCP keep-alive probes after KeepAliveIdle of inactivity,
+  /// every KeepAliveInterval, and close the connection after KeepAliveProbes
+  /// unanswered probes.
+  bool KeepAlive{true};
+  std::chrono::seconds KeepAliveIdle{10};
+  std::chrono::seconds KeepAliveInterval{5};
+  int KeepAliveProbes{3};
+  /// \brief Maximum time that sent data may remain unacknowledged before
+  /// the connection is closed (TCP_USER_TIMEOUT, Linux only). Zero uses the
+  /// default of the operating system.
+  std::chrono::milliseconds UserTimeout{0};
+  /// \brief Disable Nagle's algorithm.
+  bool NoDelay{true};
+  /// \brief Size of the socket send buffer (SO_SNDBUF) in bytes. Zero uses
+  /// the default of the operating system.
+  int SendBufferSize{0};
+  /// \brief Close and re-open the connection if data is waiting to be
+  /// written but no bytes have been accepted by the socket for this long.
+  /// Zero disables the stall detection.
+  std::chrono::milliseconds StallTimeout{30000};
+};
+
+struct ConnectionSettings {
+  SpoolSettings Spool;
+  /// \brief Servers connected to in addition to the one given to the
+  /// constructor. Messages are sent to the connection with the fewest bytes
+  /// waiting to be sent. A server may be listed more than once to open
+  /// several connections to it.
+  std::vector<ServerAddress> AdditionalServers;
+  ReconnectSettings Reconnect;
+  /// \brief If true, flush() also waits for the send queues of the sockets
+  /// to drain, i.e. for the server to have acknowledged the receipt of all
+  /// data. Otherwise flush() returns once all messages have been handed over
+  /// to the operating system. Only supported on Linux (SIOCOUTQ).
+  bool FlushWaitsForAcknowledgement{false};
+  /// \brief If true, the thread of the connection is started and the address
+  /// of the server looked up when the first message is sent (or flush() is
+  /// called) rather than when the connection is created. Saves the start-up
+  /// cost in applications that might not log anything, at the expense of the
+  /// first messages being delayed (or spooled) until connected.
+  bool ConnectOnFirstUse{false};
+  SocketSettings Socket;
+};
+
+} // namespace Log
@@ -18,6 +18,9 @@ class ConsoleInterface : public BaseLogHandler {
 public:
   explicit ConsoleInterface();
   virtual ~ConsoleInterface() = default;
+  /// \note Also used for messages passed to addSharedMessage(), i.e. the
+  /// message is copied on the thread of the logger, so that subclasses
+  /// overriding this function keep receiving all messages.
   void addMessage(const LogMessage &Message) override;
   /// \brief Waits for all messages created before the call to flush to be
   /// printed and then flushes the output stream.
@@ -9,24 +9,201 @@
 
 #pragma once
 
+#include "graylog_logger/Compression.hpp"
 #include "graylog_logger/LogUtil.hpp"
 #include "graylog_logger/ThreadedExecutor.hpp"
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
 #include <string>
 
 namespace Log {
+class FileSyncer;
+class GzipFile;
+class LogFile;
+class SharedAppendFile;
+namespace BinaryLog {
+class Encoder;
+}
+class GelfSerializer;
 
+/// \brief How messages are stored in a log file.
+enum class FileFormat {
+  /// \brief One line of text per message.
+  Text,
+  /// \brief A compact binary format, with an index of the messages by time
+  /// and severity. Additional fields are kept. Read using BinaryLogReader or
+  /// the console_logger tool (--decode).
+  Binary,
+  /// \brief One JSON object per line (JSON lines) with all fields of the
+  /// message, in the format of GELF messages.
+  Json,
+};
+
+/// \brief When data written to a log file is forced to stable storage
+/// (using fdatasync()). By default, this is left to the operating system.
+///
+/// The policies can be combined. Syncs are made on a helper thread (or
+/// submitted to io_uring), i.e. the handler does not wait for them.
+struct DurabilityPolicy {
+  /// \brief Sync at most this long after data has been written. 0 disables.
+  std::chrono::milliseconds Interval{0};
+  /// \brief Sync after every this many messages. 0 disables.
+  size_t EveryNMessages{0};
+  /// \brief Write and sync messages of severity MinimumSeverity or more
+  /// severe immediately.
+  bool SyncOnSeverity{false};
+  Severity MinimumSeverity{Severity::Error};
+
+  /// \brief Is any of the policies enabled?
+  bool enabled() const {
+    return Interval.count() > 0 or EveryNMessages > 0 or SyncOnSeverity;
+  }
+};
+
+/// \brief Settings of a FileInterface.
+struct FileConfig {
+  /// \brief Name (path) of the log file. Messages are appended to it.
+  std::string Name;
+  /// \brief Size (in bytes) of the write buffer. Messages are formatted into
+  /// the buffer and written to the file when it is full, when there are no
+  /// more queued messages or when MaxFlushLatency has passed.
+  size_t BufferSize{1024 * 1024};
+  /// \brief Maximum amount of time a message may stay in the write buffer
+  /// while further messages keep arriving.
+  std::chrono::milliseconds MaxFlushLatency{100};
+  /// \brief Start a new file before the current one grows larger than this
+  /// (in bytes). Lines are never split between files. 0 disables size based
+  /// rotation.
+  /// \note Binary files are rotated before a message is added once they have
+  /// reached this size, i.e. they are slightly larger.
+  size_t MaxFileSize{0};
+  /// \brief Start a new file at every multiple of this interval since the
+  /// epoch, e.g. every hour on the hour (UTC). 0 disables time based
+  /// rotation.
+  std::chrono::seconds RotationInterval{0};
+  /// \brief Number of rotated files to keep. The oldest ones are deleted.
+  /// 0 keeps all rotated files.
+  size_t MaxRotatedFiles{10};
+  /// \brief Compress rotated files using gzip. Requires zlib. For shared
+  /// files, the file rotated last is only compressed after the next rotation,
+  /// as processes that have not noticed the rotation may still append to it.
+  bool CompressRotatedFiles{false};
+  /// \brief Compress the file (gzip) while writing it, on the thread of the
+  /// handler. Requires zlib and is not supported for binary files. Every
+  /// batch of messages can be decompressed as soon as it has been written,
+  /// also if the file is later cut short by a crash. MaxFileSize applies to
+  /// the compressed size, not including the end of the last frame written
+  /// when the file is closed.
+  /// \note Messages appended to a file that was not closed properly can not
+  /// be decompressed using gzip.
+  bool Compress{false};
+  /// \brief zlib compression level, 1 (fastest) to 9 (best compression).
+  /// The default (-1) corresponds to level 6.
+  int CompressionLevel{-1};
+  /// \brief Uncompressed size of the independent gzip members (frames) of a
+  /// compressed file.
+  size_t CompressionFrameSize{4 * 1024 * 1024};
+  /// \brief Several processes (or handlers) append to the file. Every batch
+  /// of messages is appended using a single write() of whole lines, the size
+  /// of the file is taken from the file system and only one of the processes
+  /// renames the file when it is rotated, the others continue with the new
+  /// file. Log files are then written as uncompressed text without io_uring.
+  /// Not supported on Windows and by MappedFileInterface.
+  bool SharedFile{false};
+  /// \brief For shared files, hold an advisory lock (flock()) while
+  /// appending more than PIPE_BUF bytes. Only needed for file systems that
+  /// do not serialise appends, e.g. some network file systems.
+  bool LockLargeWrites{false};
+  /// \brief Write to the file asynchronously using io_uring (Linux only).
+  /// Falls back to write() if io_uring is not available.
+  /// \note Only one process may write to the file in this mode.
+  bool UseIoUring{false};
+  /// \brief Number of batches of messages that may be written concurrently
+  /// when using io_uring.
+  size_t WritesInFlight{4};
+  /// \brief When to force data to stable storage. If any policy is enabled,
+  /// flush() and closing or rotating the file also sync the file.
+  DurabilityPolicy Durability{};
+  /// \brief Format of the file. Functions set using
+  /// setMessageStringCreatorFunction() are only used for text files.
+  /// \note Binary messages should not be appended to an existing text file.
+  FileFormat Format{FileFormat::Text};
+  /// \brief Maximum (approximate) size in bytes of the messages queued for
+  /// the handler, e.g. while the disk is slow. Messages arriving while the
+  /// queue is full are dropped and counted, see FileInterface::statistics().
+  /// 0 disables the limit.
+  size_t MaxQueuedBytes{64 * 1024 * 1024};
+  /// \brief File that messages are written to (e.g. on another file system)
+  /// while the log file can not be written to, e.g. because the disk is full
+  /// (ENOSPC) or because of an I/O error (EIO). If empty, the messages are
+  /// dropped and counted instead. The fallback file is not rotated.
+  /// \note The batch of binary messages being written when the failure
+  /// occurs is lost.
+  std::string FallbackName{};
+  /// \brief How often the log file is reopened after a failure. Messages
+  /// are written to it again once that, and writing the next batch of
+  /// messages, succeeds.
+  std::chrono::milliseconds RetryInterval{1000};
+};
+
+/// \brief Counters of a FileInterface, see FileInterface::statistics().
+struct FileStatistics {
+  /// \brief Messages dropped because the queue was full, see
+  /// FileConfig::MaxQueuedBytes.
+  std::uint64_t MessagesDroppedQueueFull{0};
+  /// \brief Messages (and their size in the file) dropped because they could
+  /// not be written to the log file or the fallback file.
+  std::uint64_t MessagesDroppedWriteFailed{0};
+  std::uint64_t BytesDropped{0};
+  /// \brief Number of failed writes (or opens), including failed retries.
+  std::uint64_t WriteErrors{0};
+  /// \brief errno of the last failed write; 0 if none.
+  int LastError{0};
+  /// \brief Messages are currently not written to the log file.
+  bool WriteFailed{false};
+  /// \brief Messages are currently written to the fallback file.
+  bool UsingFallback{false};
+  /// \brief Approximate size in bytes of the queued messages.
+  std::uint64_t QueuedBytes{0};
+};
+
+/// \brief Writes log messages to a file.
+///
+/// Messages are formatted directly into a reusable write buffer on the
+/// thread of the handler and written using a single write() per batch of
+/// messages.
+///
+/// If rotation is enabled, the file is renamed to "<Name>.<UTC time>" (see
+/// FileConfig) and a new file is started. Rotated files are compressed and
+/// old ones deleted on a low priority background thread.
+///
+/// The memory used by queued messages is bounded (MaxQueuedBytes). If writing
+/// to the file fails, messages are written to a fallback file or dropped
+/// until reopening the file succeeds, see FileConfig::FallbackName.
 class FileInterface : public BaseLogHandler {
 public:
-  explicit FileInterface(std::string const &Name,
-                         const size_t MaxQueueLength = 100);
+  /// \brief Log to the given file using the default FileConfig.
+  explicit FileInterface(std::string const &Name);
+  /// \deprecated The queue is limited in bytes rather than messages, use
+  /// FileConfig::MaxQueuedBytes instead. MaxQueueLength is ignored.
+  [[deprecated("MaxQueueLength is ignored, use FileConfig::MaxQueuedBytes")]]
+  FileInterface(std::string const &Name, size_t MaxQueueLength);
+  explicit FileInterface(FileConfig Config);
+  ~FileInterface() override;
   void addMessage(const LogMessage &Message) override;
 
+  /// \brief Queues the message without copying it.
+  void addSharedMessage(const LogMessage_P &Message) override;
+
   /// \brief Waits for all messages created before the call to flush to be
-  /// printed and then flushes the file stream.
+  /// written to the file.
   /// \param[in] TimeOut Amount of time to wait for messages to be written.
-  /// \return Returns true if queue was emptied and stream flushed before the
-  /// time out. Returns false otherwise.
+  /// \return Returns true if queue was emptied and the write buffer written
+  /// before the time out. Returns false otherwise, or if syncing the file
+  /// (or completing an asynchronous write) failed.
   bool flush(std::chrono::system_clock::duration TimeOut) override;
 
   /// \brief Are there any queued messages?
@@ -35,17 +212,92 @@ public:
   /// \return Returns true if message queue is empty.
   bool emptyQueue() override;
 
-  ///  \brief Number of queued messages.
+  ///  \brief Number of queued messages.
   ///  \return Due to multiple threads accessing this queue, shows approximate
   ///  number of messages in the queue.
   size_t queueSize() override;
 
+  /// \brief Compression ratio and CPU time used for compression, see
+  /// FileConfig::Compress. MessagesCompressed is the number of batches of
+  /// messages written.
+  CompressionStatistics compressionStatistics() const;
+
+  /// \brief Dropped messages and write errors. May be called from any thread.
+  FileStatistics statistics() const;
+
+  /// \brief Number of messages dropped, because the queue was full or
+  /// because they could not be written.
+  size_t messagesDropped() const;
+
   /// \brief See parent class for documentation.
   void setMessageStringCreatorFunction(
       std::function<std::string(const LogMessage &)> ParserFunction) override;
 
 protected:
-  std::ofstream FileStream;
+  /// \brief Use the given writer for the log file.
+  FileInterface(FileConfig Config, std::unique_ptr<LogFile> File);
+
+  /// \brief Format a message into the write buffer and write the buffer if
+  /// required.
+  void bufferMessage(const LogMessage &Message);
+  /// \brief Write the contents of the write buffer to the file, rotating it
+  /// when required.
+  void writeBuffer();
+  /// \brief Close the current file, rename it and open a new one.
+  /// \return False if the file is empty or could not be renamed.
+  bool rotate();
+  /// \brief Start syncing the data written so far without waiting for it.
+  void requestSync();
+  /// \brief Sync (if enabled by the durability policy) and close the file.
+  /// Binary files are finished by writing the index.
+  void closeFile();
+  /// \brief Open the file (the log file or the fallback file), starting a
+  /// new segment of binary files.
+  bool openFile(const std::string &Name);
+  /// \brief Close the file after a failed write and open the fallback file
+  /// if there is one and it was not the fallback file that failed.
+  void writeFailed();
+  /// \brief Close the fallback file (if open) and reopen the log file.
+  void retryFile();
+  /// \brief Count the messages in the write buffer from Offset as dropped.
+  void dropMessages(size_t Offset);
+
+  FileConfig Config;
+  std::unique_ptr<LogFile> File;
+  /// \brief Set if the file is compressed, owned by File.
+  GzipFile *Compressor{nullptr};
+  /// \brief Set if the file is shared with other processes, owned by File.
+  SharedAppendFile *Shared{nullptr};
+  /// \brief Only created if the durability policy is enabled.
+  std::unique_ptr<FileSyncer> Syncer;
+  /// \brief Only created for binary files.
+  std::unique_ptr<BinaryLog::Encoder> Encoder;
+  /// \brief Only created for JSON files.
+  std::unique_ptr<GelfSerializer> Serializer;
+  size_t MessagesSinceSync{0};
+  std::chrono::steady_clock::time_point LastSyncRequest;
+  std::chrono::system_clock::time_point NextRotation;
+  std::string WriteBuffer;
+  /// \brief When the oldest message in the write buffer was added.
+  std::chrono::steady_clock::time_point BufferedSince;
+  /// \brief The time stamp (to the second) of the previous message and its
+  /// string representation.
+  std::time_t CachedTime{-1};
+  std::string CachedTimeString;
+  /// \brief Number of messages in the write buffer.
+  size_t BufferedMessages{0};
+  /// \brief Set while the log file is not written to after a failure.
+  std::atomic<bool> WriteFailed{false};
+  std::atomic<bool> UsingFallback{false};
+  std::chrono::steady_clock::time_point NextRetry;
+  std::atomic<size_t> QueuedBytes{0};
+  std::atomic<std::uint64_t> MessagesDroppedQueueFull{0};
+  std::atomic<std::uint64_t> MessagesDroppedWriteFailed{0};
+  std::atomic<std::uint64_t> BytesDropped{0};
+  std::atomic<std::uint64_t> WriteErrors{0};
+  std::atomic<int> LastError{0};
+  /// \brief Compresses and deletes rotated files.
+  ThreadedExecutor BackgroundExecutor;
   ThreadedExecutor Executor; // Must be last
 };
 
@@ -0,0 +1,122 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Graylog-server interface using GELF over HTTP.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/Compression.hpp"
+#include "graylog_logger/ConnectionStatus.hpp"
+#include "graylog_logger/LogUtil.hpp"
+
+namespace Log {
+
+struct HttpSettings {
+  /// \brief Path of the GELF HTTP input.
+  std::string Path{"/gelf"};
+  /// \brief Maximum number of messages in the body of one request. Messages
+  /// are separated by newlines. Values larger than 1 require an input with
+  /// bulk receiving enabled.
+  size_t MaxMessagesPerRequest{100};
+  /// \brief Upper limit of the (uncompressed) size of a request body. A
+  /// single message larger than this is sent in a request of its own.
+  size_t MaxBytesPerRequest{1024 * 1024};
+  /// \brief Maximum number of requests sent before their responses have
+  /// been received (HTTP pipelining). Set to 1 to disable pipelining.
+  size_t MaxRequestsInFlight{4};
+  /// \brief Number of times a request is re-sent after a 5xx response
+  /// before its messages are dropped.
+  int MaxRetries{3};
+  /// \brief Time to wait for a response before the connection is considered
+  /// broken and re-established.
+  std::chrono::milliseconds ResponseTimeout{10000};
+  /// \brief Compression of the request bodies.
+  CompressionSettings Compression;
+  /// \brief If true, the thread of the connection is started and the address
+  /// of the server looked up when the first message is sent (or flush() is
+  /// called) rather than when the connection is created.
+  bool ConnectOnFirstUse{false};
+};
+
+/// \brief Sends GELF messages to a Graylog server using HTTP/1.1.
+///
+/// A single persistent (keep-alive) connection is used. Queued messages are
+/// sent in batches, several requests may be in flight at the same time and
+/// requests answered with a 5xx status code are retried.
+class GraylogHttpConnection {
+public:
+  using Status = Log::Status;
+  /// \param[in] Host Host name or address of the Graylog server.
+  /// \param[in] Port Port of the GELF HTTP input of the Graylog server.
+  /// \param[in] MaxQueueSize Maximum number of queued messages.
+  /// \param[in] Settings Batching, pipelining, retry and compression
+  /// settings.
+  GraylogHttpConnection(std::string Host, int Port, size_t MaxQueueSize,
+                        HttpSettings Settings = {});
+  virtual ~GraylogHttpConnection();
+  virtual void sendMessage(std::string Msg);
+  virtual Status getConnectionStatus() const;
+  virtual bool messageQueueEmpty();
+  virtual size_t messageQueueSize();
+  /// \brief Waits for all messages queued before the call to be accepted by
+  /// the server (or dropped after the maximum number of retries).
+  virtual bool flush(std::chrono::system_clock::duration TimeOut);
+
+  /// \brief Number of messages dropped because the queue was full or the
+  /// server rejected them.
+  size_t messagesDropped() const;
+
+  /// \brief Number of requests that have been re-sent.
+  size_t requestsRetried() const;
+
+  /// \brief Compression ratio and CPU time used for compression.
+  CompressionStatistics compressionStatistics() const;
+
+protected:
+  /// \brief Queue a message that is only converted to a string once it is
+  /// about to be transmitted.
+  void sendDeferredMessage(std::function<std::string(void)> MessageCreator);
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> Pimpl;
+};
+
+class GraylogHttpInterface : public BaseLogHandler,
+                             public GraylogHttpConnection {
+public:
+  GraylogHttpInterface(const std::string &Host, int Port,
+                       size_t MaxQueueLength = 1000,
+                       HttpSettings Settings = {});
+  ~GraylogHttpInterface() override;
+
+  /// \brief Serialises the message on the calling thread and queues it for
+  /// transmission.
+  void addMessage(const LogMessage &Message) override;
+
+  /// \brief Queues the message for transmission. The message is serialised
+  /// on the thread of the connection.
+  void addSharedMessage(const LogMessage_P &Message) override;
+
+  /// \brief Waits for all messages created before the call to flush to be
+  /// accepted by the server.
+  /// \param[in] TimeOut Amount of time to wait for messages to be transmitted.
+  /// \return Returns true if messages were transmitted before the time out.
+  /// Returns false otherwise.
+  bool flush(std::chrono::system_clock::duration TimeOut) override;
+
+  /// \brief Are there any queued messages?
+  /// \return Returns true if message queue is empty.
+  bool emptyQueue() override;
+
+  ///  \brief Number of queued messages.
+  ///  \return Due to multiple threads accessing this queue, shows approximate
+  ///  number of messages in the queue.
+  size_t queueSize() override;
+};
+
+} // namespace Log
@@ -9,40 +9,118 @@
 
 #pragma once
 
+#include "graylog_logger/ConnectionMetrics.hpp"
+#include "graylog_logger/ConnectionSettings.hpp"
 #include "graylog_logger/ConnectionStatus.hpp"
 #include "graylog_logger/LogUtil.hpp"
+#include <atomic>
+#include <functional>
+#include <vector>
 
 namespace Log {
+
+/// \brief Connection to a Graylog server.
+///
+/// All instances connecting to the same host and port share one transport,
+/// i.e. one thread, one message queue and one set of sockets. The transport
+/// is created with the queue size and settings of the first instance and is
+/// closed when the last instance using it is destroyed. Queue sizes and
+/// flush() therefore cover the messages of all instances sharing it. If a
+/// later instance asks for a different queue size or settings, its metrics()
+/// report SharedWithDifferentSettings.
 class GraylogConnection {
 public:
   using Status = Log::Status;
-  GraylogConnection(std::string Host, int Port, size_t MaxQueueSize);
+  /// \brief Called with the previous and the new state of the connection.
+  using StateChangeCallback = std::function<void(Status, Status)>;
+  /// \brief Runs the work it is given, e.g. on a thread of the application.
+  using CallbackExecutor = std::function<void(std::function<void()>)>;
+  GraylogConnection(std::string Host, int Port, size_t MaxQueueSize,
+                    ConnectionSettings Settings = {});
   virtual ~GraylogConnection();
   virtual void sendMessage(std::string Msg);
   virtual Status getConnectionStatus() const;
   virtual bool messageQueueEmpty();
   virtual size_t messageQueueSize();
+  /// \brief Waits for all messages queued before the call to have been
+  /// written to a socket (or, with
+  /// ConnectionSettings::FlushWaitsForAcknowledgement, acknowledged by the
+  /// server). Messages in the on-disk spool are not waited for.
+  /// \return False if this did not happen before the time out.
   virtual bool flush(std::chrono::system_clock::duration TimeOut);
 
+  /// \brief Stop accepting messages from this instance and wait for the
+  /// queued ones to be written, as flush() does.
+  /// \return The number of messages that had not been written to a socket
+  /// when the time out expired. Messages in the on-disk spool are kept there
+  /// and are not counted.
+  virtual ShutdownReport shutdown(std::chrono::system_clock::duration TimeOut);
+
+  /// \brief Size (in bytes) of the messages in the on-disk spool.
+  size_t spoolSize() const;
+
+  /// \brief Snapshot of the counters and histograms of the connection.
+  /// Cheap enough to be called frequently (e.g. once per second).
+  /// \note The metrics cover all instances sharing the connection.
+  ConnectionMetrics metrics() const;
+
+  /// \brief Register a function to be called when the state of the
+  /// connection (as returned by getConnectionStatus()) changes.
+  /// \param[in] Callback The function to call. Exceptions thrown by it are
+  /// ignored.
+  /// \param[in] Executor If set, the callback is handed to this function
+  /// instead of being called on the thread of the connection. Callbacks
+  /// called on the thread of the connection must not block.
+  /// \return Identifier used for removing the callback. Callbacks are removed
+  /// automatically when this instance is destroyed.
+  size_t addStateChangeCallback(StateChangeCallback Callback,
+                                CallbackExecutor Executor = nullptr);
+
+  /// \brief Remove a callback. A callback may still be called while it is
+  /// being removed if a state change is in progress.
+  void removeStateChangeCallback(size_t CallbackId);
+
+protected:
+  /// \brief Queue a message that is only converted to a string once it is
+  /// about to be transmitted, i.e. on the thread of the connection.
+  /// \param[in] MessageCreator Function returning the (non-empty) message.
+  void sendDeferredMessage(std::function<std::string(void)> MessageCreator);
+
 private:
   class Impl;
-  std::unique_ptr<Impl> Pimpl;
+  std::shared_ptr<Impl> Pimpl;
+  std::vector<size_t> CallbackIds;
+  std::atomic_bool ShutDown{false};
+  bool SettingsDiffer{false};
 };
 class GraylogInterface : public BaseLogHandler, public GraylogConnection {
 public:
   GraylogInterface(const std::string &Host, int Port,
-                   size_t MaxQueueLength = 1000);
-  ~GraylogInterface() override = default;
+                   size_t MaxQueueLength = 1000,
+                   ConnectionSettings Settings = {});
+  ~GraylogInterface() override;
+
+  /// \brief Serialises the message on the calling thread and queues it for
+  /// transmission.
   void addMessage(const LogMessage &Message) override;
+
+  /// \brief Queues the message for transmission. The message is serialised
+  /// on the thread of the connection and not on the thread calling this
+  /// function, unless the message is written to the spool.
+  void addSharedMessage(const LogMessage_P &Message) override;
   /// \brief Waits for all messages created before the call to flush to be
   /// transmitted.
   /// \param[in] TimeOut Amount of time to wait for messages to be transmitted.
   /// \return Returns true if messages were transmitted before the time out.
   /// Returns false otherwise.
-  /// \note It is possible (though unlikely) that not all log messages have
-  /// been transmitted even if flush() returns true.
+  /// \note Transmitted means handed over to the operating system unless
+  /// ConnectionSettings::FlushWaitsForAcknowledgement is set.
   bool flush(std::chrono::system_clock::duration TimeOut) override;
 
+  /// \brief See GraylogConnection::shutdown().
+  ShutdownReport
+  shutdown(std::chrono::system_clock::duration TimeOut) override;
+
   /// \brief Are there any queued messages?
   /// \note The message queue will show as empty before the last message in
   /// the queue has been transmitted.
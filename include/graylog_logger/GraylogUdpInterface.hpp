@@ -0,0 +1,104 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Graylog-server interface using GELF over UDP.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/Compression.hpp"
+#include "graylog_logger/ConnectionStatus.hpp"
+#include "graylog_logger/LogUtil.hpp"
+
+namespace Log {
+
+/// \brief Sends GELF messages to a Graylog server using UDP.
+///
+/// Messages that do not fit in a single datagram are split into GELF chunks.
+/// As GELF allows at most 128 chunks per message, messages larger than
+/// 128 * (MaxDatagramSize - 12) bytes are dropped. Where available
+/// (Linux), many datagrams are sent using a single sendmmsg() call.
+/// \note UDP is unreliable; messages may be lost without notice.
+class GraylogUdpConnection {
+public:
+  using Status = Log::Status;
+  /// \param[in] Host Host name or address of the Graylog server.
+  /// \param[in] Port Port of the GELF UDP input of the Graylog server.
+  /// \param[in] MaxQueueSize Maximum number of queued messages.
+  /// \param[in] MaxDatagramSize The maximum size of a datagram, including
+  /// the GELF chunk header. Should not exceed the path MTU minus the IP and
+  /// UDP headers.
+  /// \param[in] Compression Compression of the messages. Messages are
+  /// compressed before being split into chunks.
+  /// \param[in] ConnectOnFirstUse If true, the thread sending the messages
+  /// is started (and the address of the server looked up) when the first
+  /// message is sent or flush() is called rather than here.
+  GraylogUdpConnection(std::string Host, int Port, size_t MaxQueueSize,
+                       size_t MaxDatagramSize = 1420,
+                       CompressionSettings Compression = {},
+                       bool ConnectOnFirstUse = false);
+  virtual ~GraylogUdpConnection();
+  virtual void sendMessage(std::string Msg);
+  virtual Status getConnectionStatus() const;
+  virtual bool messageQueueEmpty();
+  virtual size_t messageQueueSize();
+  /// \brief Waits for all messages queued before the call to be handed over
+  /// to the operating system.
+  virtual bool flush(std::chrono::system_clock::duration TimeOut);
+
+  /// \brief Number of messages dropped because the queue was full, they
+  /// required more than the maximum number of chunks or could not be sent.
+  size_t messagesDropped() const;
+
+  /// \brief Compression ratio and CPU time used for compression.
+  CompressionStatistics compressionStatistics() const;
+
+protected:
+  /// \brief Queue a message that is only converted to a string once it is
+  /// about to be transmitted.
+  void sendDeferredMessage(std::function<std::string(void)> MessageCreator);
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> Pimpl;
+};
+
+class GraylogUdpInterface : public BaseLogHandler,
+                            public GraylogUdpConnection {
+public:
+  GraylogUdpInterface(const std::string &Host, int Port,
+                      size_t MaxQueueLength = 1000,
+                      size_t MaxDatagramSize = 1420,
+                      CompressionSettings Compression = {},
+                      bool ConnectOnFirstUse = false);
+  ~GraylogUdpInterface() override;
+
+  /// \brief Serialises the message on the calling thread and queues it for
+  /// transmission.
+  void addMessage(const LogMessage &Message) override;
+
+  /// \brief Queues the message for transmission. The message is serialised
+  /// on the thread of the connection.
+  void addSharedMessage(const LogMessage_P &Message) override;
+
+  /// \brief Waits for all messages created before the call to flush to be
+  /// transmitted.
+  /// \param[in] TimeOut Amount of time to wait for messages to be transmitted.
+  /// \return Returns true if messages were transmitted before the time out.
+  /// Returns false otherwise.
+  bool flush(std::chrono::system_clock::duration TimeOut) override;
+
+  /// \brief Are there any queued messages?
+  /// \return Returns true if message queue is empty.
+  bool emptyQueue() override;
+
+  ///  \brief Number of queued messages.
+  ///  \return Due to multiple threads accessing this queue, shows approximate
+  ///  number of messages in the queue.
+  size_t queueSize() override;
+};
+
+} // namespace Log
@@ -161,6 +161,28 @@ void Msg(
 bool Flush(std::chrono::system_clock::duration TimeOut =
                std::chrono::milliseconds(500));
 
+/// \brief Stop logging and deliver the queued messages of all log handlers.
+///
+/// Log messages created after the call are discarded. The log handlers are
+/// shut down in parallel.
+/// \param[in] TimeOut The maximum amount of time to spend on delivering the
+/// queued messages. Defaults to 500ms.
+/// \return Whether all messages were delivered and, if not, how many were
+/// not.
+ShutdownReport Shutdown(std::chrono::system_clock::duration TimeOut =
+                            std::chrono::milliseconds(500));
+
+/// \brief Call Shutdown() when the process exits (i.e. returns from main()
+/// or calls exit()).
+///
+/// Only registers one exit handler when called several times; the time out
+/// of the last call is used. Log handlers that have not finished shutting
+/// down by then are waited for when the logger is destroyed, i.e. during the
+/// destruction of static objects.
+/// \param[in] TimeOut Time out passed to Shutdown(). Defaults to 500ms.
+void ShutdownAtExit(std::chrono::system_clock::duration TimeOut =
+                        std::chrono::milliseconds(500));
+
 /// \brief Add a default field of meta-data to every message.
 ///
 /// It is possible to override the value of the default message by passing
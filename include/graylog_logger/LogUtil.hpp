@@ -101,6 +101,19 @@ struct LogMessage {
   }
 };
 
+/// \brief Shared, immutable log message. Used to hand a single instance of a
+/// message to several log handlers without copying it.
+using LogMessage_P = std::shared_ptr<const LogMessage>;
+
+/// \brief The outcome of shutting down a log handler or the logging system.
+struct ShutdownReport {
+  /// \brief True if all messages were delivered before the time out.
+  bool Completed{true};
+  /// \brief Number of messages that had not been delivered when the time out
+  /// expired. Might be approximate.
+  size_t UndeliveredMessages{0};
+};
+
 /// \brief The base class used to implement log message consumers.
 ///
 /// Inherit from this class when implementing your own log message handler.
@@ -117,12 +130,32 @@ public:
   /// \param[in] Message The log message.
   virtual void addMessage(const LogMessage &Message) = 0;
 
+  /// \brief Called by the logging library when a new log message is created.
+  ///
+  /// The same instance of the message is passed to all log handlers. The
+  /// default implementation calls addMessage(const LogMessage &). Override
+  /// this function in handlers that process messages on a separate thread in
+  /// order to hand over the message without copying it.
+  /// \param[in] Message Shared pointer to the log message.
+  virtual void addSharedMessage(const LogMessage_P &Message) {
+    addMessage(*Message);
+  }
+
   /// \brief Empty the queue of messages. Might do nothing. See documentation
   /// of derived classes for details.
   /// \param[in] TimeOut Amount of time to wait queue to empty.
   /// \return Returns true if queue was emptied before time out occurred.
   virtual bool flush(std::chrono::system_clock::duration TimeOut) = 0;
 
+  /// \brief Deliver the queued messages before the process exits.
+  ///
+  /// Called when the logging system is shut down, after which no more
+  /// messages are passed to the handler. The default implementation calls
+  /// flush() and reports the queue size if it times out.
+  /// \param[in] TimeOut Maximum amount of time to spend.
+  /// \return What could not be delivered.
+  virtual ShutdownReport shutdown(std::chrono::system_clock::duration TimeOut);
+
   /// \brief Are there messages in the queue?
   /// \note See derived classes for implementation details.
   /// \return true if there are no messages in the queue, otherwise
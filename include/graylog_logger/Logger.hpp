@@ -25,6 +25,7 @@ public:
   using LoggingBase::log;
   using LoggingBase::removeAllHandlers;
   using LoggingBase::setMinSeverity;
+  using LoggingBase::shutdown;
 #ifdef WITH_FMT
   using LoggingBase::fmt_log;
 #endif
@@ -22,6 +22,7 @@
 #include "graylog_logger/MinimalApply.hpp"
 #include <ciso646>
 #include <future>
+#include <mutex>
 #include <thread>
 
 namespace Log {
@@ -36,24 +37,23 @@ public:
   virtual void
   log(const Severity Level, const std::string &Message,
       const std::vector<std::pair<std::string, AdditionalField>> &ExtraFields) {
-    if (int(Level) > int(MinSeverity.load(std::memory_order_relaxed))) {
+    if (int(Level) > int(MinSeverity.load(std::memory_order_relaxed)) or
+        ShutDown.load(std::memory_order_relaxed)) {
       return;
     }
     auto ThreadId = std::this_thread::get_id();
     Executor.SendWork([=]() {
-      LogMessage cMsg(BaseMsg);
+      auto cMsg = std::make_shared<LogMessage>(baseMessage());
       for (auto &fld : ExtraFields) {
-        cMsg.addField(fld.first, fld.second);
+        cMsg->addField(fld.first, fld.second);
       }
-      cMsg.Timestamp = std::chrono::system_clock::now();
-      cMsg.MessageString = Message;
-      cMsg.SeverityLevel = Level;
+      cMsg->Timestamp = std::chrono::system_clock::now();
+      cMsg->MessageString = Message;
+      cMsg->SeverityLevel = Level;
       std::ostringstream ss;
       ss << ThreadId;
-      cMsg.ThreadId = ss.str();
-      for (auto &ptr : Handlers) {
-        ptr->addMessage(cMsg);
-      }
+      cMsg->ThreadId = ss.str();
+      dispatchMessage(std::move(cMsg));
     });
   }
   virtual void log(const Severity Level, const std::string &Message,
@@ -67,32 +67,31 @@ public:
 #ifdef WITH_FMT
   template <typename... Args>
   void fmt_log(const Severity Level, std::string Format, Args... args) {
-    if (int(Level) > int(MinSeverity.load(std::memory_order_relaxed))) {
+    if (int(Level) > int(MinSeverity.load(std::memory_order_relaxed)) or
+        ShutDown.load(std::memory_order_relaxed)) {
       return;
     }
     auto ThreadId = std::this_thread::get_id();
     auto UsedArguments = std::make_tuple(args...);
     Executor.SendWork([=]() {
-      LogMessage cMsg(BaseMsg);
-      cMsg.SeverityLevel = Level;
-      cMsg.Timestamp = std::chrono::system_clock::now();
+      auto cMsg = std::make_shared<LogMessage>(baseMessage());
+      cMsg->SeverityLevel = Level;
+      cMsg->Timestamp = std::chrono::system_clock::now();
       auto format_message = [&Format, &cMsg](const auto &...args) {
         try {
           return fmt::format(Format, args...);
         } catch (fmt::format_error &e) {
-          cMsg.SeverityLevel = Log::Severity::Error;
+          cMsg->SeverityLevel = Log::Severity::Error;
           return fmt::format("graylog-logger internal error. Unable to format "
                              "the string \"{}\". The error was: \"{}\".",
                              Format, e.what());
         }
       };
-      cMsg.MessageString = minimal::apply(format_message, UsedArguments);
+      cMsg->MessageString = minimal::apply(format_message, UsedArguments);
       std::ostringstream ss;
       ss << ThreadId;
-      cMsg.ThreadId = ss.str();
-      for (auto &ptr : Handlers) {
-        ptr->addMessage(cMsg);
-      }
+      cMsg->ThreadId = ss.str();
+      dispatchMessage(std::move(cMsg));
     });
   }
 #endif
@@ -130,10 +129,45 @@ public:
     return FlushCompletedValue.get();
   }
 
+  /// \brief Stop accepting messages and deliver the queued ones.
+  ///
+  /// Messages logged after the call are discarded. The handlers are shut down
+  /// in parallel and share the time out.
+  /// \param[in] TimeOut Maximum amount of time to spend. Might be exceeded
+  /// by a few milliseconds.
+  /// \return The combined report of the handlers. If the handlers do not
+  /// report back in time, Completed is false and the messages still queued
+  /// by them are counted as undelivered.
+  /// \note Handlers that are still shutting down when this function returns
+  /// are waited for when the logger is destroyed.
+  virtual ShutdownReport shutdown(std::chrono::system_clock::duration TimeOut);
+
 protected:
+  /// \brief The fields shared by all messages, including the host and
+  /// process information. Must only be called by the executor.
+  const LogMessage &baseMessage();
+
+  /// \brief Hand a message over to all the log handlers.
+  ///
+  /// Only the pointer to the message is passed on, i.e. the amount of work
+  /// done here per handler does not depend on the size of the message.
+  void dispatchMessage(LogMessage_P Message) {
+    for (auto &ptr : Handlers) {
+      ptr->addSharedMessage(Message);
+    }
+  }
+
   std::atomic<Severity> MinSeverity{Severity::Notice};
+  std::atomic_bool ShutDown{false};
   std::vector<LogHandler_P> Handlers;
+  /// \brief Held by the executor while changing Handlers and by other threads
+  /// while reading it.
+  std::mutex HandlersMutex;
   LogMessage BaseMsg;
+  bool HasProcessInfo{false};
+  /// \brief The threads running the shutdown of the handlers. Only used by
+  /// the executor.
+  std::vector<std::thread> ShutdownThreads;
   ThreadedExecutor Executor;
 };
 
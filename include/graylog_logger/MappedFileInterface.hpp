@@ -0,0 +1,39 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Log file handler writing through a memory mapping.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/FileInterface.hpp"
+
+namespace Log {
+
+/// \brief Writes log messages to a file by copying them into a memory mapped
+/// region of the file.
+///
+/// Works like FileInterface (including rotation), except that batches of
+/// messages are copied into a shared mapping of the file instead of being
+/// written using write(). The file is extended and a new region mapped
+/// ChunkSize bytes at a time; writeback is left to the kernel. The file is
+/// truncated to the length of its contents when closed or rotated.
+/// \note Until then, the file contains zero bytes following the last
+/// message. Only one process (and handler) may write to the file. As the
+/// zero bytes left by a process that did not close the file are removed when
+/// it is reopened, binary and compressed (FileConfig::Compress) log files are
+/// not supported; text is written instead.
+class MappedFileInterface : public FileInterface {
+public:
+  /// \param[in] Config Name of the file and rotation settings.
+  /// \param[in] ChunkSize Number of bytes by which the file is extended and
+  /// the size of the mapped region. Rounded up to a multiple of the page
+  /// size.
+  explicit MappedFileInterface(FileConfig Config,
+                               size_t ChunkSize = 64 * 1024 * 1024);
+};
+
+} // namespace Log
@@ -14,6 +14,7 @@
 #include <future>
 #include <memory>
 #include <moodycamel/concurrentqueue.h>
+#include <mutex>
 #include <thread>
 
 namespace Log {
@@ -21,12 +22,20 @@ class ThreadedExecutor {
 private:
 public:
   using WorkMessage = std::function<void()>;
-  ThreadedExecutor() : WorkerThread(ThreadFunction) {}
+  ThreadedExecutor() = default;
   ~ThreadedExecutor() {
-    SendWork([=]() { RunThread = false; });
-    WorkerThread.join();
+    if (WorkerThread.joinable()) {
+      SendWork([=]() { RunThread = false; });
+      WorkerThread.join();
+    }
+  }
+  /// \brief Queue work. The worker thread is started by the first call so
+  /// that executors that are never used do not cost a thread.
+  void SendWork(WorkMessage Message) {
+    std::call_once(ThreadStarted,
+                   [this]() { WorkerThread = std::thread(ThreadFunction); });
+    MessageQueue.enqueue(Message);
   }
-  void SendWork(WorkMessage Message) { MessageQueue.enqueue(Message); }
   size_t size_approx() { return MessageQueue.size_approx(); }
 
 private:
@@ -43,6 +52,7 @@ private:
     }
   }};
   moodycamel::ConcurrentQueue<WorkMessage> MessageQueue;
+  std::once_flag ThreadStarted;
   std::thread WorkerThread;
 };
 
@@ -0,0 +1,73 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Log handler sending GELF messages to a local relay over a Unix
+/// domain socket.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/LogUtil.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace Log {
+class GelfSerializer;
+
+/// \brief Sends GELF messages to a graylog_relay process on the same host.
+///
+/// Messages are serialised and written to a Unix domain (stream) socket
+/// directly on the thread of the logger, terminated by a null byte as on a
+/// GELF TCP connection. No thread, queue or TCP connection is created per
+/// handler; batching, compression and re-connection to the Graylog server
+/// are left to the relay. Writes never block: messages are dropped (and
+/// counted) if the relay is not running or can not keep up.
+/// \note Only available on POSIX systems.
+class UnixSocketInterface : public BaseLogHandler {
+public:
+  /// \param[in] SocketPath Path of the socket the relay is listening on.
+  explicit UnixSocketInterface(std::string SocketPath);
+  ~UnixSocketInterface() override;
+
+  void addMessage(const LogMessage &Message) override;
+
+  /// \brief Tries to write the remainder of a partially written message.
+  /// \return True if no data is waiting to be written.
+  bool flush(std::chrono::system_clock::duration TimeOut) override;
+
+  /// \brief Messages are written immediately, i.e. there is no queue.
+  /// \return True unless part of a message is waiting to be written.
+  bool emptyQueue() override;
+
+  /// \return 1 if part of a message is waiting to be written, otherwise 0.
+  size_t queueSize() override;
+
+  /// \brief Is there a connection to the relay?
+  bool isConnected() const;
+
+  /// \brief Number of messages dropped because there was no connection to
+  /// the relay or its socket buffer was full.
+  size_t messagesDropped() const { return MessagesDropped.load(); }
+
+private:
+  bool connectSocket();
+  void closeSocket();
+  /// \brief Write as much of the pending data as possible.
+  /// \return False if the connection failed.
+  bool writePending();
+
+  std::string SocketPath;
+  mutable std::mutex SocketMutex;
+  int Socket{-1};
+  std::chrono::steady_clock::time_point NextConnectAttempt;
+  std::unique_ptr<GelfSerializer> Serializer;
+  /// \brief Serialised message being written.
+  std::string Buffer;
+  size_t BytesWritten{0};
+  std::atomic<size_t> MessagesDropped{0};
+};
+
+} // namespace Log
@@ -12,5 +12,5 @@
 // This code is here instead of in the header file to prevent the compiler
 // from optimising the code away.
 void DummyLogHandler::addMessage(const Log::LogMessage &Message) {
-  Executor.SendWork([=]() {});
+  Executor.SendWork([=]() { ++MessagesHandled; });
 }
\ No newline at end of file
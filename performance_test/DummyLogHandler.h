@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <graylog_logger/LogUtil.hpp>
 #include <graylog_logger/ThreadedExecutor.hpp>
 
@@ -19,7 +20,9 @@ public:
   bool emptyQueue() override { return true; }
   size_t queueSize() override { return 0; }
   bool flush(std::chrono::system_clock::duration) override { return true; }
+  size_t messagesHandled() const { return MessagesHandled.load(); }
 
 private:
+  std::atomic<size_t> MessagesHandled{0};
   Log::ThreadedExecutor Executor;
 };
\ No newline at end of file
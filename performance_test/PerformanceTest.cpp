@@ -8,11 +8,30 @@
 //===----------------------------------------------------------------------===//
 
 #include "DummyLogHandler.h"
+#include "GelfCompressor.hpp"
+#include "GelfSerializer.hpp"
 #include <benchmark/benchmark.h>
+#include <cstdio>
 #include <fmt/format.h>
+#include <fstream>
+#include <graylog_logger/BinaryLogReader.hpp>
+#include <graylog_logger/FileInterface.hpp>
+#include <graylog_logger/GraylogInterface.hpp>
+#include <graylog_logger/LibConfig.hpp>
 #include <graylog_logger/LoggingBase.hpp>
 #include <random>
 
+#ifndef _WIN32
+#include "RelayServer.hpp"
+#include <arpa/inet.h>
+#include <graylog_logger/MappedFileInterface.hpp>
+#include <graylog_logger/UnixSocketInterface.hpp>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 static void BM_LogMessageGenerationOnly(benchmark::State &state) {
   Log::LoggingBase Logger;
   for (auto _ : state) {
@@ -113,4 +132,426 @@ static void BM_GraylogWithFmtAndSeverityLvl(benchmark::State &state) {
 }
 BENCHMARK(BM_GraylogWithFmtAndSeverityLvl);
 
+#ifndef _WIN32
+// Measures how fast messages are delivered to a fast sink, with (argument 1)
+// and without (argument 0) a GraylogInterface attached to the same logger
+// whose server accepts the connection but never reads from it. Messages are
+// only serialised when the connection sends them, so the stalled connection
+// should not slow down the delivery to the fast sink.
+static void BM_FastSinkDeliveryWithStalledGraylog(benchmark::State &state) {
+  // Connections are accepted by the kernel (backlog) but never read from.
+  auto Listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in Address{};
+  Address.sin_family = AF_INET;
+  Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t AddressLength = sizeof(Address);
+  if (bind(Listener, reinterpret_cast<sockaddr *>(&Address), AddressLength) !=
+          0 or
+      listen(Listener, 1) != 0 or
+      getsockname(Listener, reinterpret_cast<sockaddr *>(&Address),
+                  &AddressLength) != 0) {
+    state.SkipWithError("Unable to create the stalled server.");
+    close(Listener);
+    return;
+  }
+  Log::LoggingBase Logger;
+  auto FastHandler = std::make_shared<DummyLogHandler>();
+  Logger.addLogHandler(FastHandler);
+  std::shared_ptr<Log::GraylogInterface> StalledHandler;
+  if (state.range(0) != 0) {
+    StalledHandler = std::make_shared<Log::GraylogInterface>(
+        "127.0.0.1", ntohs(Address.sin_port), 1000000);
+    Logger.addLogHandler(StalledHandler);
+  }
+  const size_t MessagesPerIteration{10000};
+  size_t MessagesSent{0};
+  for (auto _ : state) {
+    for (size_t i = 0; i < MessagesPerIteration; ++i) {
+      Logger.log(Log::Severity::Error, "Some message.");
+    }
+    MessagesSent += MessagesPerIteration;
+    while (FastHandler->messagesHandled() < MessagesSent) {
+      std::this_thread::yield();
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(MessagesSent));
+  if (StalledHandler) {
+    state.counters["StalledBacklog"] =
+        static_cast<double>(StalledHandler->queueSize());
+  }
+  Logger.removeAllHandlers();
+  close(Listener);
+}
+BENCHMARK(BM_FastSinkDeliveryWithStalledGraylog)
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime();
+#endif
+
+// Compresses a typical GELF message at the zlib compression level given by
+// the argument and reports the achieved ratio and CPU time per message.
+static void BM_GelfCompression(benchmark::State &state) {
+  Log::LogMessage Message;
+  Message.Host = "some-daq-node.esss.lu.se";
+  Message.ProcessName = "some_data_acquisition_process";
+  Message.ProcessId = 4242;
+  Message.ThreadId = "0x7f0011aacc00";
+  Message.SeverityLevel = Log::Severity::Warning;
+  Message.MessageString = "Timeout while waiting for detector readout data "
+                          "from module 12, retrying (attempt 3 of 5).";
+  Message.addField("instrument", std::string("some_instrument"));
+  Message.addField("run_number", std::int64_t(12345));
+  auto Serialised = Log::GelfSerializer().serialize(Message);
+  Log::GelfCompressor Compressor(
+      {Log::Compression::Gzip, static_cast<int>(state.range(0)), 0});
+  std::string Out;
+  for (auto _ : state) {
+    Compressor.compress(Serialised, Out);
+    benchmark::DoNotOptimize(Out.data());
+  }
+  auto Statistics = Compressor.statistics();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(Serialised.size()));
+  state.counters["Ratio"] = Statistics.ratio();
+  state.counters["CpuNsPerMessage"] =
+      double(Statistics.CpuTime.count()) /
+      double(std::max<std::uint64_t>(1, Statistics.MessagesCompressed));
+}
+BENCHMARK(BM_GelfCompression)->Arg(1)->Arg(6)->Arg(9);
+
+// Cost of taking a snapshot of the metrics of a Graylog connection.
+static void BM_GraylogConnectionMetrics(benchmark::State &state) {
+  Log::GraylogConnection Connection("localhost", 12201, 100);
+  for (auto _ : state) {
+    auto Metrics = Connection.metrics();
+    benchmark::DoNotOptimize(Metrics);
+  }
+}
+BENCHMARK(BM_GraylogConnectionMetrics);
+
+// Start-up (and tear-down) cost of a logger that is never used (Arg 0) or
+// used for a single message (Arg 1).
+static void BM_LoggerStartup(benchmark::State &state) {
+  for (auto _ : state) {
+    Log::LoggingBase Logger;
+    if (state.range(0) == 1) {
+      Logger.addLogHandler(std::make_shared<DummyLogHandler>());
+      Logger.log(Log::Severity::Error, "Some message.");
+      Logger.flush(std::chrono::seconds(1));
+    }
+  }
+}
+BENCHMARK(BM_LoggerStartup)->Arg(0)->Arg(1)->UseRealTime();
+
+// Start-up cost of a Graylog connection that is never used, connecting
+// immediately (Arg 0) or on first use (Arg 1).
+static void BM_GraylogConnectionStartup(benchmark::State &state) {
+  Log::ConnectionSettings Settings;
+  Settings.ConnectOnFirstUse = state.range(0) == 1;
+  int Port{20000};
+  for (auto _ : state) {
+    // Different ports, as connections to the same server are shared.
+    Log::GraylogConnection Connection("localhost", Port++, 100, Settings);
+  }
+}
+BENCHMARK(BM_GraylogConnectionStartup)->Arg(0)->Arg(1)->UseRealTime();
+
+static void runFileSinkBenchmark(benchmark::State &state,
+                                 Log::FileInterface &Sink) {
+  Log::LogMessage Message;
+  Message.Timestamp = std::chrono::system_clock::now();
+  Message.Host = "some_host";
+  Message.SeverityLevel = Log::Severity::Error;
+  Message.MessageString = "A typical log message of about this length.";
+  auto SharedMessage = std::make_shared<const Log::LogMessage>(Message);
+  const size_t MessagesPerIteration{100000};
+  for (auto _ : state) {
+    for (size_t i = 0; i < MessagesPerIteration; ++i) {
+      Sink.addSharedMessage(SharedMessage);
+    }
+    Sink.flush(std::chrono::seconds(60));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() *
+                                               MessagesPerIteration));
+}
+
+// Rate at which a file sink writes lines to a local file, with a write
+// buffer of the size (in bytes) given by the argument.
+static void BM_FileInterfaceThroughput(benchmark::State &state) {
+  const std::string FileName{"file_interface_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.BufferSize = static_cast<size_t>(state.range(0));
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+  }
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_FileInterfaceThroughput)
+    ->Arg(4096)
+    ->Arg(1024 * 1024)
+    ->UseRealTime();
+
+// Cost of the durability policies of the file sink. The first argument
+// selects the policy: none, fdatasync every 100 ms, every 1000 messages,
+// every 100 messages or every message (severity based). The second argument
+// enables io_uring.
+static void BM_FileInterfaceDurability(benchmark::State &state) {
+  const std::string FileName{"file_interface_durability_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  switch (state.range(0)) {
+  case 1:
+    Config.Durability.Interval = std::chrono::milliseconds(100);
+    break;
+  case 2:
+    Config.Durability.EveryNMessages = 1000;
+    break;
+  case 3:
+    Config.Durability.EveryNMessages = 100;
+    break;
+  case 4:
+    Config.Durability.SyncOnSeverity = true;
+    Config.Durability.MinimumSeverity = Log::Severity::Error;
+    break;
+  default:
+    break;
+  }
+  Config.UseIoUring = state.range(1) != 0;
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+  }
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_FileInterfaceDurability)
+    ->ArgsProduct({{0, 1, 2, 3, 4}, {0, 1}})
+    ->UseRealTime();
+
+// Rate at which a file sink writes messages as text (argument 0), in the
+// binary format (argument 1) or as JSON lines (argument 2), and the
+// resulting bytes per message.
+static void BM_FileInterfaceFormat(benchmark::State &state) {
+  const std::string FileName{"file_interface_format_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.Format = static_cast<Log::FileFormat>(state.range(0));
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+  }
+  std::ifstream File(FileName, std::ios::binary | std::ios::ate);
+  state.counters["BytesPerMessage"] =
+      static_cast<double>(File.tellg()) / state.items_processed();
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_FileInterfaceFormat)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+
+// Rate at which a file sink writes messages uncompressed (argument 0) or
+// compressed while writing at the zlib level given by the argument, and the
+// resulting compression ratio.
+static void BM_FileInterfaceCompression(benchmark::State &state) {
+  const std::string FileName{"file_interface_compression_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.Compress = state.range(0) != 0;
+  Config.CompressionLevel = static_cast<int>(state.range(0));
+  Log::CompressionStatistics Statistics;
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+    Statistics = Sink.compressionStatistics();
+  }
+  state.counters["CompressionRatio"] = Statistics.ratio();
+  state.counters["CompressionNsPerMessage"] =
+      static_cast<double>(Statistics.CpuTime.count()) /
+      state.items_processed();
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_FileInterfaceCompression)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(6)
+    ->UseRealTime();
+
+// Rate at which messages are decoded from a binary log file of one million
+// messages (one per millisecond), reading all of them (argument 0) or using
+// the index to read those from one second (argument 1).
+static void BM_BinaryLogReader(benchmark::State &state) {
+  const std::string FileName{"binary_log_reader_benchmark.log"};
+  std::remove(FileName.c_str());
+  const int NrOfMessages{1000000};
+  auto Start = std::chrono::system_clock::now();
+  {
+    Log::FileConfig Config{FileName};
+    Config.Format = Log::FileFormat::Binary;
+    Log::FileInterface Sink(Config);
+    Log::LogMessage Message;
+    Message.Host = "some_host";
+    Message.SeverityLevel = Log::Severity::Error;
+    Message.MessageString = "A typical log message of about this length.";
+    for (int i = 0; i < NrOfMessages; ++i) {
+      Message.Timestamp = Start + std::chrono::milliseconds(i);
+      Sink.addMessage(Message);
+    }
+  }
+  Log::BinaryLogQuery Query;
+  if (state.range(0) != 0) {
+    Query.From = Start + std::chrono::seconds(500);
+    Query.To = Query.From + std::chrono::seconds(1);
+  }
+  Log::BinaryLogReader Reader(FileName);
+  size_t Messages{0};
+  for (auto _ : state) {
+    Messages += Reader.read(Query, [](const Log::LogMessage &Message) {
+      benchmark::DoNotOptimize(Message.MessageString.data());
+    });
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(Messages));
+  state.SetBytesProcessed(
+      static_cast<int64_t>(state.iterations() * Reader.bytesRead()));
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_BinaryLogReader)->Arg(0)->Arg(1);
+
+#ifdef HAVE_IO_URING
+// As BM_FileInterfaceThroughput, but writing asynchronously using io_uring.
+static void BM_IoUringFileInterfaceThroughput(benchmark::State &state) {
+  const std::string FileName{"io_uring_file_interface_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.BufferSize = static_cast<size_t>(state.range(0));
+  Config.UseIoUring = true;
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+  }
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_IoUringFileInterfaceThroughput)
+    ->Arg(4096)
+    ->Arg(1024 * 1024)
+    ->UseRealTime();
+#endif
+
+#ifdef __linux__
+// Rate at which a file sink handles messages while the disk is full
+// (/dev/full), dropping them (argument 0) or writing them to a fallback file
+// (argument 1).
+static void BM_FileInterfaceDiskFull(benchmark::State &state) {
+  const std::string FallbackName{"file_interface_fallback_benchmark.log"};
+  std::remove(FallbackName.c_str());
+  Log::FileConfig Config{"/dev/full"};
+  if (state.range(0) != 0) {
+    Config.FallbackName = FallbackName;
+  }
+  {
+    Log::FileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+    state.counters["Dropped"] = static_cast<double>(Sink.messagesDropped());
+  }
+  std::remove(FallbackName.c_str());
+}
+BENCHMARK(BM_FileInterfaceDiskFull)->Arg(0)->Arg(1)->UseRealTime();
+#endif
+
+#ifndef _WIN32
+// As BM_FileInterfaceThroughput, but copying the lines into a memory mapping
+// of the file instead of calling write().
+static void BM_MappedFileInterfaceThroughput(benchmark::State &state) {
+  const std::string FileName{"mapped_file_interface_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.BufferSize = static_cast<size_t>(state.range(0));
+  {
+    Log::MappedFileInterface Sink(Config);
+    runFileSinkBenchmark(state, Sink);
+  }
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_MappedFileInterfaceThroughput)
+    ->Arg(4096)
+    ->Arg(1024 * 1024)
+    ->UseRealTime();
+#endif
+
+#ifndef _WIN32
+// Combined rate at which the number of processes given by the first
+// argument append lines to a shared log file. The second argument enables
+// the advisory lock for writes larger than PIPE_BUF.
+static void BM_SharedFileProcesses(benchmark::State &state) {
+  const std::string FileName{"shared_file_benchmark.log"};
+  std::remove(FileName.c_str());
+  Log::FileConfig Config{FileName};
+  Config.SharedFile = true;
+  Config.LockLargeWrites = state.range(1) != 0;
+  const auto NrOfProcesses = static_cast<int>(state.range(0));
+  const int MessagesPerProcess{100000};
+  Log::LogMessage Original;
+  Original.Timestamp = std::chrono::system_clock::now();
+  Original.Host = "some_host";
+  Original.SeverityLevel = Log::Severity::Error;
+  Original.MessageString = "A typical log message of about this length.";
+  auto Message = std::make_shared<const Log::LogMessage>(Original);
+  for (auto _ : state) {
+    std::vector<pid_t> Children;
+    for (int p = 0; p < NrOfProcesses; ++p) {
+      auto Child = fork();
+      if (Child == 0) {
+        {
+          Log::FileInterface Sink(Config);
+          for (int i = 0; i < MessagesPerProcess; ++i) {
+            Sink.addSharedMessage(Message);
+          }
+        }
+        _exit(0);
+      }
+      Children.push_back(Child);
+    }
+    for (auto Child : Children) {
+      waitpid(Child, nullptr, 0);
+    }
+  }
+  state.SetItemsProcessed(
+      static_cast<int64_t>(state.iterations() * NrOfProcesses *
+                           MessagesPerProcess));
+  std::remove(FileName.c_str());
+}
+BENCHMARK(BM_SharedFileProcesses)
+    ->ArgsProduct({{1, 4}, {0, 1}})
+    ->Iterations(3)
+    ->UseRealTime();
+#endif
+
+#ifndef _WIN32
+// Many local clients (one per benchmark thread, standing in for one process
+// each) sending messages to a single relay. Measures the cost of handing a
+// message to the relay, i.e. serialisation and one write to a Unix socket.
+static void BM_RelayManyClients(benchmark::State &state) {
+  static std::atomic<size_t> MessagesRelayed{0};
+  static Log::RelayServer Relay("graylog_relay_benchmark.sock",
+                                [](std::string) { ++MessagesRelayed; });
+  Log::UnixSocketInterface Client("graylog_relay_benchmark.sock");
+  Log::LogMessage Message;
+  Message.Host = "some-daq-node.esss.lu.se";
+  Message.ProcessName = "some_data_acquisition_process";
+  Message.SeverityLevel = Log::Severity::Info;
+  Message.MessageString = "Processed a batch of detector readout data.";
+  for (auto _ : state) {
+    Client.addMessage(Message);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["Dropped"] =
+      benchmark::Counter(static_cast<double>(Client.messagesDropped()),
+                         benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_RelayManyClients)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(40)
+    ->UseRealTime();
+#endif
+
 BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Lock-free histogram used for collecting metrics.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/ConnectionMetrics.hpp"
+#include <atomic>
+
+namespace Log {
+
+/// \brief Histogram which can be updated and read concurrently. See
+/// Histogram for the bucket layout.
+class AtomicHistogram {
+public:
+  void record(std::uint64_t Value) {
+    size_t Bucket{0};
+    while (Value != 0 and Bucket < Histogram::NrOfBuckets - 1) {
+      Value >>= 1;
+      ++Bucket;
+    }
+    Counts[Bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Histogram snapshot() const {
+    Histogram Result;
+    for (size_t i = 0; i < Histogram::NrOfBuckets; ++i) {
+      Result.Counts[i] = Counts[i].load(std::memory_order_relaxed);
+    }
+    return Result;
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, Histogram::NrOfBuckets> Counts{};
+};
+
+} // namespace Log
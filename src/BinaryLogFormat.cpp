@@ -0,0 +1,346 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the binary log file format.
+///
+//===----------------------------------------------------------------------===//
+
+#include "BinaryLogFormat.hpp"
+#include <algorithm>
+#include <array>
+#include <ciso646>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace Log {
+namespace BinaryLog {
+
+namespace {
+/// \brief Marks an unused entry of Encoder::PreviousStrings.
+const std::uint64_t NoString{std::numeric_limits<std::uint64_t>::max()};
+} // namespace
+
+void appendVarint(std::string &Out, std::uint64_t Value) {
+  while (Value >= 0x80) {
+    Out.push_back(static_cast<char>((Value & 0x7f) | 0x80));
+    Value >>= 7;
+  }
+  Out.push_back(static_cast<char>(Value));
+}
+
+void appendSignedVarint(std::string &Out, std::int64_t Value) {
+  appendVarint(Out, (static_cast<std::uint64_t>(Value) << 1) ^
+                        static_cast<std::uint64_t>(Value >> 63));
+}
+
+void appendFixed64(std::string &Out, std::uint64_t Value) {
+  std::array<char, 8> Bytes{};
+  for (size_t i = 0; i < Bytes.size(); ++i) {
+    Bytes[i] = static_cast<char>(Value >> (8 * i));
+  }
+  Out.append(Bytes.data(), Bytes.size());
+}
+
+void appendBytes(std::string &Out, const std::string &Value) {
+  appendVarint(Out, Value.size());
+  Out.append(Value);
+}
+
+std::uint64_t Decoder::varint() {
+  std::uint64_t Value{0};
+  for (unsigned Shift = 0; Shift < 64; Shift += 7) {
+    if (Current == End) {
+      fail();
+      return 0;
+    }
+    auto Byte = static_cast<std::uint8_t>(*Current++);
+    Value |= std::uint64_t(Byte & 0x7f) << Shift;
+    if ((Byte & 0x80) == 0) {
+      return Value;
+    }
+  }
+  fail();
+  return 0;
+}
+
+std::int64_t Decoder::signedVarint() {
+  auto Value = varint();
+  return static_cast<std::int64_t>(Value >> 1) ^
+         -static_cast<std::int64_t>(Value & 1);
+}
+
+std::uint64_t Decoder::fixed64() {
+  if (End - Current < 8) {
+    fail();
+    return 0;
+  }
+  std::uint64_t Value{0};
+  for (size_t i = 0; i < 8; ++i) {
+    Value |= std::uint64_t(static_cast<std::uint8_t>(Current[i])) << (8 * i);
+  }
+  Current += 8;
+  return Value;
+}
+
+std::uint8_t Decoder::byte() {
+  if (Current == End) {
+    fail();
+    return 0;
+  }
+  return static_cast<std::uint8_t>(*Current++);
+}
+
+const char *Decoder::bytesView(size_t &Length) {
+  auto Size = varint();
+  if (Size > static_cast<std::uint64_t>(End - Current)) {
+    fail();
+    Length = 0;
+    return Current;
+  }
+  auto Start = Current;
+  Length = static_cast<size_t>(Size);
+  Current += Length;
+  return Start;
+}
+
+std::string Decoder::bytes() {
+  size_t Length{0};
+  auto Start = bytesView(Length);
+  return {Start, Length};
+}
+
+bool decodeIndex(const char *Body, size_t Size, SegmentIndex &Index) {
+  Decoder Input(Body, Size);
+  Index.SegmentStart = Input.varint();
+  Index.PreviousIndex = Input.varint();
+  auto NrOfStrings = Input.varint();
+  Index.Strings.clear();
+  for (std::uint64_t i = 0; i < NrOfStrings and Input.good(); ++i) {
+    Index.Strings.push_back(Input.bytes());
+  }
+  auto NrOfEntries = Input.varint();
+  Index.Entries.clear();
+  for (std::uint64_t i = 0; i < NrOfEntries and Input.good(); ++i) {
+    IndexEntry Entry;
+    Entry.Offset = Input.varint();
+    Entry.MinTimestamp = static_cast<std::int64_t>(Input.fixed64());
+    Entry.MaxTimestamp = static_cast<std::int64_t>(Input.fixed64());
+    Entry.MostSevere = Input.byte();
+    Entry.Messages = Input.varint();
+    Index.Entries.push_back(Entry);
+  }
+  return Input.good();
+}
+
+namespace {
+bool lookUp(const std::vector<std::string> &Strings, std::uint64_t Id,
+            std::string &Value) {
+  if (Id >= Strings.size()) {
+    return false;
+  }
+  Value.assign(Strings[Id]);
+  return true;
+}
+} // namespace
+
+bool decodeMessage(const char *Body, size_t Size,
+                   const std::vector<std::string> &Strings,
+                   LogMessage &Message) {
+  Decoder Input(Body, Size);
+  auto Timestamp = static_cast<std::int64_t>(Input.fixed64());
+  Message.Timestamp = system_time(
+      std::chrono::duration_cast<system_time::duration>(
+          std::chrono::nanoseconds(Timestamp)));
+  Message.SeverityLevel = static_cast<Severity>(Input.byte());
+  Message.ProcessId = static_cast<int>(Input.signedVarint());
+  bool Known = lookUp(Strings, Input.varint(), Message.Host) and
+               lookUp(Strings, Input.varint(), Message.ProcessName) and
+               lookUp(Strings, Input.varint(), Message.ThreadId);
+  size_t Length{0};
+  auto MessageString = Input.bytesView(Length);
+  Message.MessageString.assign(MessageString, Length);
+  auto NrOfFields = Input.varint();
+  Message.AdditionalFields.resize(std::min<std::uint64_t>(NrOfFields, 1024));
+  for (auto &Field : Message.AdditionalFields) {
+    Known = lookUp(Strings, Input.varint(), Field.first) and Known;
+    Field.second = AdditionalField();
+    Field.second.FieldType = static_cast<AdditionalField::Type>(Input.byte());
+    switch (Field.second.FieldType) {
+    case AdditionalField::Type::typeStr:
+      Field.second.strVal = Input.bytes();
+      break;
+    case AdditionalField::Type::typeInt:
+      Field.second.intVal = Input.signedVarint();
+      break;
+    case AdditionalField::Type::typeDbl: {
+      auto Bits = Input.fixed64();
+      std::memcpy(&Field.second.dblVal, &Bits, sizeof(Bits));
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return Input.good() and Known;
+}
+
+std::uint64_t decodeTrailer(const char *Data) {
+  if (Data[0] != static_cast<char>(RecordType::Trailer) or
+      Data[1] != static_cast<char>(TrailerSize - 2) or
+      TrailerMagic.compare(0, TrailerMagic.size(), Data + 10,
+                           TrailerMagic.size()) != 0) {
+    return 0;
+  }
+  Decoder Input(Data + 2, 8);
+  return Input.fixed64();
+}
+
+std::uint64_t lastIndexOffset(const std::string &FileName) {
+  std::ifstream File(FileName, std::ios::binary | std::ios::ate);
+  if (not File or File.tellg() < static_cast<std::streamoff>(TrailerSize)) {
+    return 0;
+  }
+  std::array<char, TrailerSize> Trailer{};
+  File.seekg(-static_cast<std::streamoff>(TrailerSize), std::ios::end);
+  if (not File.read(Trailer.data(), Trailer.size())) {
+    return 0;
+  }
+  return decodeTrailer(Trailer.data());
+}
+
+void Encoder::appendRecord(std::string &Out, RecordType Type,
+                           const std::string &RecordBody) {
+  Out.push_back(static_cast<char>(Type));
+  appendVarint(Out, RecordBody.size());
+  Out.append(RecordBody);
+}
+
+void Encoder::startSegment(std::string &Out, std::uint64_t OutOffset,
+                           std::uint64_t PreviousIndex) {
+  Index = SegmentIndex();
+  Index.SegmentStart = OutOffset + Out.size();
+  Index.PreviousIndex = PreviousIndex;
+  StringIds.clear();
+  PreviousStrings.fill({std::string(), NoString});
+  BlockBytes = 0;
+  appendRecord(Out, RecordType::SegmentStart, SegmentMagic);
+}
+
+std::uint64_t Encoder::internString(const std::string &Value,
+                                    std::string &Out) {
+  auto Found = StringIds.find(Value);
+  if (Found != StringIds.end()) {
+    return Found->second;
+  }
+  auto Id = static_cast<std::uint64_t>(Index.Strings.size());
+  Index.Strings.push_back(Value);
+  StringIds.emplace(Value, Id);
+  Body.clear();
+  appendBytes(Body, Value);
+  appendRecord(Out, RecordType::String, Body);
+  return Id;
+}
+
+std::uint64_t Encoder::internString(const std::string &Value,
+                                    std::string &Out, size_t Field) {
+  auto &Previous = PreviousStrings[Field];
+  if (Previous.second == NoString or Previous.first != Value) {
+    Previous.first = Value;
+    Previous.second = internString(Value, Out);
+  }
+  return Previous.second;
+}
+
+void Encoder::encode(const LogMessage &Message, std::string &Out,
+                     std::uint64_t OutOffset) {
+  auto const RecordStart = Out.size();
+  auto const Timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             Message.Timestamp.time_since_epoch())
+                             .count();
+  auto const Level = static_cast<std::uint8_t>(Message.SeverityLevel);
+  if (Index.Entries.empty() or
+      Index.Entries.back().Messages >= MaxMessagesPerBlock or
+      BlockBytes >= MaxBytesPerBlock) {
+    IndexEntry Entry;
+    Entry.Offset = OutOffset + Out.size();
+    Entry.MinTimestamp = Entry.MaxTimestamp = Timestamp;
+    Entry.MostSevere = Level;
+    Index.Entries.push_back(Entry);
+    BlockBytes = 0;
+  }
+  auto &Entry = Index.Entries.back();
+  Entry.MinTimestamp = std::min(Entry.MinTimestamp, Timestamp);
+  Entry.MaxTimestamp = std::max(Entry.MaxTimestamp, Timestamp);
+  Entry.MostSevere = std::min(Entry.MostSevere, Level);
+  ++Entry.Messages;
+
+  // Strings are defined before the message record refers to them.
+  auto const HostId = internString(Message.Host, Out, 0);
+  auto const ProcessNameId = internString(Message.ProcessName, Out, 1);
+  auto const ThreadIdId = internString(Message.ThreadId, Out, 2);
+  KeyIds.clear();
+  for (auto &Field : Message.AdditionalFields) {
+    KeyIds.push_back(internString(Field.first, Out));
+  }
+
+  Body.clear();
+  appendFixed64(Body, static_cast<std::uint64_t>(Timestamp));
+  Body.push_back(static_cast<char>(Level));
+  appendSignedVarint(Body, Message.ProcessId);
+  appendVarint(Body, HostId);
+  appendVarint(Body, ProcessNameId);
+  appendVarint(Body, ThreadIdId);
+  appendBytes(Body, Message.MessageString);
+  appendVarint(Body, Message.AdditionalFields.size());
+  for (size_t i = 0; i < Message.AdditionalFields.size(); ++i) {
+    auto &Field = Message.AdditionalFields[i].second;
+    appendVarint(Body, KeyIds[i]);
+    Body.push_back(static_cast<char>(Field.FieldType));
+    switch (Field.FieldType) {
+    case AdditionalField::Type::typeStr:
+      appendBytes(Body, Field.strVal);
+      break;
+    case AdditionalField::Type::typeInt:
+      appendSignedVarint(Body, Field.intVal);
+      break;
+    case AdditionalField::Type::typeDbl: {
+      std::uint64_t Bits{0};
+      std::memcpy(&Bits, &Field.dblVal, sizeof(Bits));
+      appendFixed64(Body, Bits);
+      break;
+    }
+    }
+  }
+  appendRecord(Out, RecordType::Message, Body);
+  BlockBytes += Out.size() - RecordStart;
+}
+
+void Encoder::finishSegment(std::string &Out, std::uint64_t OutOffset) {
+  auto const IndexOffset = OutOffset + Out.size();
+  Body.clear();
+  appendVarint(Body, Index.SegmentStart);
+  appendVarint(Body, Index.PreviousIndex);
+  appendVarint(Body, Index.Strings.size());
+  for (auto &String : Index.Strings) {
+    appendBytes(Body, String);
+  }
+  appendVarint(Body, Index.Entries.size());
+  for (auto &Entry : Index.Entries) {
+    appendVarint(Body, Entry.Offset);
+    appendFixed64(Body, static_cast<std::uint64_t>(Entry.MinTimestamp));
+    appendFixed64(Body, static_cast<std::uint64_t>(Entry.MaxTimestamp));
+    Body.push_back(static_cast<char>(Entry.MostSevere));
+    appendVarint(Body, Entry.Messages);
+  }
+  appendRecord(Out, RecordType::Index, Body);
+  Body.clear();
+  appendFixed64(Body, IndexOffset);
+  Body.append(TrailerMagic);
+  appendRecord(Out, RecordType::Trailer, Body);
+}
+
+} // namespace BinaryLog
+} // namespace Log
@@ -0,0 +1,172 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief The binary log file format.
+///
+/// A binary log file is a sequence of records, each consisting of a type
+/// byte, the length of the body (as a varint) and the body. Readers skip
+/// records of unknown types. A zero type byte marks the end of the data.
+///
+/// Each writer (i.e. each time the file is opened) starts a new segment with
+/// a SegmentStart record. Keys, host names, process names and thread ids are
+/// interned: a String record assigns the next id of the segment to a string
+/// before a Message record first refers to it. When the file is closed, an
+/// Index record (with all strings of the segment and the time range and the
+/// most severe message of each block of messages) and a fixed size Trailer
+/// record pointing to it are written, so that readers can seek to the blocks
+/// matching a query.
+///
+/// Integers are stored as (LEB128) varints, signed values zigzag encoded.
+/// Time stamps are nanoseconds since the epoch, stored as 8 byte little
+/// endian integers.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/LogUtil.hpp"
+#include <array>
+#include <ciso646>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Log {
+
+namespace BinaryLog {
+enum class RecordType : std::uint8_t {
+  End = 0,
+  SegmentStart = 1,
+  String = 2,
+  Message = 3,
+  Index = 4,
+  Trailer = 5,
+};
+
+/// \brief Body of the SegmentStart record: magic bytes and format version.
+const std::string SegmentMagic{"GLLB\x01", 5};
+/// \brief Magic bytes at the end of the Trailer record.
+const std::string TrailerMagic{"GLLBIDX1"};
+/// \brief Size of the Trailer record: type, length, index offset, magic.
+const size_t TrailerSize{2 + 8 + 8};
+/// \brief Maximum number of messages in a block of the index.
+const size_t MaxMessagesPerBlock{1024};
+/// \brief A new block of the index is started after this many bytes.
+const size_t MaxBytesPerBlock{64 * 1024};
+
+/// \brief A block of records of the index.
+struct IndexEntry {
+  /// \brief File offset of the first record of the block.
+  std::uint64_t Offset{0};
+  std::int64_t MinTimestamp{0};
+  std::int64_t MaxTimestamp{0};
+  /// \brief Most severe (lowest) severity level of the messages.
+  std::uint8_t MostSevere{0};
+  std::uint64_t Messages{0};
+};
+
+/// \brief The contents of an Index record.
+struct SegmentIndex {
+  std::uint64_t SegmentStart{0};
+  /// \brief Offset of the Index record of the previous segment of the file;
+  /// 0 if none.
+  std::uint64_t PreviousIndex{0};
+  std::vector<std::string> Strings;
+  std::vector<IndexEntry> Entries;
+};
+
+void appendVarint(std::string &Out, std::uint64_t Value);
+void appendSignedVarint(std::string &Out, std::int64_t Value);
+void appendFixed64(std::string &Out, std::uint64_t Value);
+void appendBytes(std::string &Out, const std::string &Value);
+
+/// \brief Reads values from a buffer, failing (and staying failed) on reads
+/// beyond the end.
+class Decoder {
+public:
+  Decoder(const char *Data, size_t Size) : Current(Data), End(Data + Size) {}
+  std::uint64_t varint();
+  std::int64_t signedVarint();
+  std::uint64_t fixed64();
+  std::uint8_t byte();
+  /// \brief A length prefixed string.
+  std::string bytes();
+  /// \brief Skip a length prefixed string, returning a pointer to it.
+  const char *bytesView(size_t &Length);
+  bool good() const { return Good; }
+  bool atEnd() const { return Current == End; }
+  const char *position() const { return Current; }
+
+private:
+  bool fail() {
+    Good = false;
+    Current = End;
+    return false;
+  }
+  const char *Current;
+  const char *End;
+  bool Good{true};
+};
+
+/// \brief Decode the body of an Index record.
+bool decodeIndex(const char *Body, size_t Size, SegmentIndex &Index);
+
+/// \brief Decode the body of a Message record.
+/// \param[in] Strings The interned strings of the segment.
+bool decodeMessage(const char *Body, size_t Size,
+                   const std::vector<std::string> &Strings,
+                   LogMessage &Message);
+
+/// \brief Decode a Trailer record (TrailerSize bytes).
+/// \return The offset of the Index record; 0 if Data is not a Trailer record.
+std::uint64_t decodeTrailer(const char *Data);
+
+/// \brief Offset of the Index record referred to by the Trailer record at the
+/// end of the file; 0 if the file does not end with a Trailer record.
+std::uint64_t lastIndexOffset(const std::string &FileName);
+
+/// \brief Encodes log messages into the records of a segment of a binary log
+/// file and keeps track of the strings and the index of the segment.
+class Encoder {
+public:
+  /// \brief Start a new segment.
+  /// \param[out] Out Buffer the records are appended to.
+  /// \param[in] OutOffset File offset of the first byte of Out.
+  /// \param[in] PreviousIndex Offset of the Index record of the previous
+  /// segment in the file, see lastIndexOffset().
+  void startSegment(std::string &Out, std::uint64_t OutOffset,
+                    std::uint64_t PreviousIndex);
+  void encode(const LogMessage &Message, std::string &Out,
+              std::uint64_t OutOffset);
+  /// \brief Append the Index and Trailer records of the segment.
+  void finishSegment(std::string &Out, std::uint64_t OutOffset);
+  /// \brief Does the segment contain any messages?
+  bool hasMessages() const { return not Index.Entries.empty(); }
+
+private:
+  std::uint64_t internString(const std::string &Value, std::string &Out);
+  /// \brief As internString(), but first compares the string with the
+  /// previous one of the same field (e.g. the host name), which usually is
+  /// the same, to avoid hashing it.
+  std::uint64_t internString(const std::string &Value, std::string &Out,
+                             size_t Field);
+  void appendRecord(std::string &Out, RecordType Type,
+                    const std::string &Body);
+
+  SegmentIndex Index;
+  std::unordered_map<std::string, std::uint64_t> StringIds;
+  /// \brief Bytes of the current block of the index.
+  std::uint64_t BlockBytes{0};
+  /// \brief The previous host name, process name and thread id and their
+  /// ids.
+  std::array<std::pair<std::string, std::uint64_t>, 3> PreviousStrings;
+  /// \brief Reused buffers for the body of a record and the ids of keys.
+  std::string Body;
+  std::vector<std::uint64_t> KeyIds;
+};
+} // namespace BinaryLog
+
+} // namespace Log
@@ -0,0 +1,206 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the reader of binary log files.
+///
+//===----------------------------------------------------------------------===//
+
+#include "graylog_logger/BinaryLogReader.hpp"
+#include "BinaryLogFormat.hpp"
+#include <algorithm>
+#include <ciso646>
+#include <limits>
+
+namespace Log {
+
+using namespace BinaryLog;
+
+namespace {
+/// \brief Data is read from the file in chunks of this size when scanning.
+const size_t ScanChunkSize{1024 * 1024};
+
+/// \brief Maximum size of the type and length of a record.
+const size_t MaxRecordHeaderSize{1 + 10};
+
+std::int64_t toNanoseconds(system_time Time) {
+  if (Time == system_time::min()) {
+    return std::numeric_limits<std::int64_t>::min();
+  }
+  if (Time == system_time::max()) {
+    return std::numeric_limits<std::int64_t>::max();
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Time.time_since_epoch())
+      .count();
+}
+
+bool matches(const LogMessage &Message, const BinaryLogQuery &Query) {
+  return Message.Timestamp >= Query.From and Message.Timestamp <= Query.To and
+         int(Message.SeverityLevel) <= int(Query.MinimumSeverity);
+}
+} // namespace
+
+BinaryLogReader::BinaryLogReader(const std::string &Name)
+    : File(Name, std::ios::binary | std::ios::ate) {
+  if (not File) {
+    return;
+  }
+  Size = static_cast<std::uint64_t>(File.tellg());
+  std::uint8_t Type{0};
+  size_t Length{0};
+  auto Body = readRecord(0, Type, Length);
+  Valid = Body != nullptr and
+          Type == static_cast<std::uint8_t>(RecordType::SegmentStart) and
+          SegmentMagic.compare(0, SegmentMagic.size(), Body, Length) == 0;
+  if (Valid and Size >= TrailerSize and
+      readAt(Size - TrailerSize, TrailerSize)) {
+    LastIndex = decodeTrailer(Buffer.data());
+  }
+}
+
+bool BinaryLogReader::readAt(std::uint64_t Offset, size_t Size) {
+  Buffer.resize(Size);
+  File.clear();
+  File.seekg(static_cast<std::streamoff>(Offset));
+  File.read(&Buffer[0], static_cast<std::streamsize>(Size));
+  BytesRead += static_cast<std::uint64_t>(File.gcount());
+  return static_cast<size_t>(File.gcount()) == Size;
+}
+
+const char *BinaryLogReader::readRecord(std::uint64_t Offset,
+                                        std::uint8_t &Type, size_t &Length) {
+  if (Offset >= Size or
+      not readAt(Offset, static_cast<size_t>(std::min<std::uint64_t>(
+                             MaxRecordHeaderSize, Size - Offset)))) {
+    return nullptr;
+  }
+  Decoder Input(Buffer.data(), Buffer.size());
+  Type = Input.byte();
+  auto BodyLength = Input.varint();
+  auto HeaderSize = static_cast<size_t>(Input.position() - Buffer.data());
+  if (not Input.good() or BodyLength > Size - Offset - HeaderSize or
+      not readAt(Offset + HeaderSize, static_cast<size_t>(BodyLength))) {
+    return nullptr;
+  }
+  Length = static_cast<size_t>(BodyLength);
+  return Buffer.data();
+}
+
+size_t BinaryLogReader::read(
+    const BinaryLogQuery &Query,
+    const std::function<void(const LogMessage &)> &Callback) {
+  BytesRead = 0;
+  if (not Valid) {
+    return 0;
+  }
+  // Follow the chain of indices from the last segment to the first one.
+  std::vector<std::pair<std::uint64_t, SegmentIndex>> Segments;
+  auto IndexOffset = LastIndex;
+  while (IndexOffset != 0) {
+    std::uint8_t Type{0};
+    size_t Length{0};
+    auto Body = readRecord(IndexOffset, Type, Length);
+    SegmentIndex Index;
+    if (Body == nullptr or
+        Type != static_cast<std::uint8_t>(RecordType::Index) or
+        not decodeIndex(Body, Length, Index) or
+        Index.SegmentStart >= IndexOffset or
+        (Index.PreviousIndex != 0 and
+         Index.PreviousIndex >= Index.SegmentStart)) {
+      Segments.clear();
+      break;
+    }
+    Segments.emplace_back(IndexOffset, std::move(Index));
+    IndexOffset = Segments.back().second.PreviousIndex;
+  }
+  if (Segments.empty()) {
+    return scan(0, Size, Query, Callback, true);
+  }
+  std::reverse(Segments.begin(), Segments.end());
+
+  // Segments written before the first indexed one (e.g. by a process that
+  // did not close the file) are scanned sequentially.
+  size_t Matches = scan(0, Segments.front().second.SegmentStart, Query,
+                        Callback, true);
+  auto const From = toNanoseconds(Query.From);
+  auto const To = toNanoseconds(Query.To);
+  for (auto &Segment : Segments) {
+    auto &Entries = Segment.second.Entries;
+    Strings = std::move(Segment.second.Strings);
+    for (size_t i = 0; i < Entries.size(); ++i) {
+      auto &Entry = Entries[i];
+      if (Entry.MaxTimestamp < From or Entry.MinTimestamp > To or
+          Entry.MostSevere > int(Query.MinimumSeverity)) {
+        continue;
+      }
+      auto End = i + 1 < Entries.size() ? Entries[i + 1].Offset : Segment.first;
+      Matches += scan(Entry.Offset, End, Query, Callback, false);
+    }
+  }
+  return Matches;
+}
+
+size_t BinaryLogReader::scan(
+    std::uint64_t Begin, std::uint64_t End, const BinaryLogQuery &Query,
+    const std::function<void(const LogMessage &)> &Callback,
+    bool DefineStrings) {
+  size_t Matches{0};
+  End = std::min(End, Size);
+  Buffer.clear();
+  File.clear();
+  File.seekg(static_cast<std::streamoff>(Begin));
+  // File offset of the first byte of Buffer that has not been decoded.
+  auto Position = Begin;
+  size_t Start{0};
+  while (Position < End) {
+    Decoder Input(Buffer.data() + Start, Buffer.size() - Start);
+    auto Type = static_cast<RecordType>(Input.byte());
+    size_t Length{0};
+    auto Body = Input.bytesView(Length);
+    if (not Input.good()) {
+      // The record is incomplete, read more of the file.
+      auto Available = Position + (Buffer.size() - Start);
+      if (Available >= End) {
+        break;
+      }
+      Buffer.erase(0, Start);
+      Start = 0;
+      auto OldSize = Buffer.size();
+      auto Chunk = static_cast<size_t>(
+          std::min<std::uint64_t>(ScanChunkSize, End - Available));
+      Buffer.resize(OldSize + Chunk);
+      File.read(&Buffer[OldSize], static_cast<std::streamsize>(Chunk));
+      auto Read = static_cast<size_t>(File.gcount());
+      BytesRead += Read;
+      Buffer.resize(OldSize + Read);
+      if (Read == 0) {
+        break;
+      }
+      continue;
+    }
+    if (Type == RecordType::End) {
+      break;
+    }
+    if (Type == RecordType::Message) {
+      if (decodeMessage(Body, Length, Strings, Message) and
+          matches(Message, Query)) {
+        Callback(Message);
+        ++Matches;
+      }
+    } else if (Type == RecordType::String and DefineStrings) {
+      Decoder String(Body, Length);
+      Strings.push_back(String.bytes());
+    } else if (Type == RecordType::SegmentStart and DefineStrings) {
+      Strings.clear();
+    }
+    auto RecordSize = static_cast<size_t>(Input.position() -
+                                          (Buffer.data() + Start));
+    Start += RecordSize;
+    Position += RecordSize;
+  }
+  return Matches;
+}
+
+} // namespace Log
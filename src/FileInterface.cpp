@@ -8,30 +8,438 @@
 //===----------------------------------------------------------------------===//
 
 #include "graylog_logger/FileInterface.hpp"
+#include "BinaryLogFormat.hpp"
+#include "FileRotation.hpp"
+#include "FileSyncer.hpp"
+#include "GelfSerializer.hpp"
+#include "LogFile.hpp"
 #include "graylog_logger/Log.hpp"
+#include <algorithm>
+#include <array>
 #include <ciso646>
-#include <fstream>
+#include <cstdio>
 
 namespace Log {
 
+namespace {
+std::unique_ptr<LogFile> createLogFile(const FileConfig &Config) {
+#ifndef _WIN32
+  if (Config.SharedFile) {
+    return std::make_unique<SharedAppendFile>(Config.LockLargeWrites);
+  }
+#endif
+#ifdef HAVE_IO_URING
+  if (Config.UseIoUring) {
+    auto File = std::make_unique<UringFile>(Config.WritesInFlight);
+    if (File->available()) {
+      return File;
+    }
+  }
+#endif
+  if (Config.UseIoUring) {
+    Log::Msg(Severity::Warning,
+             "io_uring is not available, writing log file using write().");
+  }
+  return std::make_unique<AppendFile>();
+}
+
+const char *severityName(Severity Level) {
+  static const std::array<const char *, 9> Names{
+      {"EMERGENCY", "ALERT", "CRITICAL", "ERROR", "WARNING", "Notice", "Info",
+       "Debug", "Trace"}};
+  auto Index = static_cast<size_t>(Level);
+  return Index < Names.size() ? Names[Index] : "Unknown";
+}
+
+/// \brief Approximate amount of memory used by a queued message.
+size_t queuedSize(const LogMessage &Message) {
+  auto Size = sizeof(LogMessage) + Message.MessageString.size() +
+              Message.ProcessName.size() + Message.Host.size() +
+              Message.ThreadId.size();
+  for (auto &Field : Message.AdditionalFields) {
+    Size += sizeof(Field) + Field.first.size() + Field.second.strVal.size();
+  }
+  return Size;
+}
+} // namespace
+
+FileInterface::FileInterface(std::string const &Name)
+    : FileInterface(FileConfig{Name}) {}
+
 FileInterface::FileInterface(std::string const &Name,
-                             const size_t MaxQueueLength)
-    : BaseLogHandler(), FileStream(Name, std::ios::app) {
-  if (FileStream.is_open() and FileStream.good()) {
-    Log::Msg(Severity::Info, "Started logging to log file: \"" + Name + "\"");
+                             const size_t /* MaxQueueLength */)
+    : FileInterface(Name) {}
+
+FileInterface::FileInterface(FileConfig Config)
+    : FileInterface(Config, createLogFile(Config)) {}
+
+FileInterface::FileInterface(FileConfig Config, std::unique_ptr<LogFile> File)
+    : BaseLogHandler(), Config(std::move(Config)), File(std::move(File)) {
+  if (this->Config.SharedFile) {
+    // Binary records and gzip frames can not be interleaved with those of
+    // other processes.
+    if (this->Config.Format == FileFormat::Binary or this->Config.Compress) {
+      Log::Msg(Severity::Warning,
+               "Shared log files can not be binary or compressed.");
+      if (this->Config.Format == FileFormat::Binary) {
+        this->Config.Format = FileFormat::Text;
+      }
+      this->Config.Compress = false;
+    }
+#ifndef _WIN32
+    Shared = dynamic_cast<SharedAppendFile *>(this->File.get());
+#endif
+  }
+  if (this->Config.Compress and this->Config.Format == FileFormat::Binary) {
+    Log::Msg(Severity::Warning,
+             "Binary log files can not be compressed while writing them.");
+  } else if (this->Config.Compress) {
+#ifdef WITH_ZLIB
+    auto Gzip = std::make_unique<GzipFile>(std::move(this->File),
+                                           this->Config.CompressionLevel,
+                                           this->Config.CompressionFrameSize);
+    Compressor = Gzip.get();
+    this->File = std::move(Gzip);
+#else
+    Log::Msg(Severity::Warning,
+             "Built without zlib, the log file will not be compressed.");
+#endif
+  }
+  if (this->Config.RotationInterval.count() > 0) {
+    NextRotation = nextRotationTime(std::chrono::system_clock::now(),
+                                    this->Config.RotationInterval);
+  }
+  if (this->Config.Durability.enabled()) {
+    Syncer = std::make_unique<FileSyncer>(*this->File,
+                                          this->Config.Durability.Interval);
+  }
+  if (this->Config.Format == FileFormat::Binary) {
+    Encoder = std::make_unique<BinaryLog::Encoder>();
+  } else if (this->Config.Format == FileFormat::Json) {
+    Serializer = std::make_unique<GelfSerializer>();
+  }
+  if (openFile(this->Config.Name)) {
+    Log::Msg(Severity::Info,
+             "Started logging to log file: \"" + this->Config.Name + "\"");
+    if (this->File->error() != 0) {
+      writeFailed();
+    }
   } else {
-    Log::Msg(Severity::Error,
-             "Unable to open log file for logging: \"" + Name + "\"");
+    Log::Msg(Severity::Error, "Unable to open log file for logging: \"" +
+                                  this->Config.Name + "\"");
   }
 }
 
+FileInterface::~FileInterface() {
+  // Queued before the executor is stopped, i.e. after all messages.
+  Executor.SendWork([this]() {
+    writeBuffer();
+    closeFile();
+  });
+}
+
 void FileInterface::addMessage(const LogMessage &Message) {
-  Executor.SendWork([=]() {
-    if (FileStream.good() and FileStream.is_open()) {
-      FileStream << BaseLogHandler::messageToString(Message) +
-                        std::string("\n");
+  addSharedMessage(std::make_shared<LogMessage>(Message));
+}
+
+void FileInterface::addSharedMessage(const LogMessage_P &Message) {
+  // A message larger than the limit is only queued if the queue is empty.
+  auto Size = queuedSize(*Message);
+  auto Queued = QueuedBytes.fetch_add(Size) + Size;
+  if (Config.MaxQueuedBytes > 0 and Queued > Config.MaxQueuedBytes and
+      Queued > Size) {
+    QueuedBytes -= Size;
+    ++MessagesDroppedQueueFull;
+    return;
+  }
+  Executor.SendWork([this, Message, Size]() {
+    QueuedBytes -= Size;
+    bufferMessage(*Message);
+  });
+}
+
+void FileInterface::bufferMessage(const LogMessage &Message) {
+  auto Now = std::chrono::steady_clock::now();
+  if (WriteBuffer.empty()) {
+    // Files are only switched between batches, as binary records refer to
+    // earlier records of the file.
+    if (WriteFailed and Now >= NextRetry) {
+      retryFile();
+    }
+    BufferedSince = Now;
+    if (WriteBuffer.capacity() < Config.BufferSize) {
+      WriteBuffer.reserve(Config.BufferSize);
+    }
+  }
+  if (Encoder) {
+    // Binary files are rotated between messages.
+    bool TimeDue = not WriteFailed and Config.RotationInterval.count() > 0 and
+                   std::chrono::system_clock::now() >= NextRotation;
+    bool SizeDue = not WriteFailed and Config.MaxFileSize > 0 and
+                   File->size() + WriteBuffer.size() >= Config.MaxFileSize;
+    if ((TimeDue or SizeDue) and Encoder->hasMessages()) {
+      writeBuffer();
+      rotate();
+      BufferedSince = Now;
+    } else if (TimeDue) {
+      // Files without messages are not rotated.
+      NextRotation = nextRotationTime(std::chrono::system_clock::now(),
+                                      Config.RotationInterval);
+    }
+    Encoder->encode(Message, WriteBuffer, File->size());
+  } else if (Serializer) {
+    // Line breaks in strings are escaped, i.e. every message is one line.
+    Serializer->serialize(Message, WriteBuffer);
+    WriteBuffer.push_back('\n');
+  } else if (nullptr != MessageParser) {
+    WriteBuffer.append(MessageParser(Message));
+    WriteBuffer.push_back('\n');
+  } else {
+    // Same format as BaseLogHandler::messageToString(), without creating
+    // temporary strings. The time stamp only changes once per second.
+    auto Time = std::chrono::system_clock::to_time_t(Message.Timestamp);
+    if (Time != CachedTime) {
+      std::tm LocalTime{};
+#ifdef _WIN32
+      localtime_s(&LocalTime, &Time);
+#else
+      localtime_r(&Time, &LocalTime);
+#endif
+      std::array<char, 50> TimeBuffer{};
+      auto Length = std::strftime(TimeBuffer.data(), TimeBuffer.size(),
+                                  "%F %T", &LocalTime);
+      CachedTimeString.assign(TimeBuffer.data(), Length);
+      CachedTime = Time;
+    }
+    WriteBuffer.append(CachedTimeString);
+    WriteBuffer.append(" (");
+    WriteBuffer.append(Message.Host);
+    WriteBuffer.append(") ");
+    WriteBuffer.append(severityName(Message.SeverityLevel));
+    WriteBuffer.append(": ");
+    WriteBuffer.append(Message.MessageString);
+    WriteBuffer.push_back('\n');
+  }
+  ++BufferedMessages;
+  auto &Durability = Config.Durability;
+  bool Sync = (Durability.EveryNMessages > 0 and
+               ++MessagesSinceSync >= Durability.EveryNMessages) or
+              (Durability.SyncOnSeverity and
+               Message.SeverityLevel <= Durability.MinimumSeverity);
+  // Messages are written in batches: once there are no more messages queued
+  // or, under sustained load, when the buffer is full or too old.
+  if (Sync or WriteBuffer.size() >= Config.BufferSize or
+      Executor.size_approx() == 0 or
+      Now - BufferedSince >= Config.MaxFlushLatency) {
+    writeBuffer();
+  }
+  if (Sync) {
+    requestSync();
+  }
+}
+
+void FileInterface::requestSync() {
+  MessagesSinceSync = 0;
+  LastSyncRequest = std::chrono::steady_clock::now();
+  if (not File->submitSync()) {
+    Syncer->requestSync();
+  }
+}
+
+bool FileInterface::openFile(const std::string &Name) {
+  bool Opened{false};
+  if (Syncer) {
+    std::lock_guard<std::mutex> Lock(Syncer->fileMutex());
+    Opened = File->open(Name);
+  } else {
+    Opened = File->open(Name);
+  }
+  if (Opened and Encoder) {
+    std::string Start;
+    Encoder->startSegment(Start, File->size(),
+                          BinaryLog::lastIndexOffset(Name));
+    File->write(Start.data(), Start.size());
+  }
+  return Opened;
+}
+
+void FileInterface::closeFile() {
+  // The index of a file that could not be written to may refer to records
+  // that are missing.
+  if (Encoder and File->isOpen() and File->error() == 0) {
+    std::string Index;
+    Encoder->finishSegment(Index, File->size());
+    File->write(Index.data(), Index.size());
+  }
+  if (Syncer) {
+    File->wait();
+    std::lock_guard<std::mutex> Lock(Syncer->fileMutex());
+    File->sync();
+    File->close();
+  } else {
+    File->close();
+  }
+}
+
+void FileInterface::writeBuffer() {
+  if (not Encoder and not WriteFailed and
+      Config.RotationInterval.count() > 0 and
+      std::chrono::system_clock::now() >= NextRotation) {
+    rotate();
+  }
+  size_t Offset{0};
+  while (Offset < WriteBuffer.size()) {
+    if (WriteFailed and not UsingFallback) {
+      dropMessages(Offset);
+      break;
+    }
+    auto Length = WriteBuffer.size() - Offset;
+    auto FileSize = File->size();
+    if (not Encoder and not WriteFailed and Config.MaxFileSize > 0 and
+        FileSize + Length > Config.MaxFileSize) {
+      // Write the lines that fit in the current file, then rotate it.
+      Length = 0;
+      if (FileSize < Config.MaxFileSize) {
+        auto LastNewLine =
+            WriteBuffer.rfind('\n', Offset + Config.MaxFileSize - FileSize - 1);
+        if (LastNewLine != std::string::npos and LastNewLine >= Offset) {
+          Length = LastNewLine + 1 - Offset;
+        }
+      }
+      if (Length == 0 and FileSize > 0 and rotate()) {
+        continue;
+      }
+      if (Length == 0) {
+        // A line longer than the maximum file size gets a file of its own.
+        auto NewLine = WriteBuffer.find('\n', Offset);
+        Length = NewLine == std::string::npos ? WriteBuffer.size() - Offset
+                                              : NewLine + 1 - Offset;
+      }
+    }
+    if (File->write(WriteBuffer.data() + Offset, Length) < Length or
+        File->error() != 0) {
+      writeFailed();
+      if (Encoder) {
+        // The records refer to strings of the segment of the failed file.
+        dropMessages(Offset);
+        break;
+      }
+      // Written to the fallback file or dropped.
+      continue;
+    }
+    Offset += Length;
+  }
+  if (Syncer and not WriteBuffer.empty() and File->isOpen()) {
+    // Submitted from here when using io_uring, as the sync has to follow
+    // the writes in progress.
+    auto Interval = Config.Durability.Interval;
+    if (Interval.count() > 0 and
+        std::chrono::steady_clock::now() - LastSyncRequest >= Interval and
+        File->submitSync()) {
+      MessagesSinceSync = 0;
+      LastSyncRequest = std::chrono::steady_clock::now();
+    } else {
+      Syncer->dataWritten();
+    }
+  }
+  WriteBuffer.clear();
+  BufferedMessages = 0;
+}
+
+void FileInterface::writeFailed() {
+  ++WriteErrors;
+  LastError = File->error();
+  closeFile();
+  NextRetry = std::chrono::steady_clock::now() + Config.RetryInterval;
+  bool FallbackFailed = UsingFallback;
+  WriteFailed = true;
+  UsingFallback = false;
+  if (not FallbackFailed and not Config.FallbackName.empty()) {
+    UsingFallback = openFile(Config.FallbackName);
+  }
+}
+
+void FileInterface::retryFile() {
+  closeFile();
+  WriteFailed = false;
+  UsingFallback = false;
+  // Binary files fail here if the start of the segment can not be written.
+  if (not openFile(Config.Name) or File->error() != 0) {
+    writeFailed();
+  }
+}
+
+void FileInterface::dropMessages(size_t Offset) {
+  // Only batches split by rotation are dropped in part.
+  auto Messages = BufferedMessages;
+  if (Offset > 0) {
+    Messages = std::min<size_t>(
+        Messages, std::count(WriteBuffer.begin() + Offset, WriteBuffer.end(),
+                             '\n'));
+  }
+  MessagesDroppedWriteFailed += Messages;
+  BytesDropped += WriteBuffer.size() - Offset;
+}
+
+bool FileInterface::rotate() {
+  auto Now = std::chrono::system_clock::now();
+  if (Config.RotationInterval.count() > 0) {
+    NextRotation = nextRotationTime(Now, Config.RotationInterval);
+  }
+  if (File->size() == 0) {
+    // Do not create empty files.
+    return false;
+  }
+  // Renaming is atomic: every line is in exactly one of the files.
+  auto const RotationTime = std::chrono::system_clock::to_time_t(Now);
+  std::string RotatedName;
+  bool Renamed{false};
+#ifndef _WIN32
+  if (Shared != nullptr) {
+    // The first process to take the lock renames the file, the others find
+    // that the name refers to a new file and only reopen it.
+    Shared->lock();
+    if (Shared->isFile(Config.Name)) {
+      RotatedName = rotatedFileName(Config.Name, RotationTime);
+      Renamed = std::rename(Config.Name.c_str(), RotatedName.c_str()) == 0;
+    }
+    // Also releases the lock.
+    closeFile();
+  }
+#endif
+  if (Shared == nullptr) {
+    closeFile();
+    RotatedName = rotatedFileName(Config.Name, RotationTime);
+    Renamed = std::rename(Config.Name.c_str(), RotatedName.c_str()) == 0;
+  }
+  openFile(Config.Name);
+  if (not Renamed) {
+    return false;
+  }
+  BackgroundExecutor.SendWork([Config = Config, RotatedName,
+                              Compressed = Compressor != nullptr]() {
+    lowerThreadPriority();
+    if (Config.CompressRotatedFiles and not Compressed and Config.SharedFile) {
+      // Processes that have not noticed the rotation yet may still append to
+      // the file rotated last. It is compressed after the next rotation
+      // instead, together with any file left by other processes.
+      auto Files = findRotatedFiles(Config.Name);
+      if (not Files.empty()) {
+        Files.pop_back();
+      }
+      for (auto &File : Files) {
+        if (not isCompressedFile(File)) {
+          compressFile(File);
+        }
+      }
+    } else if (Config.CompressRotatedFiles and not Compressed) {
+      compressFile(RotatedName);
+    }
+    if (Config.MaxRotatedFiles > 0) {
+      removeOldRotatedFiles(Config.Name, Config.MaxRotatedFiles);
     }
   });
+  return true;
 }
 
 void FileInterface::setMessageStringCreatorFunction(
@@ -42,13 +450,51 @@ void FileInterface::setMessageStringCreatorFunction(
 }
 
 bool FileInterface::flush(std::chrono::system_clock::duration TimeOut) {
-  auto WorkDone = std::make_shared<std::promise<void>>();
+  auto WorkDone = std::make_shared<std::promise<bool>>();
   auto WorkDoneFuture = WorkDone->get_future();
   Executor.SendWork([=, WorkDone{std::move(WorkDone)}]() {
-    FileStream.flush();
-    WorkDone->set_value();
+    writeBuffer();
+    File->wait();
+    if (Syncer) {
+      std::lock_guard<std::mutex> Lock(Syncer->fileMutex());
+      File->sync();
+    }
+    // Failures of the writes completed by wait() and of the sync.
+    bool Failed = File->isOpen() and File->error() != 0;
+    if (Failed) {
+      writeFailed();
+    }
+    WorkDone->set_value(not Failed);
   });
-  return std::future_status::ready == WorkDoneFuture.wait_for(TimeOut);
+  return std::future_status::ready == WorkDoneFuture.wait_for(TimeOut) and
+         WorkDoneFuture.get();
+}
+
+CompressionStatistics FileInterface::compressionStatistics() const {
+#ifdef WITH_ZLIB
+  if (Compressor != nullptr) {
+    return Compressor->statistics();
+  }
+#endif
+  return {};
+}
+
+FileStatistics FileInterface::statistics() const {
+  FileStatistics Statistics;
+  Statistics.MessagesDroppedQueueFull = MessagesDroppedQueueFull.load();
+  Statistics.MessagesDroppedWriteFailed = MessagesDroppedWriteFailed.load();
+  Statistics.BytesDropped = BytesDropped.load();
+  Statistics.WriteErrors = WriteErrors.load();
+  Statistics.LastError = LastError.load();
+  Statistics.WriteFailed = WriteFailed.load();
+  Statistics.UsingFallback = UsingFallback.load();
+  Statistics.QueuedBytes = QueuedBytes.load();
+  return Statistics;
+}
+
+size_t FileInterface::messagesDropped() const {
+  return static_cast<size_t>(MessagesDroppedQueueFull.load() +
+                             MessagesDroppedWriteFailed.load());
 }
 
 bool FileInterface::emptyQueue() { return Executor.size_approx() == 0; }
@@ -0,0 +1,280 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the log file rotation helpers.
+///
+//===----------------------------------------------------------------------===//
+
+#include "FileRotation.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <ciso646>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Log {
+
+namespace {
+const size_t TimeStampLength{15}; // YYYYmmdd-HHMMSS
+const std::string CompressedSuffix{".gz"};
+
+bool endsWith(const std::string &String, const std::string &Suffix) {
+  return String.size() >= Suffix.size() and
+         String.compare(String.size() - Suffix.size(), Suffix.size(),
+                        Suffix) == 0;
+}
+
+bool isDigit(char Character) { return Character >= '0' and Character <= '9'; }
+
+/// \brief Order of a rotated file: its time stamp and counter.
+struct RotatedFile {
+  std::string Path;
+  std::string TimeStamp;
+  unsigned long Counter;
+};
+
+/// \brief Parse the part of a file name following "<log file name>.".
+bool parseRotatedSuffix(std::string Suffix, RotatedFile &File) {
+  if (endsWith(Suffix, CompressedSuffix)) {
+    Suffix.resize(Suffix.size() - CompressedSuffix.size());
+  }
+  if (Suffix.size() < TimeStampLength) {
+    return false;
+  }
+  for (size_t i = 0; i < TimeStampLength; ++i) {
+    if (i == 8 ? Suffix[i] != '-' : not isDigit(Suffix[i])) {
+      return false;
+    }
+  }
+  File.TimeStamp = Suffix.substr(0, TimeStampLength);
+  File.Counter = 0;
+  if (Suffix.size() == TimeStampLength) {
+    return true;
+  }
+  if (Suffix[TimeStampLength] != '.' or Suffix.size() == TimeStampLength + 1) {
+    return false;
+  }
+  for (size_t i = TimeStampLength + 1; i < Suffix.size(); ++i) {
+    if (not isDigit(Suffix[i])) {
+      return false;
+    }
+  }
+  File.Counter = std::strtoul(Suffix.c_str() + TimeStampLength + 1, nullptr,
+                              10);
+  return true;
+}
+
+/// \brief The rotated versions of a log file, oldest first.
+std::vector<RotatedFile> findRotatedFileInfo(const std::string &Name) {
+  auto LastSlash = Name.rfind('/');
+  std::string Directory{"."};
+  std::string Prefix{Name + "."};
+  if (LastSlash != std::string::npos) {
+    Directory = Name.substr(0, LastSlash + 1);
+    Prefix = Name.substr(LastSlash + 1) + ".";
+  }
+  std::vector<RotatedFile> Files;
+  auto AddFile = [&](const std::string &FileName) {
+    RotatedFile File;
+    if (FileName.compare(0, Prefix.size(), Prefix) != 0 or
+        not parseRotatedSuffix(FileName.substr(Prefix.size()), File)) {
+      return;
+    }
+    File.Path = LastSlash == std::string::npos ? FileName
+                                               : Directory + FileName;
+    Files.push_back(std::move(File));
+  };
+#ifdef _WIN32
+  auto Pattern = (LastSlash == std::string::npos ? "" : Directory) + Prefix +
+                 "*";
+  _finddata_t Entry{};
+  auto Search = _findfirst(Pattern.c_str(), &Entry);
+  if (Search == -1) {
+    return {};
+  }
+  do {
+    AddFile(Entry.name);
+  } while (_findnext(Search, &Entry) == 0);
+  _findclose(Search);
+#else
+  auto DirectoryStream = ::opendir(Directory.c_str());
+  if (DirectoryStream == nullptr) {
+    return {};
+  }
+  while (auto Entry = ::readdir(DirectoryStream)) {
+    AddFile(Entry->d_name);
+  }
+  ::closedir(DirectoryStream);
+#endif
+  std::sort(Files.begin(), Files.end(), [](auto &a, auto &b) {
+    return a.TimeStamp < b.TimeStamp or
+           (a.TimeStamp == b.TimeStamp and a.Counter < b.Counter);
+  });
+  return Files;
+}
+
+#ifdef WITH_ZLIB
+void closeFile(int FileDescriptor) {
+#ifdef _WIN32
+  _close(FileDescriptor);
+#else
+  ::close(FileDescriptor);
+#endif
+}
+#endif
+} // namespace
+
+std::string rotatedFileName(const std::string &Name, std::time_t Time) {
+  std::tm UtcTime{};
+#ifdef _WIN32
+  gmtime_s(&UtcTime, &Time);
+#else
+  gmtime_r(&Time, &UtcTime);
+#endif
+  std::array<char, 32> TimeStamp{};
+  std::strftime(TimeStamp.data(), TimeStamp.size(), "%Y%m%d-%H%M%S",
+                &UtcTime);
+  auto Base = Name + "." + TimeStamp.data();
+  // Use a counter larger than that of any file rotated in the same second,
+  // as files with lower counters may have been deleted already.
+  bool Exists{false};
+  unsigned long Counter{0};
+  for (auto &File : findRotatedFileInfo(Name)) {
+    if (File.TimeStamp == TimeStamp.data()) {
+      Exists = true;
+      Counter = std::max(Counter, File.Counter + 1);
+    }
+  }
+  if (not Exists) {
+    return Base;
+  }
+  return Base + "." + std::to_string(std::max(Counter, 1ul));
+}
+
+std::vector<std::string> findRotatedFiles(const std::string &Name) {
+  std::vector<std::string> Result;
+  for (auto &File : findRotatedFileInfo(Name)) {
+    Result.push_back(std::move(File.Path));
+  }
+  return Result;
+}
+
+void removeOldRotatedFiles(const std::string &Name, size_t MaxFiles) {
+  auto Files = findRotatedFiles(Name);
+  if (Files.size() <= MaxFiles) {
+    return;
+  }
+  for (size_t i = 0; i < Files.size() - MaxFiles; ++i) {
+    std::remove(Files[i].c_str());
+  }
+}
+
+bool compressFile(const std::string &Path) {
+#ifdef WITH_ZLIB
+#ifdef _WIN32
+  auto InFile = _open(Path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+  auto InFile = ::open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+  if (InFile == -1) {
+    return false;
+  }
+#ifndef _WIN32
+  // Held until the file has been removed, so that a process compressing the
+  // rotated files of a shared log file at the same time skips this one.
+  struct stat FileInfo {};
+  if (flock(InFile, LOCK_EX | LOCK_NB) != 0 or fstat(InFile, &FileInfo) != 0 or
+      FileInfo.st_nlink == 0) {
+    closeFile(InFile);
+    return false;
+  }
+#endif
+  // Written to a temporary file first so that a compressed file is either
+  // complete or does not exist.
+  auto TempPath = Path + CompressedSuffix + ".tmp";
+  auto OutFile = gzopen(TempPath.c_str(), "wb");
+  if (OutFile == nullptr) {
+    closeFile(InFile);
+    return false;
+  }
+  std::array<char, 64 * 1024> Buffer{};
+  bool Success{true};
+  while (true) {
+#ifdef _WIN32
+    auto BytesRead = _read(InFile, Buffer.data(),
+                           static_cast<unsigned int>(Buffer.size()));
+#else
+    auto BytesRead = ::read(InFile, Buffer.data(), Buffer.size());
+#endif
+    if (BytesRead < 0 and errno == EINTR) {
+      continue;
+    }
+    if (BytesRead <= 0) {
+      Success = BytesRead == 0;
+      break;
+    }
+    if (gzwrite(OutFile, Buffer.data(), static_cast<unsigned>(BytesRead)) !=
+        BytesRead) {
+      Success = false;
+      break;
+    }
+  }
+  Success = gzclose(OutFile) == Z_OK and Success;
+  if (not Success or
+      std::rename(TempPath.c_str(), (Path + CompressedSuffix).c_str()) != 0) {
+    std::remove(TempPath.c_str());
+    closeFile(InFile);
+    return false;
+  }
+  std::remove(Path.c_str());
+  closeFile(InFile);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool isCompressedFile(const std::string &Path) {
+  return endsWith(Path, CompressedSuffix);
+}
+
+std::chrono::system_clock::time_point
+nextRotationTime(std::chrono::system_clock::time_point Now,
+                 std::chrono::seconds Interval) {
+  auto SinceEpoch =
+      std::chrono::duration_cast<std::chrono::seconds>(Now.time_since_epoch());
+  auto Intervals = SinceEpoch / Interval;
+  return std::chrono::system_clock::time_point(Interval * (Intervals + 1));
+}
+
+void lowerThreadPriority() {
+#ifdef __linux__
+  // On Linux, the nice value is a property of the thread.
+  setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+}
+
+} // namespace Log
@@ -0,0 +1,53 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Helper functions for rotating log files.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace Log {
+
+/// \brief Name for a rotated log file: the name of the log file followed by
+/// the (UTC) time of the rotation, e.g. "app.log.20261019-153000". If a
+/// file was already rotated in the same second, a counter is appended
+/// ("app.log.20261019-153000.1").
+std::string rotatedFileName(const std::string &Name, std::time_t Time);
+
+/// \brief The rotated (and possibly compressed) versions of a log file, i.e.
+/// files named as by rotatedFileName(), oldest first.
+std::vector<std::string> findRotatedFiles(const std::string &Name);
+
+/// \brief Delete the oldest rotated versions of a log file.
+/// \param[in] MaxFiles The number of rotated files to keep.
+void removeOldRotatedFiles(const std::string &Name, size_t MaxFiles);
+
+/// \brief Replace a file with a gzip compressed copy of it, named
+/// "<Path>.gz". Files that another process is compressing (holding an
+/// advisory lock on them) are skipped.
+/// \return False if the file could not be compressed (or the library was
+/// built without zlib), in which case the original file is kept.
+bool compressFile(const std::string &Path);
+
+/// \brief Is the name that of a file created by compressFile()?
+bool isCompressedFile(const std::string &Path);
+
+/// \brief The first multiple of the interval (since the epoch) after the
+/// given time.
+std::chrono::system_clock::time_point
+nextRotationTime(std::chrono::system_clock::time_point Now,
+                 std::chrono::seconds Interval);
+
+/// \brief Lower the scheduling priority of the calling thread, for work that
+/// must not compete with logging. Does nothing where not supported.
+void lowerThreadPriority();
+
+} // namespace Log
@@ -0,0 +1,87 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the log file sync thread.
+///
+//===----------------------------------------------------------------------===//
+
+#include "FileSyncer.hpp"
+#include "LogFile.hpp"
+#include <ciso646>
+
+namespace Log {
+
+FileSyncer::FileSyncer(LogFile &File, std::chrono::milliseconds Interval)
+    : File(File), Interval(Interval),
+      SyncThread(&FileSyncer::threadFunction, this) {}
+
+FileSyncer::~FileSyncer() {
+  {
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    Stop = true;
+  }
+  StateChanged.notify_one();
+  SyncThread.join();
+}
+
+void FileSyncer::dataWritten() {
+  if (Interval.count() == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    if (Dirty) {
+      return;
+    }
+    Dirty = true;
+    DirtySince = std::chrono::steady_clock::now();
+  }
+  StateChanged.notify_one();
+}
+
+void FileSyncer::requestSync() {
+  {
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    if (SyncRequested) {
+      return;
+    }
+    SyncRequested = true;
+  }
+  StateChanged.notify_one();
+}
+
+void FileSyncer::threadFunction() {
+  std::unique_lock<std::mutex> Lock(StateMutex);
+  while (true) {
+    if (Dirty and not SyncRequested) {
+      StateChanged.wait_until(Lock, DirtySince + Interval, [this]() {
+        return Stop or SyncRequested;
+      });
+    } else if (not SyncRequested) {
+      StateChanged.wait(Lock, [this]() {
+        return Stop or SyncRequested or Dirty;
+      });
+    }
+    if (Stop) {
+      return;
+    }
+    auto Now = std::chrono::steady_clock::now();
+    if (not SyncRequested and (not Dirty or Now < DirtySince + Interval)) {
+      continue;
+    }
+    // Data written from here on is not necessarily covered by this sync.
+    SyncRequested = false;
+    Dirty = false;
+    Lock.unlock();
+    {
+      std::lock_guard<std::mutex> FileLock(FileMutex);
+      File.sync();
+    }
+    ++Syncs;
+    Lock.lock();
+  }
+}
+
+} // namespace Log
@@ -0,0 +1,62 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Helper thread forcing log file data to stable storage.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Log {
+class LogFile;
+
+/// \brief Calls LogFile::sync() on a separate thread, so that the thread
+/// writing to the file is not blocked while the data is written to disk.
+///
+/// A sync is made when requested and, if an interval is set, at most that
+/// long after data was written. Requests made while a sync is pending are
+/// combined.
+class FileSyncer {
+public:
+  /// \param[in] Interval Maximum time from data being written until it is
+  /// synced. 0 only syncs when requested.
+  FileSyncer(LogFile &File, std::chrono::milliseconds Interval);
+  ~FileSyncer();
+
+  /// \brief To be called after data has been written to the file.
+  void dataWritten();
+
+  /// \brief Sync the data written so far as soon as possible.
+  void requestSync();
+
+  /// \brief Must be held while opening or closing the file.
+  std::mutex &fileMutex() { return FileMutex; }
+
+  /// \brief Number of syncs made.
+  size_t syncs() const { return Syncs.load(); }
+
+private:
+  void threadFunction();
+
+  LogFile &File;
+  std::chrono::milliseconds Interval;
+  std::mutex FileMutex;
+  std::mutex StateMutex;
+  std::condition_variable StateChanged;
+  bool SyncRequested{false};
+  bool Dirty{false};
+  std::chrono::steady_clock::time_point DirtySince;
+  bool Stop{false};
+  std::atomic<size_t> Syncs{0};
+  std::thread SyncThread;
+};
+
+} // namespace Log
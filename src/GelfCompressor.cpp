@@ -0,0 +1,114 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the compression of GELF payloads.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GelfCompressor.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <ciso646>
+#include <ctime>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Log {
+
+namespace {
+/// \brief CPU time used by the calling thread in nanoseconds.
+std::int64_t threadCpuTime() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  timespec Now{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Now);
+  return std::int64_t(Now.tv_sec) * 1000000000 + Now.tv_nsec;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+} // namespace
+
+#ifdef WITH_ZLIB
+struct GelfCompressor::Stream {
+  z_stream ZStream{};
+  bool Initialised{false};
+};
+
+GelfCompressor::GelfCompressor(CompressionSettings Settings)
+    : Settings(Settings), Deflater(std::make_unique<Stream>()) {
+  if (Settings.Type == Compression::None) {
+    return;
+  }
+  // Adding 16 to the window size selects the gzip instead of zlib framing.
+  const int WindowBits = Settings.Type == Compression::Gzip ? 15 + 16 : 15;
+  // deflateReset() clears the hash table, the size of which is set by the
+  // memory level. GELF messages are short, so a smaller table makes resetting
+  // considerably cheaper with hardly any effect on the compression ratio.
+  const int MemoryLevel{5};
+  Deflater->Initialised =
+      deflateInit2(&Deflater->ZStream, Settings.Level, Z_DEFLATED, WindowBits,
+                   MemoryLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GelfCompressor::~GelfCompressor() {
+  if (Deflater->Initialised) {
+    deflateEnd(&Deflater->ZStream);
+  }
+}
+
+bool GelfCompressor::compress(const std::string &Message, std::string &Out) {
+  if (not Deflater->Initialised or Message.size() < Settings.Threshold) {
+    ++MessagesUncompressed;
+    return false;
+  }
+  auto StartTime = threadCpuTime();
+  auto &ZStream = Deflater->ZStream;
+  deflateReset(&ZStream);
+  Out.resize(deflateBound(&ZStream, uLong(Message.size())));
+  ZStream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<char *>(Message.data()));
+  ZStream.avail_in = uInt(Message.size());
+  ZStream.next_out = reinterpret_cast<Bytef *>(&Out[0]);
+  ZStream.avail_out = uInt(Out.size());
+  auto Result = deflate(&ZStream, Z_FINISH);
+  CpuTimeNs += threadCpuTime() - StartTime;
+  if (Result != Z_STREAM_END or ZStream.total_out >= Message.size()) {
+    ++MessagesUncompressed;
+    return false;
+  }
+  Out.resize(ZStream.total_out);
+  ++MessagesCompressed;
+  BytesIn += Message.size();
+  BytesOut += Out.size();
+  return true;
+}
+#else
+struct GelfCompressor::Stream {};
+
+GelfCompressor::GelfCompressor(CompressionSettings Settings)
+    : Settings(Settings) {}
+
+GelfCompressor::~GelfCompressor() = default;
+
+bool GelfCompressor::compress(const std::string &, std::string &) {
+  ++MessagesUncompressed;
+  return false;
+}
+#endif
+
+CompressionStatistics GelfCompressor::statistics() const {
+  CompressionStatistics Statistics;
+  Statistics.MessagesCompressed = MessagesCompressed.load();
+  Statistics.MessagesUncompressed = MessagesUncompressed.load();
+  Statistics.BytesIn = BytesIn.load();
+  Statistics.BytesOut = BytesOut.load();
+  Statistics.CpuTime = std::chrono::nanoseconds(CpuTimeNs.load());
+  return Statistics;
+}
+
+} // namespace Log
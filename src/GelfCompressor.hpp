@@ -0,0 +1,58 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Compression of GELF payloads.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/Compression.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace Log {
+
+/// \brief Compresses GELF messages using zlib or gzip framing.
+///
+/// The deflate state is allocated once and reset between messages, which
+/// avoids the comparatively expensive (de)allocation of the compression
+/// window for every message. If the library was built without zlib,
+/// compress() always returns false and messages are sent uncompressed.
+///
+/// \note compress() is not thread safe, statistics() may be called from any
+/// thread.
+class GelfCompressor {
+public:
+  explicit GelfCompressor(CompressionSettings Settings);
+  ~GelfCompressor();
+
+  /// \brief Compress a message if compression is enabled and the message is
+  /// not smaller than the threshold.
+  /// \param[in] Message The uncompressed message.
+  /// \param[out] Out Is replaced with the compressed message.
+  /// \return True if the message was compressed, false if the original
+  /// message should be sent (also if compressing it does not make it
+  /// smaller).
+  bool compress(const std::string &Message, std::string &Out);
+
+  CompressionStatistics statistics() const;
+
+  const CompressionSettings &settings() const { return Settings; }
+
+private:
+  CompressionSettings Settings;
+  struct Stream;
+  std::unique_ptr<Stream> Deflater;
+
+  std::atomic<std::uint64_t> MessagesCompressed{0};
+  std::atomic<std::uint64_t> MessagesUncompressed{0};
+  std::atomic<std::uint64_t> BytesIn{0};
+  std::atomic<std::uint64_t> BytesOut{0};
+  std::atomic<std::int64_t> CpuTimeNs{0};
+};
+
+} // namespace Log
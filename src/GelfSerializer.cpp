@@ -0,0 +1,98 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the GELF serialiser.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GelfSerializer.hpp"
+#include "JsonWriter.hpp"
+#include <ciso646>
+
+namespace Log {
+
+std::string GelfSerializer::serialize(const LogMessage &Message) {
+  std::string ReturnString;
+  ReturnString.reserve(Header.size() + Message.MessageString.size() + 128);
+  serialize(Message, ReturnString);
+  return ReturnString;
+}
+
+void GelfSerializer::serialize(const LogMessage &Message, std::string &Out) {
+  // Extra fields with the same name as one of the standard fields replace the
+  // value of the standard field.
+  bool OverridesProcessId{false};
+  bool OverridesProcessName{false};
+  bool OverridesThreadId{false};
+  for (auto &Field : Message.AdditionalFields) {
+    if (Field.first == "process_id") {
+      OverridesProcessId = true;
+    } else if (Field.first == "process") {
+      OverridesProcessName = true;
+    } else if (Field.first == "thread_id") {
+      OverridesThreadId = true;
+    }
+  }
+  if (OverridesProcessId or OverridesProcessName) {
+    appendHeader(Message, Out, OverridesProcessId, OverridesProcessName);
+  } else {
+    updateHeader(Message);
+    Out.append(Header);
+  }
+  Out.append(",\"short_message\":");
+  Json::appendString(Out, Message.MessageString);
+  Out.append(",\"level\":");
+  Json::appendInt(Out, int(Message.SeverityLevel));
+  Out.append(",\"timestamp\":");
+  Json::appendTimestamp(Out, Message.Timestamp);
+  if (not OverridesThreadId) {
+    Out.append(",\"_thread_id\":");
+    Json::appendString(Out, Message.ThreadId);
+  }
+  for (auto &Field : Message.AdditionalFields) {
+    Out.append(",\"_");
+    Json::appendEscaped(Out, Field.first);
+    Out.append("\":");
+    Json::appendField(Out, Field.second);
+  }
+  Out.push_back('}');
+}
+
+void GelfSerializer::updateHeader(const LogMessage &Message) {
+  if (HeaderValid and Message.ProcessId == HeaderProcessId and
+      Message.Host == HeaderHost and
+      Message.ProcessName == HeaderProcessName) {
+    return;
+  }
+  Header.clear();
+  appendHeader(Message, Header, false, false);
+  HeaderHost = Message.Host;
+  HeaderProcessId = Message.ProcessId;
+  HeaderProcessName = Message.ProcessName;
+  HeaderValid = true;
+  ++HeaderRebuilds;
+}
+
+void GelfSerializer::appendHeader(const LogMessage &Message, std::string &Out,
+                                  bool SkipProcessId,
+                                  bool SkipProcessName) const {
+  Out.append("{\"version\":\"1.1\",\"host\":");
+  Json::appendString(Out, Message.Host);
+  if (not SkipProcessId) {
+    Out.append(",\"_process_id\":");
+    Json::appendInt(Out, Message.ProcessId);
+  }
+  if (not SkipProcessName) {
+    Out.append(",\"_process\":");
+    Json::appendString(Out, Message.ProcessName);
+  }
+}
+
+std::string serializeOnThisThread(const LogMessage &Message) {
+  thread_local GelfSerializer Serializer;
+  return Serializer.serialize(Message);
+}
+
+} // namespace Log
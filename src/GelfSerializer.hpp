@@ -0,0 +1,56 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Serialisation of log messages to GELF (JSON) strings.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/LogUtil.hpp"
+#include <string>
+
+namespace Log {
+
+/// \brief Converts log messages to GELF JSON strings.
+///
+/// The fields that are identical for all messages produced by a LoggingBase
+/// instance (GELF version, host, process id and process name) are rendered
+/// once into a cached prefix. The prefix is only re-rendered when these
+/// values change, which in practice means once per instance. Only the
+/// dynamic fields are serialised per message.
+///
+/// \note Not thread safe. Use one instance per serialising thread.
+class GelfSerializer {
+public:
+  /// \brief Serialise a message into a new string.
+  std::string serialize(const LogMessage &Message);
+
+  /// \brief Serialise a message and append the result to a buffer.
+  void serialize(const LogMessage &Message, std::string &Out);
+
+  /// \brief Number of times the cached prefix has been (re)built. Used for
+  /// testing.
+  size_t headerRebuilds() const { return HeaderRebuilds; }
+
+private:
+  void updateHeader(const LogMessage &Message);
+  void appendHeader(const LogMessage &Message, std::string &Out,
+                    bool SkipProcessId, bool SkipProcessName) const;
+
+  std::string Header;
+  std::string HeaderHost;
+  std::string HeaderProcessName;
+  int HeaderProcessId{-1};
+  bool HeaderValid{false};
+  size_t HeaderRebuilds{0};
+};
+
+/// \brief Serialise a message using a serialiser owned by the calling thread.
+/// Used by the network interfaces, whose messages are serialised on the
+/// thread of the caller or of the connection.
+std::string serializeOnThisThread(const LogMessage &Message);
+
+} // namespace Log
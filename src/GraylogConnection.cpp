@@ -9,183 +9,607 @@
 //===----------------------------------------------------------------------===//
 
 #include "GraylogConnection.hpp"
+#include <algorithm>
 #include <chrono>
 #include <ciso646>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <utility>
 
+#ifdef __linux__
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 namespace Log {
 
 using std::chrono_literals::operator""ms;
-using std::chrono_literals::operator""s;
-
-struct QueryResult {
-  explicit QueryResult(asio::ip::tcp::resolver::iterator &&Endpoints)
-      : EndpointIterator(std::move(Endpoints)) {
-    while (EndpointIterator != asio::ip::tcp::resolver::iterator()) {
-      auto CEndpoint = *EndpointIterator;
-      EndpointList.push_back(CEndpoint);
-      ++EndpointIterator;
+
+namespace {
+std::int64_t nanosecondsSinceEpoch(std::chrono::steady_clock::time_point T) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             T.time_since_epoch())
+      .count();
+}
+
+bool sameSettings(const ConnectionSettings &A, const ConnectionSettings &B) {
+  auto Tie = [](const ConnectionSettings &S) {
+    return std::tie(S.Spool.Directory, S.Spool.MaxSize, S.Spool.SegmentSize,
+                    S.Spool.DrainRate, S.Reconnect.InitialDelay,
+                    S.Reconnect.MaxDelay, S.Reconnect.Multiplier,
+                    S.Reconnect.Jitter, S.FlushWaitsForAcknowledgement,
+                    S.ConnectOnFirstUse, S.Socket.KeepAlive,
+                    S.Socket.KeepAliveIdle, S.Socket.KeepAliveInterval,
+                    S.Socket.KeepAliveProbes, S.Socket.UserTimeout,
+                    S.Socket.NoDelay, S.Socket.SendBufferSize,
+                    S.Socket.StallTimeout);
+  };
+  auto SameServer = [](const ServerAddress &L, const ServerAddress &R) {
+    return L.Host == R.Host and L.Port == R.Port;
+  };
+  return Tie(A) == Tie(B) and
+         std::equal(A.AdditionalServers.begin(), A.AdditionalServers.end(),
+                    B.AdditionalServers.begin(), B.AdditionalServers.end(),
+                    SameServer);
+}
+} // namespace
+
+std::chrono::milliseconds reconnectDelay(const ReconnectSettings &Settings,
+                                         int FailedAttempts, double Random) {
+  auto Delay = static_cast<double>(Settings.InitialDelay.count()) *
+               std::pow(Settings.Multiplier, std::min(FailedAttempts, 64));
+  Delay = std::min(Delay, static_cast<double>(Settings.MaxDelay.count()));
+  Delay *= 1.0 + Settings.Jitter * (2.0 * Random - 1.0);
+  return std::chrono::milliseconds(std::llround(std::max(Delay, 0.0)));
+}
+
+std::shared_ptr<GraylogConnection::Impl>
+GraylogConnection::Impl::acquire(std::string Host, int Port,
+                                 size_t MaxQueueLength,
+                                 ConnectionSettings Settings,
+                                 bool &SettingsDiffer) {
+  struct RegistryEntry {
+    std::weak_ptr<Impl> Connection;
+    size_t MaxQueueLength;
+  };
+  static std::mutex RegistryMutex;
+  static std::map<std::string, RegistryEntry> Registry;
+  auto Key = Host + ":" + std::to_string(Port);
+  std::lock_guard<std::mutex> Lock(RegistryMutex);
+  for (auto It = Registry.begin(); It != Registry.end();) {
+    if (It->second.Connection.expired()) {
+      It = Registry.erase(It);
+    } else {
+      ++It;
     }
-    std::sort(EndpointList.begin(), EndpointList.end(), [](auto &a, auto &b) {
-      return a.address().is_v6() < b.address().is_v6();
-    });
   }
-  asio::ip::tcp::endpoint getNextEndpoint() {
-    if (NextEndpoint < EndpointList.size()) {
-      return EndpointList[NextEndpoint++];
-    }
-    return {};
+  auto &Entry = Registry[Key];
+  auto Connection = Entry.Connection.lock();
+  SettingsDiffer = false;
+  if (Connection) {
+    SettingsDiffer = Entry.MaxQueueLength != MaxQueueLength or
+                     not sameSettings(Connection->Settings, Settings);
+  } else {
+    Connection = std::make_shared<Impl>(std::move(Host), Port, MaxQueueLength,
+                                        std::move(Settings));
+    Entry = RegistryEntry{Connection, MaxQueueLength};
   }
-  bool isDone() const { return NextEndpoint >= EndpointList.size(); }
-  asio::ip::tcp::resolver::iterator EndpointIterator;
-  std::vector<asio::ip::tcp::endpoint> EndpointList;
-  int NextEndpoint{0};
-};
+  return Connection;
+}
 
-void GraylogConnection::Impl::tryConnect(QueryResult AllEndpoints) {
-  asio::ip::tcp::endpoint CurrentEndpoint = AllEndpoints.getNextEndpoint();
-  auto HandlerGlue = [this, AllEndpoints](auto &Err) {
-    this->connectHandler(Err, AllEndpoints);
+void applySocketSettings(asio::ip::tcp::socket &Socket,
+                         const SocketSettings &Settings) {
+  asio::error_code Ignored;
+  Socket.set_option(asio::ip::tcp::no_delay(Settings.NoDelay), Ignored);
+  if (Settings.SendBufferSize > 0) {
+    Socket.set_option(
+        asio::socket_base::send_buffer_size(Settings.SendBufferSize), Ignored);
+  }
+  Socket.set_option(asio::socket_base::keep_alive(Settings.KeepAlive),
+                    Ignored);
+#ifndef _WIN32
+  auto Handle = Socket.native_handle();
+  auto setIntOption = [Handle](int Level, int Name, int Value) {
+    setsockopt(Handle, Level, Name, &Value, sizeof(Value));
   };
-  Socket.async_connect(CurrentEndpoint, HandlerGlue);
-  setState(Status::CONNECT);
+  if (Settings.KeepAlive) {
+#ifdef TCP_KEEPIDLE
+    setIntOption(IPPROTO_TCP, TCP_KEEPIDLE,
+                 static_cast<int>(Settings.KeepAliveIdle.count()));
+#elif defined(TCP_KEEPALIVE)
+    setIntOption(IPPROTO_TCP, TCP_KEEPALIVE,
+                 static_cast<int>(Settings.KeepAliveIdle.count()));
+#endif
+#ifdef TCP_KEEPINTVL
+    setIntOption(IPPROTO_TCP, TCP_KEEPINTVL,
+                 static_cast<int>(Settings.KeepAliveInterval.count()));
+#endif
+#ifdef TCP_KEEPCNT
+    setIntOption(IPPROTO_TCP, TCP_KEEPCNT, Settings.KeepAliveProbes);
+#endif
+  }
+#ifdef TCP_USER_TIMEOUT
+  if (Settings.UserTimeout.count() > 0) {
+    setIntOption(IPPROTO_TCP, TCP_USER_TIMEOUT,
+                 static_cast<int>(Settings.UserTimeout.count()));
+  }
+#endif
+#endif
+}
+
+GraylogConnection::Impl::Session::Session(asio::io_service &Service,
+                                          ServerAddress Address)
+    : HostAddress(std::move(Address.Host)),
+      HostPort(std::to_string(Address.Port)), Socket(Service),
+      Resolver(Service), ReconnectTimeout(Service), StallTimer(Service) {}
+
+GraylogConnection::Impl::Impl(std::string Host, int Port, size_t MaxQueueLength,
+                              ConnectionSettings Settings)
+    : HostAddress(std::move(Host)), HostPort(std::to_string(Port)),
+      Settings(std::move(Settings)), LogMessages(MaxQueueLength), Service(),
+      Work(std::make_unique<asio::io_service::work>(Service)),
+      FlushTimer(Service), RandomGenerator(std::random_device()()) {
+  LastStateChange = nanosecondsSinceEpoch(Clock::now());
+#ifndef _WIN32
+  if (not this->Settings.Spool.Directory.empty()) {
+    Spool = std::make_unique<MessageSpool>(this->Settings.Spool);
+  }
+#endif
+  Sessions.push_back(
+      std::make_unique<Session>(Service, ServerAddress{HostAddress, Port}));
+  for (auto &Address : this->Settings.AdditionalServers) {
+    Sessions.push_back(std::make_unique<Session>(Service, Address));
+  }
+  if (not this->Settings.ConnectOnFirstUse) {
+    start();
+  }
+}
+
+void GraylogConnection::Impl::start() {
+  std::call_once(Started, [this]() {
+    for (auto &CSession : Sessions) {
+      doAddressQuery(*CSession);
+    }
+    AsioThread = std::thread(&GraylogConnection::Impl::threadFunction, this);
+  });
 }
 
-GraylogConnection::Impl::Impl(std::string Host, int Port, size_t MaxQueueLength)
-    : HostAddress(std::move(Host)), HostPort(std::to_string(Port)), Service(),
-      Work(std::make_unique<asio::io_service::work>(Service)), Socket(Service),
-      Resolver(Service), ReconnectTimeout(Service, 10s),
-      LogMessages(MaxQueueLength) {
-  doAddressQuery();
-  AsioThread = std::thread(&GraylogConnection::Impl::threadFunction, this);
+void GraylogConnection::Impl::doAddressQuery(Session &CSession) {
+  setState(CSession, Status::ADDR_LOOKUP);
+  asio::ip::tcp::resolver::query Query(CSession.HostAddress,
+                                       CSession.HostPort);
+  auto HandlerGlue = [this, &CSession](auto &Error, auto EndpointIter) {
+    this->resolverHandler(CSession, Error, EndpointIter);
+  };
+  CSession.Resolver.async_resolve(Query, HandlerGlue);
 }
 
 void GraylogConnection::Impl::resolverHandler(
-    const asio::error_code &Error,
+    Session &CSession, const asio::error_code &Error,
     asio::ip::tcp::resolver::iterator EndpointIter) {
   if (Error) {
-    setState(Status::ADDR_RETRY_WAIT);
-    reConnect(ReconnectDelay::LONG);
+    reConnect(CSession);
     return;
   }
-  QueryResult AllEndpoints(std::move(EndpointIter));
-  tryConnect(AllEndpoints);
+  CSession.Endpoints.clear();
+  for (; EndpointIter != asio::ip::tcp::resolver::iterator(); ++EndpointIter) {
+    CSession.Endpoints.push_back(*EndpointIter);
+  }
+  std::stable_sort(CSession.Endpoints.begin(), CSession.Endpoints.end(),
+                   [](auto &a, auto &b) {
+                     return a.address().is_v6() < b.address().is_v6();
+                   });
+  CSession.NextEndpoint = 0;
+  tryConnect(CSession);
 }
 
-void GraylogConnection::Impl::connectHandler(const asio::error_code &Error,
-                                             const QueryResult &AllEndpoints) {
-  if (!Error) {
-    setState(Status::SEND_LOOP);
-    auto HandlerGlue = [this](auto &Error, auto Size) {
-      this->receiveHandler(Error, Size);
-    };
-    Socket.async_receive(asio::buffer(InputBuffer), HandlerGlue);
-    trySendMessage();
+void GraylogConnection::Impl::tryConnect(Session &CSession) {
+  if (CSession.NextEndpoint >= CSession.Endpoints.size()) {
+    reConnect(CSession);
     return;
   }
-  Socket.close();
-  if (AllEndpoints.isDone()) {
-    reConnect(ReconnectDelay::LONG);
+  auto HandlerGlue = [this, &CSession](auto &Error) {
+    this->connectHandler(CSession, Error);
+  };
+  CSession.Socket.async_connect(CSession.Endpoints[CSession.NextEndpoint++],
+                                HandlerGlue);
+  setState(CSession, Status::CONNECT);
+}
+
+void GraylogConnection::Impl::connectHandler(Session &CSession,
+                                             const asio::error_code &Error) {
+  if (Error) {
+    asio::error_code Ignored;
+    CSession.Socket.close(Ignored);
+    tryConnect(CSession);
     return;
   }
-  tryConnect(AllEndpoints);
+  CSession.FailedAttempts = 0;
+  applySocketSettings(CSession.Socket, Settings.Socket);
+  if (CSession.HasConnected) {
+    Reconnects.fetch_add(1, std::memory_order_relaxed);
+  }
+  CSession.HasConnected = true;
+  setState(CSession, Status::SEND_LOOP);
+  auto HandlerGlue = [this, &CSession,
+                      Generation = CSession.Generation](auto &Error, auto) {
+    if (Generation == CSession.Generation) {
+      this->receiveHandler(CSession, Error);
+    }
+  };
+  CSession.Socket.async_receive(asio::buffer(CSession.InputBuffer),
+                                HandlerGlue);
+  scheduleDispatch();
 }
 
-void GraylogConnection::Impl::reConnect(ReconnectDelay Delay) {
-  auto HandlerGlue = [this](auto & /* Err */) { this->doAddressQuery(); };
-  switch (Delay) {
-  case ReconnectDelay::SHORT:
-    ReconnectTimeout.expires_after(100ms);
-    break;
-  case ReconnectDelay::LONG: // Fallthrough
-  default:
-    ReconnectTimeout.expires_after(10s);
-    break;
-  }
-  ReconnectTimeout.async_wait(HandlerGlue);
-  setState(Status::ADDR_RETRY_WAIT);
+void GraylogConnection::Impl::reConnect(Session &CSession) {
+  auto HandlerGlue = [this, &CSession](auto & /* Err */) {
+    this->doAddressQuery(CSession);
+  };
+  std::uniform_real_distribution<double> Distribution(0.0, 1.0);
+  CSession.ReconnectTimeout.expires_after(
+      reconnectDelay(Settings.Reconnect, CSession.FailedAttempts++,
+                     Distribution(RandomGenerator)));
+  CSession.ReconnectTimeout.async_wait(HandlerGlue);
+  setState(CSession, Status::ADDR_RETRY_WAIT);
 }
 
-void GraylogConnection::Impl::receiveHandler(const asio::error_code &Error,
-                                             std::size_t /* BytesReceived */) {
+void GraylogConnection::Impl::receiveHandler(Session &CSession,
+                                             const asio::error_code &Error) {
   if (Error) {
-    Socket.close();
-    reConnect(ReconnectDelay::SHORT);
+    connectionFailed(CSession);
     return;
   }
-  auto HandlerGlue = [this](auto &Error, auto Size) {
-    this->receiveHandler(Error, Size);
+  auto HandlerGlue = [this, &CSession,
+                      Generation = CSession.Generation](auto &Error, auto) {
+    if (Generation == CSession.Generation) {
+      this->receiveHandler(CSession, Error);
+    }
   };
-  Socket.async_receive(asio::buffer(InputBuffer), HandlerGlue);
+  CSession.Socket.async_receive(asio::buffer(CSession.InputBuffer),
+                                HandlerGlue);
+}
+
+void GraylogConnection::Impl::connectionFailed(Session &CSession,
+                                               size_t BytesWritten) {
+  ++CSession.Generation;
+  CSession.StallTimer.cancel();
+  asio::error_code Ignored;
+  CSession.Socket.close(Ignored);
+  // A partially written message is sent again in full. Messages following
+  // it are re-sent on another connection (or this one, once re-connected).
+  auto &WriteBuffer = CSession.WriteBuffer;
+  auto FirstUnsent = WriteBuffer.begin();
+  if (BytesWritten > 0 and BytesWritten <= WriteBuffer.size()) {
+    auto LastSent = std::find(std::make_reverse_iterator(WriteBuffer.begin() +
+                                                         BytesWritten),
+                              WriteBuffer.rend(), '\0');
+    FirstUnsent = LastSent.base();
+  }
+  auto MessagesSent = std::count(WriteBuffer.begin(), FirstUnsent, '\0');
+  auto FirstUnsentRecord = CSession.WriteRecords.cbegin() + MessagesSent;
+  messagesWritten(CSession.WriteRecords.cbegin(), FirstUnsentRecord);
+  OrphanedMessages.insert(OrphanedMessages.end(), FirstUnsent,
+                          WriteBuffer.end());
+  OrphanedRecords.insert(OrphanedRecords.end(), FirstUnsentRecord,
+                           CSession.WriteRecords.cend());
+  OrphanedMessages.insert(OrphanedMessages.end(),
+                          CSession.MessageBuffer.begin(),
+                          CSession.MessageBuffer.end());
+  OrphanedRecords.insert(OrphanedRecords.end(),
+                           CSession.MessageRecords.begin(),
+                           CSession.MessageRecords.end());
+  WriteBuffer.clear();
+  CSession.WriteRecords.clear();
+  CSession.MessageBuffer.clear();
+  CSession.MessageRecords.clear();
+  CSession.Writing = false;
+  reConnect(CSession);
+  scheduleDispatch();
+  checkFlushes();
 }
 
-void GraylogConnection::Impl::trySendMessage() {
-  if (not Socket.is_open()) {
+void GraylogConnection::Impl::startWrite(Session &CSession) {
+  if (CSession.Writing or CSession.MessageBuffer.empty() or
+      CSession.State != Status::SEND_LOOP) {
     return;
   }
-  auto HandlerGlue = [this](auto &Err, auto Size) {
-    this->sentMessageHandler(Err, Size);
+  CSession.WriteBuffer.swap(CSession.MessageBuffer);
+  CSession.MessageBuffer.clear();
+  CSession.WriteRecords.swap(CSession.MessageRecords);
+  CSession.MessageRecords.clear();
+  CSession.Writing = true;
+  CSession.WriteOffset = 0;
+  continueWrite(CSession);
+}
+
+void GraylogConnection::Impl::continueWrite(Session &CSession) {
+  // async_write_some() rather than async_write() so that the size of every
+  // write to the socket can be recorded.
+  auto HandlerGlue = [this, &CSession, Generation = CSession.Generation](
+                         auto &Error, auto BytesSent) {
+    if (Generation == CSession.Generation) {
+      this->writeHandler(CSession, Error, BytesSent);
+    }
   };
-  if (MessageBuffer.size() > MessageAdditionLimit) {
-    asio::async_write(Socket, asio::buffer(MessageBuffer), HandlerGlue);
+  CSession.Socket.async_write_some(
+      asio::buffer(CSession.WriteBuffer.data() + CSession.WriteOffset,
+                   CSession.WriteBuffer.size() - CSession.WriteOffset),
+      HandlerGlue);
+  // A half-open connection may accept no data for minutes before the
+  // operating system gives up on it.
+  if (Settings.Socket.StallTimeout.count() > 0) {
+    CSession.StallTimer.expires_after(Settings.Socket.StallTimeout);
+    CSession.StallTimer.async_wait(
+        [this, &CSession, Generation = CSession.Generation](auto &Error) {
+          if (not Error and Generation == CSession.Generation and
+              CSession.Writing) {
+            this->connectionFailed(CSession, CSession.WriteOffset);
+          }
+        });
+  }
+}
+
+void GraylogConnection::Impl::writeHandler(Session &CSession,
+                                           const asio::error_code &Error,
+                                           std::size_t BytesSent) {
+  if (BytesSent > 0) {
+    WriteSizes.record(BytesSent);
+    this->BytesSent.fetch_add(BytesSent, std::memory_order_relaxed);
+  }
+  CSession.WriteOffset += BytesSent;
+  if (Error) {
+    CSession.Writing = false;
+    connectionFailed(CSession, CSession.WriteOffset);
+    return;
+  }
+  if (CSession.WriteOffset < CSession.WriteBuffer.size()) {
+    continueWrite(CSession);
     return;
   }
-  std::function<std::string(void)> NewMessageFunc;
-  using namespace std::chrono_literals;
-  if (LogMessages.wait_dequeue_timed(NewMessageFunc, 10ms)) {
-    auto NewMessage = NewMessageFunc();
-    if (NewMessage.empty()) {
-      if (!MessageBuffer.empty()) {
-        asio::async_write(Socket, asio::buffer(MessageBuffer), HandlerGlue);
-      } else {
-        Service.post([this]() { this->trySendMessage(); });
+  CSession.Writing = false;
+  CSession.StallTimer.cancel();
+  CSession.WriteBuffer.clear();
+  messagesWritten(CSession.WriteRecords.cbegin(),
+                  CSession.WriteRecords.cend());
+  CSession.WriteRecords.clear();
+  startWrite(CSession);
+  scheduleDispatch();
+  checkFlushes();
+}
+
+void GraylogConnection::Impl::appendMessage(Session &Target,
+                                            const char *Message, size_t Size,
+                                            Clock::time_point QueuedAt) {
+  Target.MessageBuffer.insert(Target.MessageBuffer.end(), Message,
+                              Message + Size);
+  Target.MessageBuffer.push_back('\0');
+  Target.MessageRecords.push_back({NextSequence++, QueuedAt});
+  UnwrittenMessages.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GraylogConnection::Impl::messagesWritten(
+    std::vector<MessageRecord>::const_iterator Begin,
+    std::vector<MessageRecord>::const_iterator End) {
+  auto Now = Clock::now();
+  MessagesSent.fetch_add(static_cast<std::uint64_t>(End - Begin),
+                         std::memory_order_relaxed);
+  UnwrittenMessages.fetch_sub(static_cast<std::uint64_t>(End - Begin),
+                              std::memory_order_relaxed);
+  // Messages may be completed out of order, e.g. when sent on different
+  // sessions, so track completion until there are no gaps.
+  for (auto It = Begin; It != End; ++It) {
+    if (It->QueuedAt != Clock::time_point()) {
+      Latency.record(static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(Now -
+                                                                It->QueuedAt)
+              .count()));
+    }
+    auto Index = static_cast<size_t>(It->Sequence - FirstIncomplete);
+    if (Index >= CompletedSequences.size()) {
+      CompletedSequences.resize(Index + 1, false);
+    }
+    CompletedSequences[Index] = true;
+  }
+  while (not CompletedSequences.empty() and CompletedSequences.front()) {
+    CompletedSequences.pop_front();
+    ++FirstIncomplete;
+  }
+}
+
+namespace {
+size_t socketSendQueueSize(asio::ip::tcp::socket &Socket) {
+#ifdef __linux__
+  int QueuedBytes{0};
+  if (Socket.is_open() and
+      ioctl(Socket.native_handle(), SIOCOUTQ, &QueuedBytes) == 0) {
+    return static_cast<size_t>(QueuedBytes);
+  }
+#endif
+  return 0;
+}
+} // namespace
+
+void GraylogConnection::Impl::checkFlushes() {
+  if (PendingFlushes.empty()) {
+    return;
+  }
+  bool WaitingForAcknowledgement{false};
+  if (Settings.FlushWaitsForAcknowledgement) {
+    for (auto &CSession : Sessions) {
+      if (CSession->State == Status::SEND_LOOP and
+          socketSendQueueSize(CSession->Socket) > 0) {
+        WaitingForAcknowledgement = true;
       }
-      return;
     }
-    std::copy(NewMessage.begin(), NewMessage.end(),
-              std::back_inserter(MessageBuffer));
-    MessageBuffer.push_back('\0');
-    asio::async_write(Socket, asio::buffer(MessageBuffer), HandlerGlue);
-  } else if (!MessageBuffer.empty()) {
-    asio::async_write(Socket, asio::buffer(MessageBuffer), HandlerGlue);
-  } else {
-    Service.post([this]() { this->trySendMessage(); });
+  }
+  bool PollSendQueues{false};
+  auto Unresolved = std::remove_if(
+      PendingFlushes.begin(), PendingFlushes.end(), [&](auto &Ticket) {
+        if (Ticket.Sequence > FirstIncomplete) {
+          return false;
+        }
+        if (WaitingForAcknowledgement) {
+          PollSendQueues = true;
+          return false;
+        }
+        Ticket.Done->set_value();
+        return true;
+      });
+  PendingFlushes.erase(Unresolved, PendingFlushes.end());
+  if (PollSendQueues) {
+    FlushTimer.expires_after(1ms);
+    FlushTimer.async_wait([this](auto &Error) {
+      if (not Error) {
+        this->checkFlushes();
+      }
+    });
   }
 }
 
-void GraylogConnection::Impl::sentMessageHandler(const asio::error_code &Error,
-                                                 std::size_t BytesSent) {
-  if (BytesSent == MessageBuffer.size()) {
-    MessageBuffer.clear();
-  } else if (BytesSent > 0) {
-    std::vector<char> TempVector;
-    std::copy(MessageBuffer.begin() + BytesSent, MessageBuffer.end(),
-              std::back_inserter(TempVector));
-    MessageBuffer = TempVector;
+GraylogConnection::Impl::Session *
+GraylogConnection::Impl::leastLoadedSession() {
+  Session *LeastLoaded{nullptr};
+  for (auto &CSession : Sessions) {
+    if (CSession->State == Status::SEND_LOOP and
+        (LeastLoaded == nullptr or
+         CSession->outstandingBytes() < LeastLoaded->outstandingBytes())) {
+      LeastLoaded = CSession.get();
+    }
   }
-  if (Error) {
-    Socket.close();
+  return LeastLoaded;
+}
+
+void GraylogConnection::Impl::scheduleDispatch() {
+  if (DispatchScheduled) {
+    return;
+  }
+  DispatchScheduled = true;
+  Service.post([this]() {
+    DispatchScheduled = false;
+    this->dispatchMessages();
+  });
+}
+
+void GraylogConnection::Impl::dispatchMessages() {
+  auto Target = leastLoadedSession();
+  if (Target == nullptr or Target->outstandingBytes() > MessageAdditionLimit) {
+    // Called again when a session has connected or finished writing.
     return;
   }
-  trySendMessage();
+  bool AddedMessages{false};
+  if (not OrphanedMessages.empty()) {
+    Target->MessageBuffer.insert(Target->MessageBuffer.end(),
+                                 OrphanedMessages.begin(),
+                                 OrphanedMessages.end());
+    Target->MessageRecords.insert(Target->MessageRecords.end(),
+                                    OrphanedRecords.begin(),
+                                    OrphanedRecords.end());
+    OrphanedMessages.clear();
+    OrphanedRecords.clear();
+    AddedMessages = true;
+  }
+  AddedMessages = drainSpool(*Target) or AddedMessages;
+  bool Outstanding = AddedMessages;
+  for (auto &CSession : Sessions) {
+    Outstanding = Outstanding or CSession->outstandingBytes() > 0;
+  }
+  // Only wait for new messages if there is nothing else to do.
+  QueuedMessage NewMessageFunc;
+  bool GotMessage = Outstanding
+                        ? LogMessages.try_dequeue(NewMessageFunc)
+                        : LogMessages.wait_dequeue_timed(NewMessageFunc, 10ms);
+  const int MaxMessagesPerDispatch{64};
+  for (int i = 1; GotMessage; ++i) {
+    auto NewMessage = NewMessageFunc.Creator();
+    if (not NewMessage.empty()) {
+      Target = leastLoadedSession();
+      appendMessage(*Target, NewMessage.data(), NewMessage.size(),
+                    NewMessageFunc.QueuedAt);
+      AddedMessages = true;
+    }
+    if (i == MaxMessagesPerDispatch or
+        leastLoadedSession()->outstandingBytes() > MessageAdditionLimit) {
+      break;
+    }
+    GotMessage = LogMessages.try_dequeue(NewMessageFunc);
+  }
+  for (auto &CSession : Sessions) {
+    startWrite(*CSession);
+  }
+  checkFlushes();
+  if (AddedMessages or not Outstanding) {
+    scheduleDispatch();
+  }
 }
 
-void GraylogConnection::Impl::doAddressQuery() {
-  setState(Status::ADDR_LOOKUP);
-  asio::ip::tcp::resolver::query Query(HostAddress, HostPort);
-  auto HandlerGlue = [this](auto &Error, auto EndpointIter) {
-    this->resolverHandler(Error, EndpointIter);
-  };
-  Resolver.async_resolve(Query, HandlerGlue);
+void GraylogConnection::Impl::queueMessage(
+    std::function<std::string(void)> MessageCreator) {
+  start();
+  QueuedMessage Message{std::move(MessageCreator), Clock::now()};
+#ifndef _WIN32
+  if (Spool) {
+    if (getConnectionStatus() != Status::SEND_LOOP or
+        not LogMessages.try_enqueue(Message)) {
+      Spool->push(Message.Creator());
+    }
+    return;
+  }
+#endif
+  if (not LogMessages.try_enqueue(std::move(Message))) {
+    MessagesDropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool GraylogConnection::Impl::drainSpool(Session &Target) {
+#ifdef _WIN32
+  return false;
+#else
+  if (not Spool or Spool->empty()) {
+    return false;
+  }
+  // Token bucket allowing bursts of up to 100 ms worth of messages.
+  auto Now = std::chrono::steady_clock::now();
+  auto const DrainRate = static_cast<double>(Settings.Spool.DrainRate);
+  auto const MaxTokens = std::max(1.0, DrainRate / 10);
+  SpoolDrainTokens =
+      std::min(MaxTokens, SpoolDrainTokens +
+                              DrainRate * std::chrono::duration<double>(
+                                              Now - LastSpoolDrain)
+                                              .count());
+  LastSpoolDrain = Now;
+  bool Drained{false};
+  std::string Message;
+  while (SpoolDrainTokens >= 1.0 and
+         Target.MessageBuffer.size() < MessageAdditionLimit and
+         Spool->pop(Message)) {
+    appendMessage(Target, Message.data(), Message.size(), {});
+    SpoolDrainTokens -= 1.0;
+    Drained = true;
+  }
+  return Drained;
+#endif
 }
 
 GraylogConnection::Impl::~Impl() {
   Service.stop();
-  AsioThread.join();
-  try {
-    Socket.close();
-  } catch (asio::system_error &) {
-    // Do nothing
+  if (AsioThread.joinable()) {
+    AsioThread.join();
+  }
+  for (auto &CSession : Sessions) {
+    try {
+      CSession->Socket.close();
+    } catch (asio::system_error &) {
+      // Do nothing
+    }
   }
 }
 
@@ -198,18 +622,117 @@ void GraylogConnection::Impl::threadFunction() { Service.run(); }
 
 void GraylogConnection::Impl::setState(
     GraylogConnection::Impl::Status NewState) {
+  auto OldState = ConnectionState.load(std::memory_order_relaxed);
+  if (OldState == NewState) {
+    return;
+  }
+  auto Now = nanosecondsSinceEpoch(Clock::now());
+  auto Previous = LastStateChange.exchange(Now, std::memory_order_relaxed);
+  TimeInState[static_cast<size_t>(OldState)].fetch_add(
+      Now - Previous, std::memory_order_relaxed);
   ConnectionState.store(NewState, std::memory_order_relaxed);
+  std::vector<StateCallback> Callbacks;
+  {
+    std::lock_guard<std::mutex> Lock(CallbacksMutex);
+    for (auto &Entry : StateCallbacks) {
+      Callbacks.push_back(Entry.second);
+    }
+  }
+  for (auto &Entry : Callbacks) {
+    auto Callback = [Callback = std::move(Entry.Callback), OldState,
+                     NewState]() {
+      try {
+        Callback(OldState, NewState);
+      } catch (...) {
+        // Do nothing
+      }
+    };
+    if (Entry.Executor) {
+      Entry.Executor(std::move(Callback));
+    } else {
+      Callback();
+    }
+  }
+}
+
+size_t GraylogConnection::Impl::addStateChangeCallback(
+    GraylogConnection::StateChangeCallback Callback,
+    GraylogConnection::CallbackExecutor Executor) {
+  std::lock_guard<std::mutex> Lock(CallbacksMutex);
+  auto Id = NextCallbackId++;
+  StateCallbacks[Id] = {std::move(Callback), std::move(Executor)};
+  return Id;
+}
+
+void GraylogConnection::Impl::removeStateChangeCallback(size_t CallbackId) {
+  std::lock_guard<std::mutex> Lock(CallbacksMutex);
+  StateCallbacks.erase(CallbackId);
+}
+
+ConnectionMetrics GraylogConnection::Impl::metrics() const {
+  ConnectionMetrics Result;
+  Result.MessagesSent = MessagesSent.load(std::memory_order_relaxed);
+  Result.BytesSent = BytesSent.load(std::memory_order_relaxed);
+  Result.MessagesDropped = MessagesDropped.load(std::memory_order_relaxed);
+#ifndef _WIN32
+  if (Spool) {
+    Result.MessagesDropped += Spool->messagesDropped();
+  }
+#endif
+  Result.Reconnects = Reconnects.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < TimeInState.size(); ++i) {
+    Result.TimeInState[i] = std::chrono::nanoseconds(
+        TimeInState[i].load(std::memory_order_relaxed));
+  }
+  auto CurrentState = ConnectionState.load(std::memory_order_relaxed);
+  Result.TimeInState[static_cast<size_t>(CurrentState)] +=
+      std::chrono::nanoseconds(
+          nanosecondsSinceEpoch(Clock::now()) -
+          LastStateChange.load(std::memory_order_relaxed));
+  Result.WriteSizes = WriteSizes.snapshot();
+  Result.Latency = Latency.snapshot();
+  return Result;
+}
+
+void GraylogConnection::Impl::setState(Session &CSession, Status NewState) {
+  CSession.State = NewState;
+  // The state of the connection as a whole is that of the session which is
+  // furthest along, i.e. SEND_LOOP if any session is connected.
+  auto CombinedState = Status::ADDR_LOOKUP;
+  for (auto &Current : Sessions) {
+    CombinedState = std::max(CombinedState, Current->State);
+  }
+  setState(CombinedState);
 }
 
 bool GraylogConnection::Impl::flush(
     std::chrono::system_clock::duration TimeOut) {
+  start();
   auto WorkDone = std::make_shared<std::promise<void>>();
   auto WorkDoneFuture = WorkDone->get_future();
-  LogMessages.try_enqueue([WorkDone = std::move(WorkDone)]() -> std::string {
-    WorkDone->set_value();
+  // The flush request is queued even if the queue is full, so that it is
+  // resolved after the messages queued before it. It is resolved once those
+  // have been written to a socket, which is known when the request has been
+  // taken off the queue and the sequence number of the next message is
+  // known.
+  auto Marker = [this, WorkDone = std::move(WorkDone)]() -> std::string {
+    PendingFlushes.push_back({NextSequence, WorkDone});
     return {};
-  });
+  };
+  LogMessages.enqueue({Marker, Clock::now()});
   return std::future_status::ready == WorkDoneFuture.wait_for(TimeOut);
 }
 
+ShutdownReport GraylogConnection::Impl::shutdown(
+    std::chrono::system_clock::duration TimeOut) {
+  ShutdownReport Report;
+  Report.Completed = flush(TimeOut);
+  if (not Report.Completed) {
+    Report.UndeliveredMessages =
+        LogMessages.size_approx() +
+        UnwrittenMessages.load(std::memory_order_relaxed);
+  }
+  return Report;
+}
+
 } // namespace Log
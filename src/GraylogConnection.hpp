@@ -9,78 +9,240 @@
 
 #pragma once
 
+#include "AtomicHistogram.hpp"
 #include "graylog_logger/ConnectionStatus.hpp"
 #include "graylog_logger/GraylogInterface.hpp"
 #include <array>
 #include <asio.hpp>
 #include <atomic>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <moodycamel/blockingconcurrentqueue.h>
+#include <mutex>
+#include <random>
 #include <string>
 #include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include "MessageSpool.hpp"
+#endif
 
 namespace Log {
 
-struct QueryResult;
+/// \brief Delay before a connection attempt.
+/// \param[in] Settings The back-off settings.
+/// \param[in] FailedAttempts Number of failed attempts since the last
+/// successful connection.
+/// \param[in] Random A random number in the range [0, 1) used for the jitter.
+std::chrono::milliseconds reconnectDelay(const ReconnectSettings &Settings,
+                                         int FailedAttempts, double Random);
 
-/// \todo Implement timeouts in the ASIO code in case we ever have problems with
-/// bad connections.
+/// \brief Apply the socket options of the settings to a connected socket.
+/// Options not supported by the platform are ignored.
+void applySocketSettings(asio::ip::tcp::socket &Socket,
+                         const SocketSettings &Settings);
 
 class GraylogConnection::Impl {
 public:
   using Status = Log::Status;
-  Impl(std::string Host, int Port, size_t MaxQueueLength);
+  Impl(std::string Host, int Port, size_t MaxQueueLength,
+       ConnectionSettings Settings);
   virtual ~Impl();
+  /// \brief Get the connection to the given host and port, creating it if
+  /// no instance is currently using it.
+  /// \param[out] SettingsDiffer Set if an existing connection was created
+  /// with a different queue length or settings.
+  static std::shared_ptr<Impl> acquire(std::string Host, int Port,
+                                       size_t MaxQueueLength,
+                                       ConnectionSettings Settings,
+                                       bool &SettingsDiffer);
   virtual void sendMessage(std::string Msg) {
     auto MsgFunc = [=]() { return Msg; };
-    LogMessages.try_enqueue(MsgFunc);
+    queueMessage(MsgFunc);
   };
+  virtual void
+  sendDeferredMessage(std::function<std::string(void)> MessageCreator) {
+    queueMessage(std::move(MessageCreator));
+  }
   Status getConnectionStatus() const;
   virtual bool flush(std::chrono::system_clock::duration TimeOut);
+  ShutdownReport shutdown(std::chrono::system_clock::duration TimeOut);
   virtual size_t queueSize() { return LogMessages.size_approx(); }
+  ConnectionMetrics metrics() const;
+  size_t addStateChangeCallback(GraylogConnection::StateChangeCallback Callback,
+                                GraylogConnection::CallbackExecutor Executor);
+  void removeStateChangeCallback(size_t CallbackId);
+#ifndef _WIN32
+  size_t spoolSize() const { return Spool ? Spool->size() : 0; }
+#else
+  size_t spoolSize() const { return 0; }
+#endif
 
 protected:
-  enum class ReconnectDelay { LONG, SHORT };
+  using Clock = std::chrono::steady_clock;
+  struct QueuedMessage {
+    std::function<std::string(void)> Creator;
+    Clock::time_point QueuedAt;
+  };
+  /// \brief A message in a send buffer.
+  struct MessageRecord {
+    std::uint64_t Sequence;
+    /// \brief Not set for messages from the spool.
+    Clock::time_point QueuedAt;
+  };
+
+  /// \brief The connection to one of the servers.
+  struct Session {
+    Session(asio::io_service &Service, ServerAddress Address);
+    std::string HostAddress;
+    std::string HostPort;
+    Status State{Status::ADDR_LOOKUP};
+    /// \brief Incremented when the socket is closed, so that completion
+    /// handlers of operations on the old socket can be ignored.
+    std::uint64_t Generation{0};
+    int FailedAttempts{0};
+    std::vector<asio::ip::tcp::endpoint> Endpoints;
+    size_t NextEndpoint{0};
+    /// \brief Messages waiting to be written.
+    std::vector<char> MessageBuffer;
+    /// \brief The messages in MessageBuffer.
+    std::vector<MessageRecord> MessageRecords;
+    /// \brief Messages being written.
+    std::vector<char> WriteBuffer;
+    std::vector<MessageRecord> WriteRecords;
+    /// \brief Number of bytes of WriteBuffer written so far.
+    size_t WriteOffset{0};
+    bool Writing{false};
+    /// \brief Has this session been connected before?
+    bool HasConnected{false};
+    std::array<std::uint8_t, 64> InputBuffer{};
+    asio::ip::tcp::socket Socket;
+    asio::ip::tcp::resolver Resolver;
+    asio::steady_timer ReconnectTimeout;
+    /// \brief Expires if a write makes no progress.
+    asio::steady_timer StallTimer;
+    size_t outstandingBytes() const {
+      return MessageBuffer.size() + WriteBuffer.size();
+    }
+  };
 
+  /// \brief Start looking up the servers and the thread of the connection.
+  /// Does nothing if already started.
+  void start();
   void threadFunction();
   void setState(Status NewState);
+  /// \brief Set the state of a session and the combined state.
+  void setState(Session &CSession, Status NewState);
+  /// \brief Queue a message, or write it to the spool if the queue is full
+  /// or there is no connection.
+  void queueMessage(std::function<std::string(void)> MessageCreator);
+  /// \brief Move spooled messages to the send buffer of a session, limited
+  /// by the drain rate.
+  /// \return True if any messages were added to the buffer.
+  bool drainSpool(Session &Target);
+  /// \brief Append a message to the send buffer of a session and give it
+  /// the next sequence number.
+  void appendMessage(Session &Target, const char *Message, size_t Size,
+                     Clock::time_point QueuedAt);
+  /// \brief Mark messages as handed over to the operating system.
+  void messagesWritten(std::vector<MessageRecord>::const_iterator Begin,
+                       std::vector<MessageRecord>::const_iterator End);
+  /// \brief Resolve the flush requests whose messages have all been written
+  /// (and, optionally, acknowledged).
+  void checkFlushes();
 
   std::atomic<Status> ConnectionState{Status::ADDR_LOOKUP};
 
-  std::atomic_bool closeThread{false};
-
-  std::vector<char> MessageBuffer;
-
   std::string HostAddress;
   std::string HostPort;
 
+  ConnectionSettings Settings;
+#ifndef _WIN32
+  std::unique_ptr<MessageSpool> Spool;
+  double SpoolDrainTokens{0};
+  std::chrono::steady_clock::time_point LastSpoolDrain;
+#endif
+
+  std::once_flag Started;
   std::thread AsioThread;
-  moodycamel::BlockingConcurrentQueue<std::function<std::string(void)>>
-      LogMessages;
+  moodycamel::BlockingConcurrentQueue<QueuedMessage> LogMessages;
+
+  std::atomic<std::uint64_t> MessagesSent{0};
+  std::atomic<std::uint64_t> BytesSent{0};
+  std::atomic<std::uint64_t> MessagesDropped{0};
+  std::atomic<std::uint64_t> Reconnects{0};
+  /// \brief Messages in the send buffers that have not yet been written.
+  std::atomic<std::uint64_t> UnwrittenMessages{0};
+  /// \brief Nanoseconds spent in each state, excluding the current one.
+  std::array<std::atomic<std::int64_t>, 4> TimeInState{};
+  /// \brief Time (since the clock epoch, in ns) of the last state change.
+  std::atomic<std::int64_t> LastStateChange{0};
+  AtomicHistogram WriteSizes;
+  AtomicHistogram Latency;
+
+  struct StateCallback {
+    GraylogConnection::StateChangeCallback Callback;
+    GraylogConnection::CallbackExecutor Executor;
+  };
+  std::mutex CallbacksMutex;
+  std::map<size_t, StateCallback> StateCallbacks;
+  size_t NextCallbackId{0};
 
 private:
   const size_t MessageAdditionLimit{3000};
-  void resolverHandler(const asio::error_code &Error,
+  void doAddressQuery(Session &CSession);
+  void resolverHandler(Session &CSession, const asio::error_code &Error,
                        asio::ip::tcp::resolver::iterator EndpointIter);
-  void connectHandler(const asio::error_code &Error,
-                      const QueryResult &AllEndpoints);
-  void sentMessageHandler(const asio::error_code &Error, std::size_t BytesSent);
-  void receiveHandler(const asio::error_code &Error, std::size_t BytesReceived);
-  void trySendMessage();
-  void waitForMessage();
-  void doAddressQuery();
-  void reConnect(ReconnectDelay Delay);
-  void tryConnect(QueryResult AllEndpoints);
+  void tryConnect(Session &CSession);
+  void connectHandler(Session &CSession, const asio::error_code &Error);
+  void receiveHandler(Session &CSession, const asio::error_code &Error);
+  void reConnect(Session &CSession);
+  /// \brief Close the socket of a session and hand its unsent messages over
+  /// to the other sessions.
+  /// \param[in] BytesWritten Number of bytes of the write buffer known to
+  /// have been written.
+  void connectionFailed(Session &CSession, size_t BytesWritten = 0);
+  void startWrite(Session &CSession);
+  void continueWrite(Session &CSession);
+  void writeHandler(Session &CSession, const asio::error_code &Error,
+                    std::size_t BytesSent);
+  /// \brief The connected session with the fewest outstanding bytes.
+  Session *leastLoadedSession();
+  void scheduleDispatch();
+  /// \brief Distribute queued messages to the connected sessions.
+  void dispatchMessages();
 
   typedef std::unique_ptr<asio::io_service::work> WorkPtr;
 
-  std::array<std::uint8_t, 64> InputBuffer{};
   asio::io_service Service;
   WorkPtr Work;
-  asio::ip::tcp::socket Socket;
-  asio::ip::tcp::resolver Resolver;
-  asio::system_timer ReconnectTimeout;
+  std::vector<std::unique_ptr<Session>> Sessions;
+  /// \brief Messages of failed sessions, to be sent by another session.
+  std::vector<char> OrphanedMessages;
+  std::vector<MessageRecord> OrphanedRecords;
+
+  /// \brief A flush request, resolved once all messages with a lower
+  /// sequence number have been written.
+  struct FlushTicket {
+    std::uint64_t Sequence;
+    std::shared_ptr<std::promise<void>> Done;
+  };
+  std::vector<FlushTicket> PendingFlushes;
+  std::uint64_t NextSequence{0};
+  /// \brief All messages with a lower sequence number have been written.
+  std::uint64_t FirstIncomplete{0};
+  /// \brief Completion of the messages starting at FirstIncomplete.
+  std::deque<bool> CompletedSequences;
+  /// \brief Used for polling the socket send queues when waiting for them to
+  /// drain.
+  asio::steady_timer FlushTimer;
+  bool DispatchScheduled{false};
+  std::minstd_rand RandomGenerator;
 };
 
 } // namespace Log
@@ -0,0 +1,482 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implements the networking code for sending GELF messages to a
+/// graylog server using HTTP.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GraylogHttpConnection.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ciso646>
+#include <cstdlib>
+#include <utility>
+
+namespace Log {
+
+using std::chrono_literals::operator""ms;
+using std::chrono_literals::operator""s;
+
+namespace {
+/// \brief Delay before a failed request is re-sent, multiplied by the number
+/// of times the request has been retried.
+const auto RetryDelay = 100ms;
+
+std::string toLower(std::string Text) {
+  std::transform(Text.begin(), Text.end(), Text.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return Text;
+}
+} // namespace
+
+HttpResponseHeader parseHttpResponseHeader(const std::string &Header) {
+  HttpResponseHeader Result;
+  auto Lines = toLower(Header);
+  if (Lines.compare(0, 5, "http/") != 0) {
+    return Result;
+  }
+  auto StatusStart = Lines.find(' ');
+  if (StatusStart == std::string::npos) {
+    return Result;
+  }
+  Result.StatusCode = std::atoi(Lines.c_str() + StatusStart + 1);
+  // HTTP/1.0 connections are closed unless explicitly kept alive.
+  Result.Close = Lines.compare(0, 8, "http/1.0") == 0;
+  size_t LineStart = Lines.find("\r\n");
+  while (LineStart != std::string::npos) {
+    LineStart += 2;
+    auto LineEnd = Lines.find("\r\n", LineStart);
+    auto Line = Lines.substr(LineStart, LineEnd - LineStart);
+    auto Separator = Line.find(':');
+    if (Separator != std::string::npos) {
+      auto Name = Line.substr(0, Separator);
+      auto Value = Line.substr(Separator + 1);
+      Value.erase(0, Value.find_first_not_of(" \t"));
+      if (Name == "content-length") {
+        Result.ContentLength = std::strtoull(Value.c_str(), nullptr, 10);
+      } else if (Name == "transfer-encoding") {
+        Result.Chunked = Value.find("chunked") != std::string::npos;
+      } else if (Name == "connection") {
+        Result.Close = Value.find("close") != std::string::npos;
+      }
+    }
+    LineStart = LineEnd;
+  }
+  return Result;
+}
+
+GraylogHttpConnection::Impl::Impl(std::string Host, int Port,
+                                  size_t MaxQueueLength, HttpSettings Settings)
+    : HostAddress(std::move(Host)), HostPort(std::to_string(Port)),
+      Settings(std::move(Settings)), Compressor(this->Settings.Compression),
+      LogMessages(MaxQueueLength), Service(),
+      Work(std::make_unique<asio::io_service::work>(Service)), Socket(Service),
+      Resolver(Service), ReconnectTimeout(Service), SendTimer(Service),
+      ResponseTimer(Service) {
+  this->Settings.MaxMessagesPerRequest =
+      std::max<size_t>(1, this->Settings.MaxMessagesPerRequest);
+  this->Settings.MaxRequestsInFlight =
+      std::max<size_t>(1, this->Settings.MaxRequestsInFlight);
+  RequestHeaderPrefix = "POST " + this->Settings.Path +
+                        " HTTP/1.1\r\nHost: " + HostAddress + ":" + HostPort +
+                        "\r\nContent-Type: application/json\r\n";
+  if (not this->Settings.ConnectOnFirstUse) {
+    start();
+  }
+}
+
+void GraylogHttpConnection::Impl::start() {
+  std::call_once(Started, [this]() {
+    doAddressQuery();
+    AsioThread =
+        std::thread(&GraylogHttpConnection::Impl::threadFunction, this);
+  });
+}
+
+GraylogHttpConnection::Impl::~Impl() {
+  Service.stop();
+  if (AsioThread.joinable()) {
+    AsioThread.join();
+  }
+  try {
+    Socket.close();
+  } catch (asio::system_error &) {
+    // Do nothing
+  }
+}
+
+void GraylogHttpConnection::Impl::doAddressQuery() {
+  setState(Status::ADDR_LOOKUP);
+  asio::ip::tcp::resolver::query Query(HostAddress, HostPort);
+  auto HandlerGlue = [this](auto &Error, auto EndpointIter) {
+    this->resolverHandler(Error, EndpointIter);
+  };
+  Resolver.async_resolve(Query, HandlerGlue);
+}
+
+void GraylogHttpConnection::Impl::resolverHandler(
+    const asio::error_code &Error,
+    asio::ip::tcp::resolver::iterator EndpointIter) {
+  if (Error) {
+    reConnect(ReconnectDelay::LONG);
+    return;
+  }
+  Endpoints.clear();
+  for (; EndpointIter != asio::ip::tcp::resolver::iterator(); ++EndpointIter) {
+    Endpoints.push_back(*EndpointIter);
+  }
+  std::stable_sort(Endpoints.begin(), Endpoints.end(), [](auto &a, auto &b) {
+    return a.address().is_v6() < b.address().is_v6();
+  });
+  NextEndpoint = 0;
+  tryConnect();
+}
+
+void GraylogHttpConnection::Impl::tryConnect() {
+  if (NextEndpoint >= Endpoints.size()) {
+    reConnect(ReconnectDelay::LONG);
+    return;
+  }
+  setState(Status::CONNECT);
+  auto HandlerGlue = [this](auto &Error) { this->connectHandler(Error); };
+  Socket.async_connect(Endpoints[NextEndpoint++], HandlerGlue);
+}
+
+void GraylogHttpConnection::Impl::connectHandler(
+    const asio::error_code &Error) {
+  asio::error_code Ignored;
+  if (Error) {
+    Socket.close(Ignored);
+    tryConnect();
+    return;
+  }
+  Socket.set_option(asio::ip::tcp::no_delay(true), Ignored);
+  ResponseBuffer.consume(ResponseBuffer.size());
+  setState(Status::SEND_LOOP);
+  trySendRequests();
+}
+
+void GraylogHttpConnection::Impl::reConnect(ReconnectDelay Delay) {
+  auto HandlerGlue = [this](auto & /* Err */) { this->doAddressQuery(); };
+  switch (Delay) {
+  case ReconnectDelay::SHORT:
+    ReconnectTimeout.expires_after(100ms);
+    break;
+  case ReconnectDelay::LONG: // Fallthrough
+  default:
+    ReconnectTimeout.expires_after(10s);
+    break;
+  }
+  ReconnectTimeout.async_wait(HandlerGlue);
+  setState(Status::ADDR_RETRY_WAIT);
+}
+
+void GraylogHttpConnection::Impl::connectionFailed() {
+  ++ConnectionId;
+  asio::error_code Ignored;
+  Socket.close(Ignored);
+  SendTimer.cancel(Ignored);
+  ResponseTimer.cancel(Ignored);
+  Writing = false;
+  Reading = false;
+  // Requests that were not responded to may or may not have been received
+  // by the server. They are re-sent, which can cause duplicates.
+  while (not InFlight.empty()) {
+    PendingRequests.push_front(std::move(InFlight.back()));
+    InFlight.pop_back();
+  }
+  reConnect(ReconnectDelay::SHORT);
+}
+
+void GraylogHttpConnection::Impl::sendLater(
+    std::chrono::steady_clock::duration Delay) {
+  // Re-arming the timer cancels the previous wait, which guarantees that
+  // there is at most one pending delayed call.
+  SendTimer.expires_after(Delay);
+  SendTimer.async_wait([this](auto &Error) {
+    if (not Error) {
+      this->trySendRequests();
+    }
+  });
+}
+
+void GraylogHttpConnection::Impl::trySendRequests() {
+  if (not Socket.is_open() or Writing or
+      InFlight.size() >= Settings.MaxRequestsInFlight) {
+    // The completion of the ongoing write or the next response will call
+    // this function again.
+    return;
+  }
+  if (PendingRequests.empty()) {
+    // Only block the thread when there are no responses to wait for.
+    createRequest(InFlight.empty());
+  }
+  if (PendingRequests.empty()) {
+    sendLater(InFlight.empty() ? 0ms : 1ms);
+    return;
+  }
+  auto Now = std::chrono::steady_clock::now();
+  auto NextRequest = PendingRequests.front();
+  if (NextRequest->NotBefore > Now) {
+    sendLater(NextRequest->NotBefore - Now);
+    return;
+  }
+  PendingRequests.pop_front();
+  writeRequest(NextRequest);
+}
+
+void GraylogHttpConnection::Impl::createRequest(bool WaitForMessages) {
+  std::function<std::string(void)> MessageFunc;
+  bool GotMessage = WaitForMessages
+                        ? LogMessages.wait_dequeue_timed(MessageFunc, 10ms)
+                        : LogMessages.try_dequeue(MessageFunc);
+  std::string Body;
+  size_t NrOfMessages{0};
+  while (GotMessage) {
+    auto Message = MessageFunc();
+    if (not Message.empty()) {
+      if (NrOfMessages > 0) {
+        Body.push_back('\n');
+      }
+      Body.append(Message);
+      ++NrOfMessages;
+    }
+    if (NrOfMessages >= Settings.MaxMessagesPerRequest or
+        Body.size() >= Settings.MaxBytesPerRequest) {
+      break;
+    }
+    GotMessage = LogMessages.try_dequeue(MessageFunc);
+  }
+  if (NrOfMessages > 0) {
+    auto NewRequest = std::make_shared<Request>();
+    NewRequest->Sequence = NextSequence++;
+    NewRequest->NrOfMessages = NrOfMessages;
+    bool Compressed = Compressor.compress(Body, NewRequest->Body);
+    if (not Compressed) {
+      NewRequest->Body = std::move(Body);
+    }
+    NewRequest->Header = createHeader(NewRequest->Body.size(), Compressed);
+    PendingRequests.push_back(NewRequest);
+  }
+  // Flush requests are resolved once the last request created so far has
+  // been completed.
+  for (auto &Flush : NewFlushes) {
+    Flushes.emplace_back(NextSequence - 1, std::move(Flush));
+  }
+  NewFlushes.clear();
+  resolveFlushes();
+}
+
+std::string GraylogHttpConnection::Impl::createHeader(size_t BodySize,
+                                                      bool Compressed) const {
+  auto Header = RequestHeaderPrefix;
+  Header += "Content-Length: " + std::to_string(BodySize) + "\r\n";
+  if (Compressed) {
+    Header += Settings.Compression.Type == Compression::Gzip
+                  ? "Content-Encoding: gzip\r\n"
+                  : "Content-Encoding: deflate\r\n";
+  }
+  Header += "\r\n";
+  return Header;
+}
+
+void GraylogHttpConnection::Impl::writeRequest(const RequestPtr &NewRequest) {
+  Writing = true;
+  InFlight.push_back(NewRequest);
+  if (InFlight.size() == 1) {
+    armResponseTimer();
+  }
+  std::array<asio::const_buffer, 2> Buffers{
+      {asio::buffer(NewRequest->Header), asio::buffer(NewRequest->Body)}};
+  // The request is captured to keep the buffers alive until the write
+  // has completed.
+  auto HandlerGlue = [this, NewRequest, Id = ConnectionId](auto &Error,
+                                                           auto /* Size */) {
+    if (Id != ConnectionId) {
+      return;
+    }
+    Writing = false;
+    if (Error) {
+      connectionFailed();
+      return;
+    }
+    trySendRequests();
+  };
+  asio::async_write(Socket, Buffers, HandlerGlue);
+  if (not Reading) {
+    readResponse();
+  }
+}
+
+void GraylogHttpConnection::Impl::readResponse() {
+  Reading = true;
+  auto HandlerGlue = [this, Id = ConnectionId](auto &Error, auto Size) {
+    if (Id == ConnectionId) {
+      this->responseHeaderHandler(Error, Size);
+    }
+  };
+  asio::async_read_until(Socket, ResponseBuffer, "\r\n\r\n", HandlerGlue);
+}
+
+void GraylogHttpConnection::Impl::responseHeaderHandler(
+    const asio::error_code &Error, std::size_t Size) {
+  if (Error or InFlight.empty()) {
+    connectionFailed();
+    return;
+  }
+  auto Begin = asio::buffers_begin(ResponseBuffer.data());
+  auto Response = parseHttpResponseHeader(std::string(Begin, Begin + Size));
+  ResponseBuffer.consume(Size);
+  if (Response.StatusCode == 0) {
+    connectionFailed();
+    return;
+  }
+  if (Response.Chunked) {
+    readChunk(Response);
+    return;
+  }
+  skipBytes(Response.ContentLength,
+            [this, Response]() { this->responseComplete(Response); });
+}
+
+void GraylogHttpConnection::Impl::readChunk(
+    const HttpResponseHeader &Response) {
+  auto HandlerGlue = [this, Response, Id = ConnectionId](auto &Error,
+                                                         auto Size) {
+    if (Id != ConnectionId) {
+      return;
+    }
+    if (Error) {
+      connectionFailed();
+      return;
+    }
+    auto Begin = asio::buffers_begin(ResponseBuffer.data());
+    auto ChunkSize =
+        std::strtoull(std::string(Begin, Begin + Size).c_str(), nullptr, 16);
+    ResponseBuffer.consume(Size);
+    if (ChunkSize == 0) {
+      // The last chunk is followed by an empty line (trailers are not
+      // supported).
+      skipBytes(2, [this, Response]() { this->responseComplete(Response); });
+      return;
+    }
+    skipBytes(ChunkSize + 2, [this, Response]() { this->readChunk(Response); });
+  };
+  asio::async_read_until(Socket, ResponseBuffer, "\r\n", HandlerGlue);
+}
+
+void GraylogHttpConnection::Impl::skipBytes(size_t Size,
+                                            std::function<void()> Then) {
+  if (ResponseBuffer.size() >= Size) {
+    ResponseBuffer.consume(Size);
+    Then();
+    return;
+  }
+  auto HandlerGlue = [this, Size, Then, Id = ConnectionId](auto &Error,
+                                                           auto /* Read */) {
+    if (Id != ConnectionId) {
+      return;
+    }
+    if (Error) {
+      connectionFailed();
+      return;
+    }
+    ResponseBuffer.consume(Size);
+    Then();
+  };
+  asio::async_read(Socket, ResponseBuffer,
+                   asio::transfer_exactly(Size - ResponseBuffer.size()),
+                   HandlerGlue);
+}
+
+void GraylogHttpConnection::Impl::responseComplete(
+    const HttpResponseHeader &Response) {
+  Reading = false;
+  auto Completed = InFlight.front();
+  InFlight.pop_front();
+  auto Code = Response.StatusCode;
+  if (Code >= 200 and Code < 300) {
+    // Accepted
+  } else if ((Code >= 500 or Code == 408 or Code == 429) and
+             Completed->Retries < Settings.MaxRetries) {
+    ++Completed->Retries;
+    ++RequestsRetried;
+    Completed->NotBefore =
+        std::chrono::steady_clock::now() + RetryDelay * Completed->Retries;
+    PendingRequests.push_front(Completed);
+  } else {
+    MessagesDropped += Completed->NrOfMessages;
+  }
+  resolveFlushes();
+  if (Response.Close) {
+    connectionFailed();
+    return;
+  }
+  if (InFlight.empty()) {
+    asio::error_code Ignored;
+    ResponseTimer.cancel(Ignored);
+  } else {
+    armResponseTimer();
+    readResponse();
+  }
+  trySendRequests();
+}
+
+void GraylogHttpConnection::Impl::armResponseTimer() {
+  ResponseTimer.expires_after(Settings.ResponseTimeout);
+  ResponseTimer.async_wait([this, Id = ConnectionId](auto &Error) {
+    if (not Error and Id == ConnectionId) {
+      this->connectionFailed();
+    }
+  });
+}
+
+void GraylogHttpConnection::Impl::resolveFlushes() {
+  auto LowestOutstanding = NextSequence;
+  for (auto &Outstanding : PendingRequests) {
+    LowestOutstanding = std::min(LowestOutstanding, Outstanding->Sequence);
+  }
+  for (auto &Outstanding : InFlight) {
+    LowestOutstanding = std::min(LowestOutstanding, Outstanding->Sequence);
+  }
+  auto IsDone = [LowestOutstanding](auto &Flush) {
+    if (Flush.first < LowestOutstanding) {
+      Flush.second->set_value();
+      return true;
+    }
+    return false;
+  };
+  Flushes.erase(std::remove_if(Flushes.begin(), Flushes.end(), IsDone),
+                Flushes.end());
+}
+
+GraylogHttpConnection::Impl::Status
+GraylogHttpConnection::Impl::getConnectionStatus() const {
+  return ConnectionState.load(std::memory_order_relaxed);
+}
+
+void GraylogHttpConnection::Impl::threadFunction() { Service.run(); }
+
+void GraylogHttpConnection::Impl::setState(Status NewState) {
+  ConnectionState.store(NewState, std::memory_order_relaxed);
+}
+
+bool GraylogHttpConnection::Impl::flush(
+    std::chrono::system_clock::duration TimeOut) {
+  start();
+  auto WorkDone = std::make_shared<std::promise<void>>();
+  auto WorkDoneFuture = WorkDone->get_future();
+  // Queued even if the queue is full, so that the flush is resolved after
+  // the messages queued before it.
+  LogMessages.enqueue([this, WorkDone]() -> std::string {
+    NewFlushes.push_back(WorkDone);
+    return {};
+  });
+  return std::future_status::ready == WorkDoneFuture.wait_for(TimeOut);
+}
+
+} // namespace Log
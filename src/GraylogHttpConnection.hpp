@@ -0,0 +1,160 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Header file of the HTTP networking code.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "GelfCompressor.hpp"
+#include "graylog_logger/GraylogHttpInterface.hpp"
+#include <asio.hpp>
+#include <atomic>
+#include <ciso646>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <moodycamel/blockingconcurrentqueue.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Log {
+
+/// \brief The parts of a HTTP response header used by the HTTP transport.
+struct HttpResponseHeader {
+  /// \brief Zero if the status line could not be parsed.
+  int StatusCode{0};
+  size_t ContentLength{0};
+  bool Chunked{false};
+  /// \brief The server will close the connection after the response.
+  bool Close{false};
+};
+
+/// \brief Parse a HTTP/1.x response header (status line and header fields).
+HttpResponseHeader parseHttpResponseHeader(const std::string &Header);
+
+class GraylogHttpConnection::Impl {
+public:
+  using Status = Log::Status;
+  Impl(std::string Host, int Port, size_t MaxQueueLength,
+       HttpSettings Settings);
+  virtual ~Impl();
+  virtual void sendMessage(std::string Msg) {
+    start();
+    auto MsgFunc = [=]() { return Msg; };
+    if (not LogMessages.try_enqueue(MsgFunc)) {
+      ++MessagesDropped;
+    }
+  }
+  virtual void
+  sendDeferredMessage(std::function<std::string(void)> MessageCreator) {
+    start();
+    if (not LogMessages.try_enqueue(std::move(MessageCreator))) {
+      ++MessagesDropped;
+    }
+  }
+  Status getConnectionStatus() const;
+  virtual bool flush(std::chrono::system_clock::duration TimeOut);
+  virtual size_t queueSize() { return LogMessages.size_approx(); }
+  size_t messagesDropped() const { return MessagesDropped.load(); }
+  size_t requestsRetried() const { return RequestsRetried.load(); }
+  CompressionStatistics compressionStatistics() const {
+    return Compressor.statistics();
+  }
+
+protected:
+  enum class ReconnectDelay { LONG, SHORT };
+  struct Request {
+    std::uint64_t Sequence{0};
+    std::string Header;
+    std::string Body;
+    size_t NrOfMessages{0};
+    int Retries{0};
+    std::chrono::steady_clock::time_point NotBefore;
+  };
+  using RequestPtr = std::shared_ptr<Request>;
+  using FlushPromise = std::shared_ptr<std::promise<void>>;
+
+  /// \brief Look up the address of the server and start the thread of the
+  /// connection, unless already done.
+  void start();
+  void threadFunction();
+  void setState(Status NewState);
+
+  std::atomic<Status> ConnectionState{Status::ADDR_LOOKUP};
+  std::atomic<size_t> MessagesDropped{0};
+  std::atomic<size_t> RequestsRetried{0};
+
+  std::string HostAddress;
+  std::string HostPort;
+  HttpSettings Settings;
+  GelfCompressor Compressor;
+
+  std::once_flag Started;
+  std::thread AsioThread;
+  moodycamel::BlockingConcurrentQueue<std::function<std::string(void)>>
+      LogMessages;
+
+private:
+  void doAddressQuery();
+  void resolverHandler(const asio::error_code &Error,
+                       asio::ip::tcp::resolver::iterator EndpointIter);
+  void tryConnect();
+  void connectHandler(const asio::error_code &Error);
+  void reConnect(ReconnectDelay Delay);
+  void connectionFailed();
+
+  void trySendRequests();
+  void sendLater(std::chrono::steady_clock::duration Delay);
+  void createRequest(bool WaitForMessages);
+  std::string createHeader(size_t BodySize, bool Compressed) const;
+  void writeRequest(const RequestPtr &NewRequest);
+
+  void readResponse();
+  void responseHeaderHandler(const asio::error_code &Error, std::size_t Size);
+  void readChunk(const HttpResponseHeader &Response);
+  void skipBytes(size_t Size, std::function<void()> Then);
+  void responseComplete(const HttpResponseHeader &Response);
+  void armResponseTimer();
+  void resolveFlushes();
+
+  std::vector<asio::ip::tcp::endpoint> Endpoints;
+  size_t NextEndpoint{0};
+
+  /// \brief Incremented when the connection is closed so that completion
+  /// handlers of operations on the old connection can be ignored.
+  std::uint64_t ConnectionId{0};
+  bool Writing{false};
+  bool Reading{false};
+
+  /// \brief Requests waiting to be (re-)sent.
+  std::deque<RequestPtr> PendingRequests;
+  /// \brief Requests sent but not yet responded to, in the order sent.
+  std::deque<RequestPtr> InFlight;
+  std::uint64_t NextSequence{1};
+  /// \brief Flush requests dequeued but not yet assigned to a request.
+  std::vector<FlushPromise> NewFlushes;
+  /// \brief Flush requests and the sequence number of the last request that
+  /// has to be completed before they are resolved.
+  std::vector<std::pair<std::uint64_t, FlushPromise>> Flushes;
+
+  std::string RequestHeaderPrefix;
+  asio::streambuf ResponseBuffer;
+
+  typedef std::unique_ptr<asio::io_service::work> WorkPtr;
+  asio::io_service Service;
+  WorkPtr Work;
+  asio::ip::tcp::socket Socket;
+  asio::ip::tcp::resolver Resolver;
+  asio::steady_timer ReconnectTimeout;
+  asio::steady_timer SendTimer;
+  asio::steady_timer ResponseTimer;
+};
+
+} // namespace Log
@@ -0,0 +1,86 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief The interface implementation for sending messages to a graylog
+/// server using HTTP.
+///
+//===----------------------------------------------------------------------===//
+
+#include "graylog_logger/GraylogHttpInterface.hpp"
+#include "GelfSerializer.hpp"
+#include "GraylogHttpConnection.hpp"
+#include <ciso646>
+
+namespace Log {
+
+GraylogHttpConnection::GraylogHttpConnection(std::string Host, int Port,
+                                             size_t MaxQueueSize,
+                                             HttpSettings Settings)
+    : Pimpl(std::make_unique<GraylogHttpConnection::Impl>(
+          std::move(Host), Port, MaxQueueSize, std::move(Settings))) {}
+
+GraylogHttpConnection::~GraylogHttpConnection() = default;
+
+void GraylogHttpConnection::sendMessage(std::string Msg) {
+  Pimpl->sendMessage(std::move(Msg));
+}
+
+void GraylogHttpConnection::sendDeferredMessage(
+    std::function<std::string(void)> MessageCreator) {
+  Pimpl->sendDeferredMessage(std::move(MessageCreator));
+}
+
+bool GraylogHttpConnection::flush(
+    std::chrono::system_clock::duration TimeOut) {
+  return Pimpl->flush(TimeOut);
+}
+
+Status GraylogHttpConnection::getConnectionStatus() const {
+  return Pimpl->getConnectionStatus();
+}
+
+bool GraylogHttpConnection::messageQueueEmpty() {
+  return Pimpl->queueSize() == 0;
+}
+
+size_t GraylogHttpConnection::messageQueueSize() { return Pimpl->queueSize(); }
+
+size_t GraylogHttpConnection::messagesDropped() const {
+  return Pimpl->messagesDropped();
+}
+
+size_t GraylogHttpConnection::requestsRetried() const {
+  return Pimpl->requestsRetried();
+}
+
+CompressionStatistics GraylogHttpConnection::compressionStatistics() const {
+  return Pimpl->compressionStatistics();
+}
+
+GraylogHttpInterface::GraylogHttpInterface(const std::string &Host,
+                                           const int Port,
+                                           const size_t MaxQueueLength,
+                                           HttpSettings Settings)
+    : GraylogHttpConnection(Host, Port, MaxQueueLength, std::move(Settings)) {}
+
+GraylogHttpInterface::~GraylogHttpInterface() = default;
+
+void GraylogHttpInterface::addMessage(const LogMessage &Message) {
+  sendMessage(serializeOnThisThread(Message));
+}
+
+void GraylogHttpInterface::addSharedMessage(const LogMessage_P &Message) {
+  sendDeferredMessage([Message]() { return serializeOnThisThread(*Message); });
+}
+
+bool GraylogHttpInterface::flush(std::chrono::system_clock::duration TimeOut) {
+  return GraylogHttpConnection::flush(TimeOut);
+}
+
+bool GraylogHttpInterface::emptyQueue() { return messageQueueEmpty(); }
+
+size_t GraylogHttpInterface::queueSize() { return messageQueueSize(); }
+
+} // namespace Log
@@ -9,26 +9,47 @@
 //===----------------------------------------------------------------------===//
 
 #include "graylog_logger/GraylogInterface.hpp"
+#include "GelfSerializer.hpp"
 #include "GraylogConnection.hpp"
+#include <algorithm>
 #include <ciso646>
 #include <cstring>
-#include <nlohmann/json.hpp>
 
 namespace Log {
 
 GraylogConnection::GraylogConnection(std::string Host, int Port,
-                                     size_t MaxQueueSize)
-    : Pimpl(std::make_unique<GraylogConnection::Impl>(std::move(Host), Port,
-                                                      MaxQueueSize)) {}
+                                     size_t MaxQueueSize,
+                                     ConnectionSettings Settings) {
+  // In the body, as SettingsDiffer is initialised after Pimpl.
+  Pimpl = GraylogConnection::Impl::acquire(std::move(Host), Port, MaxQueueSize,
+                                           std::move(Settings), SettingsDiffer);
+}
 
 void GraylogConnection::sendMessage(std::string Msg) {
+  if (ShutDown.load(std::memory_order_relaxed)) {
+    return;
+  }
   Pimpl->sendMessage(std::move(Msg));
 }
 
+void GraylogConnection::sendDeferredMessage(
+    std::function<std::string(void)> MessageCreator) {
+  if (ShutDown.load(std::memory_order_relaxed)) {
+    return;
+  }
+  Pimpl->sendDeferredMessage(std::move(MessageCreator));
+}
+
 bool GraylogConnection::flush(std::chrono::system_clock::duration TimeOut) {
   return Pimpl->flush(TimeOut);
 }
 
+ShutdownReport
+GraylogConnection::shutdown(std::chrono::system_clock::duration TimeOut) {
+  ShutDown.store(true, std::memory_order_relaxed);
+  return Pimpl->shutdown(TimeOut);
+}
+
 Status GraylogConnection::getConnectionStatus() const {
   return Pimpl->getConnectionStatus();
 }
@@ -37,49 +58,66 @@ bool GraylogConnection::messageQueueEmpty() { return Pimpl->queueSize() == 0; }
 
 size_t GraylogConnection::messageQueueSize() { return Pimpl->queueSize(); }
 
-GraylogConnection::~GraylogConnection() = default;
+size_t GraylogConnection::spoolSize() const { return Pimpl->spoolSize(); }
+
+ConnectionMetrics GraylogConnection::metrics() const {
+  auto Result = Pimpl->metrics();
+  Result.SharedWithDifferentSettings = SettingsDiffer;
+  return Result;
+}
+
+size_t GraylogConnection::addStateChangeCallback(StateChangeCallback Callback,
+                                                 CallbackExecutor Executor) {
+  auto Id = Pimpl->addStateChangeCallback(std::move(Callback),
+                                          std::move(Executor));
+  CallbackIds.push_back(Id);
+  return Id;
+}
+
+void GraylogConnection::removeStateChangeCallback(size_t CallbackId) {
+  CallbackIds.erase(
+      std::remove(CallbackIds.begin(), CallbackIds.end(), CallbackId),
+      CallbackIds.end());
+  Pimpl->removeStateChangeCallback(CallbackId);
+}
+
+GraylogConnection::~GraylogConnection() {
+  // The connection may be shared with other instances.
+  for (auto Id : CallbackIds) {
+    Pimpl->removeStateChangeCallback(Id);
+  }
+}
 
 GraylogInterface::GraylogInterface(const std::string &Host, const int Port,
-                                   const size_t MaxQueueLength)
-    : GraylogConnection(Host, Port, MaxQueueLength) {}
+                                   const size_t MaxQueueLength,
+                                   ConnectionSettings Settings)
+    : GraylogConnection(Host, Port, MaxQueueLength, std::move(Settings)) {}
+
+GraylogInterface::~GraylogInterface() = default;
 
 void GraylogInterface::addMessage(const LogMessage &Message) {
   sendMessage(logMsgToJSON(Message));
 }
 
+void GraylogInterface::addSharedMessage(const LogMessage_P &Message) {
+  // The message is normally serialised on the thread of the connection but
+  // is serialised on the calling thread if it is spooled.
+  sendDeferredMessage([Message]() { return logMsgToJSON(*Message); });
+}
+
 std::string GraylogInterface::logMsgToJSON(const LogMessage &Message) {
-  using std::chrono::duration_cast;
-  using std::chrono::milliseconds;
-
-  nlohmann::json JsonObject;
-  JsonObject["short_message"] = Message.MessageString;
-  JsonObject["version"] = "1.1";
-  JsonObject["level"] = int(Message.SeverityLevel);
-  JsonObject["host"] = Message.Host;
-  JsonObject["timestamp"] =
-      static_cast<double>(
-          duration_cast<milliseconds>(Message.Timestamp.time_since_epoch())
-              .count()) /
-      1000;
-  JsonObject["_process_id"] = Message.ProcessId;
-  JsonObject["_process"] = Message.ProcessName;
-  JsonObject["_thread_id"] = Message.ThreadId;
-  for (auto &field : Message.AdditionalFields) {
-    if (AdditionalField::Type::typeStr == field.second.FieldType) {
-      JsonObject["_" + field.first] = field.second.strVal;
-    } else if (AdditionalField::Type::typeDbl == field.second.FieldType) {
-      JsonObject["_" + field.first] = field.second.dblVal;
-    } else if (AdditionalField::Type::typeInt == field.second.FieldType) {
-      JsonObject["_" + field.first] = field.second.intVal;
-    }
-  }
-  return JsonObject.dump();
+  return serializeOnThisThread(Message);
 }
 
 bool GraylogInterface::flush(std::chrono::system_clock::duration TimeOut) {
   return GraylogConnection::flush(TimeOut);
 }
 
+ShutdownReport
+GraylogInterface::shutdown(std::chrono::system_clock::duration TimeOut) {
+  return GraylogConnection::shutdown(TimeOut);
+}
+
 bool GraylogInterface::emptyQueue() { return messageQueueEmpty(); }
 
 size_t GraylogInterface::queueSize() { return messageQueueSize(); }
@@ -0,0 +1,304 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implements the networking code for sending GELF messages to a
+/// graylog server using UDP.
+///
+//===----------------------------------------------------------------------===//
+
+#include "GraylogUdpConnection.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ciso646>
+#include <random>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace Log {
+
+using std::chrono_literals::operator""ms;
+
+namespace {
+// Limits the amount of work done before checking for flush requests and
+// shutdown.
+const size_t MaxMessagesPerBatch{64};
+const auto ResolveRetryDelay = 1000ms;
+const size_t ChunkHeaderSize{std::tuple_size<GelfChunkHeader>::value};
+
+std::uint64_t splitMix64(std::uint64_t Value) {
+  Value += 0x9e3779b97f4a7c15ULL;
+  Value = (Value ^ (Value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  Value = (Value ^ (Value >> 27)) * 0x94d049bb133111ebULL;
+  return Value ^ (Value >> 31);
+}
+} // namespace
+
+GraylogUdpConnection::Impl::Impl(std::string Host, int Port,
+                                 size_t MaxQueueLength, size_t MaxDatagramSize,
+                                 CompressionSettings Compression,
+                                 bool ConnectOnFirstUse)
+    : HostAddress(std::move(Host)), HostPort(std::to_string(Port)),
+      MaxDatagramSize(std::max(MaxDatagramSize, ChunkHeaderSize + 1)),
+      Compressor(Compression),
+      LogMessages(MaxQueueLength), Service(), Socket(Service) {
+  std::random_device Device;
+  MessageIdSeed = (std::uint64_t(Device()) << 32) | Device();
+  if (not ConnectOnFirstUse) {
+    start();
+  }
+}
+
+void GraylogUdpConnection::Impl::start() {
+  std::call_once(Started, [this]() {
+    SendThread =
+        std::thread(&GraylogUdpConnection::Impl::threadFunction, this);
+  });
+}
+
+GraylogUdpConnection::Impl::~Impl() {
+  RunThread = false;
+  if (SendThread.joinable()) {
+    SendThread.join();
+  }
+  try {
+    Socket.close();
+  } catch (asio::system_error &) {
+    // Do nothing
+  }
+}
+
+bool createGelfChunkHeaders(size_t MessageSize, size_t MaxDatagramSize,
+                            std::uint64_t MessageId,
+                            std::vector<GelfChunkHeader> &Headers) {
+  if (MessageSize <= MaxDatagramSize) {
+    return true;
+  }
+  auto const PayloadSize = MaxDatagramSize - ChunkHeaderSize;
+  auto const NrOfChunks = (MessageSize + PayloadSize - 1) / PayloadSize;
+  if (NrOfChunks > GelfMaxChunks) {
+    return false;
+  }
+  for (size_t i = 0; i < NrOfChunks; ++i) {
+    GelfChunkHeader Header{};
+    Header[0] = 0x1e;
+    Header[1] = 0x0f;
+    for (size_t j = 0; j < 8; ++j) {
+      Header[2 + j] = static_cast<std::uint8_t>(MessageId >> (56 - 8 * j));
+    }
+    Header[10] = static_cast<std::uint8_t>(i);
+    Header[11] = static_cast<std::uint8_t>(NrOfChunks);
+    Headers.push_back(Header);
+  }
+  return true;
+}
+
+std::uint64_t GraylogUdpConnection::Impl::nextMessageId() {
+  return splitMix64(MessageIdSeed + ++MessageIdCounter);
+}
+
+bool GraylogUdpConnection::Impl::openSocket() {
+  setState(Status::ADDR_LOOKUP);
+  asio::error_code Error;
+  asio::ip::udp::resolver Resolver(Service);
+  auto Endpoints = Resolver.resolve(HostAddress, HostPort, Error);
+  if (Error) {
+    return false;
+  }
+  std::vector<asio::ip::udp::endpoint> EndpointList;
+  for (auto &Entry : Endpoints) {
+    EndpointList.push_back(Entry.endpoint());
+  }
+  // Prefer IPv4, as is done for TCP.
+  std::stable_sort(EndpointList.begin(), EndpointList.end(),
+                   [](auto &a, auto &b) {
+                     return a.address().is_v6() < b.address().is_v6();
+                   });
+  setState(Status::CONNECT);
+  for (auto &Endpoint : EndpointList) {
+    Socket.open(Endpoint.protocol(), Error);
+    if (Error) {
+      continue;
+    }
+    Socket.connect(Endpoint, Error);
+    if (not Error) {
+      setState(Status::SEND_LOOP);
+      return true;
+    }
+    Socket.close(Error);
+  }
+  return false;
+}
+
+void GraylogUdpConnection::Impl::threadFunction() {
+  while (RunThread) {
+    if (not Socket.is_open() and not openSocket()) {
+      setState(Status::ADDR_RETRY_WAIT);
+      auto RetryTime = std::chrono::steady_clock::now() + ResolveRetryDelay;
+      while (RunThread and std::chrono::steady_clock::now() < RetryTime) {
+        std::this_thread::sleep_for(10ms);
+      }
+      continue;
+    }
+    std::function<std::string(void)> NewMessageFunc;
+    if (not LogMessages.wait_dequeue_timed(NewMessageFunc, 10ms)) {
+      continue;
+    }
+    size_t MessagesInBatch{0};
+    do {
+      addToBatch(NewMessageFunc());
+      ++MessagesInBatch;
+    } while (MessagesInBatch < MaxMessagesPerBatch and
+             LogMessages.try_dequeue(NewMessageFunc));
+    sendBatch();
+  }
+}
+
+void GraylogUdpConnection::Impl::addToBatch(std::string &&Message) {
+  if (Message.empty()) {
+    // Flush markers are resolved by sendBatch().
+    return;
+  }
+  if (Compressor.compress(Message, CompressedMessage)) {
+    Message.swap(CompressedMessage);
+  }
+  auto const MessageIndex = BatchMessages.size();
+  auto const FirstHeader = BatchHeaders.size();
+  if (not createGelfChunkHeaders(Message.size(), MaxDatagramSize,
+                                 nextMessageId(), BatchHeaders)) {
+    ++MessagesDropped;
+    return;
+  }
+  if (FirstHeader == BatchHeaders.size()) {
+    BatchDatagrams.push_back({MessageIndex, 0, Message.size(), NoHeader});
+  } else {
+    auto const PayloadSize = MaxDatagramSize - ChunkHeaderSize;
+    for (auto i = FirstHeader; i < BatchHeaders.size(); ++i) {
+      auto const Offset = (i - FirstHeader) * PayloadSize;
+      auto const Length = std::min(PayloadSize, Message.size() - Offset);
+      BatchDatagrams.push_back({MessageIndex, Offset, Length, i});
+    }
+  }
+  BatchMessages.emplace_back(std::move(Message));
+}
+
+void GraylogUdpConnection::Impl::sendBatch() {
+  size_t DatagramsSent{0};
+  while (DatagramsSent < BatchDatagrams.size()) {
+    auto Result = sendDatagrams(DatagramsSent,
+                                BatchDatagrams.size() - DatagramsSent);
+    if (Result == 0) {
+      break;
+    }
+    DatagramsSent += Result;
+  }
+  if (DatagramsSent < BatchDatagrams.size()) {
+    // Count every message with at least one unsent datagram as dropped.
+    auto FirstLost = BatchDatagrams[DatagramsSent].MessageIndex;
+    MessagesDropped += BatchMessages.size() - FirstLost;
+  }
+  BatchMessages.clear();
+  BatchHeaders.clear();
+  BatchDatagrams.clear();
+  for (auto &Flush : CompletedFlushes) {
+    Flush->set_value();
+  }
+  CompletedFlushes.clear();
+}
+
+#ifdef __linux__
+size_t GraylogUdpConnection::Impl::sendDatagrams(size_t First, size_t Count) {
+  const size_t MaxDatagramsPerCall{512};
+  Count = std::min(Count, MaxDatagramsPerCall);
+  std::vector<iovec> IoVectors(Count * 2);
+  std::vector<mmsghdr> Headers(Count);
+  for (size_t i = 0; i < Count; ++i) {
+    auto &CDatagram = BatchDatagrams[First + i];
+    auto &Message = BatchMessages[CDatagram.MessageIndex];
+    size_t NrOfVectors{0};
+    auto IoVec = &IoVectors[i * 2];
+    if (CDatagram.HeaderIndex != NoHeader) {
+      auto &Header = BatchHeaders[CDatagram.HeaderIndex];
+      IoVec[NrOfVectors].iov_base = Header.data();
+      IoVec[NrOfVectors].iov_len = ChunkHeaderSize;
+      ++NrOfVectors;
+    }
+    IoVec[NrOfVectors].iov_base = &Message[CDatagram.Offset];
+    IoVec[NrOfVectors].iov_len = CDatagram.Length;
+    ++NrOfVectors;
+    Headers[i] = mmsghdr{};
+    Headers[i].msg_hdr.msg_iov = IoVec;
+    Headers[i].msg_hdr.msg_iovlen = NrOfVectors;
+  }
+  int Retries{0};
+  while (true) {
+    auto Result = sendmmsg(Socket.native_handle(), Headers.data(),
+                           static_cast<unsigned int>(Count), 0);
+    if (Result >= 0) {
+      return static_cast<size_t>(Result);
+    }
+    // A previous datagram may have triggered an ICMP error which is reported
+    // on the next send on a connected socket; retry once in that case.
+    if ((errno == EINTR or errno == ECONNREFUSED) and Retries++ < 2) {
+      continue;
+    }
+    return 0;
+  }
+}
+#else
+size_t GraylogUdpConnection::Impl::sendDatagrams(size_t First, size_t Count) {
+  for (size_t i = 0; i < Count; ++i) {
+    auto &CDatagram = BatchDatagrams[First + i];
+    auto &Message = BatchMessages[CDatagram.MessageIndex];
+    std::array<asio::const_buffer, 2> Buffers;
+    size_t NrOfBuffers{0};
+    if (CDatagram.HeaderIndex != NoHeader) {
+      Buffers[NrOfBuffers++] =
+          asio::buffer(BatchHeaders[CDatagram.HeaderIndex]);
+    }
+    Buffers[NrOfBuffers++] =
+        asio::buffer(&Message[CDatagram.Offset], CDatagram.Length);
+    asio::error_code Error;
+    if (NrOfBuffers == 1) {
+      Socket.send(asio::buffer(Buffers[0]), 0, Error);
+    } else {
+      Socket.send(Buffers, 0, Error);
+    }
+    if (Error) {
+      return i;
+    }
+  }
+  return Count;
+}
+#endif
+
+GraylogUdpConnection::Impl::Status
+GraylogUdpConnection::Impl::getConnectionStatus() const {
+  return ConnectionState.load(std::memory_order_relaxed);
+}
+
+void GraylogUdpConnection::Impl::setState(Status NewState) {
+  ConnectionState.store(NewState, std::memory_order_relaxed);
+}
+
+bool GraylogUdpConnection::Impl::flush(
+    std::chrono::system_clock::duration TimeOut) {
+  start();
+  auto WorkDone = std::make_shared<std::promise<void>>();
+  auto WorkDoneFuture = WorkDone->get_future();
+  // Queued even if the queue is full, so that the flush is resolved after
+  // the messages queued before it.
+  LogMessages.enqueue([this, WorkDone]() -> std::string {
+    CompletedFlushes.push_back(WorkDone);
+    return {};
+  });
+  return std::future_status::ready == WorkDoneFuture.wait_for(TimeOut);
+}
+
+} // namespace Log
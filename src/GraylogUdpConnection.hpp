@@ -0,0 +1,122 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Header file of the UDP networking code.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "GelfCompressor.hpp"
+#include "graylog_logger/GraylogUdpInterface.hpp"
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <ciso646>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <moodycamel/blockingconcurrentqueue.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Log {
+
+/// \brief GELF chunk header: magic bytes, message id, sequence number and
+/// sequence count.
+using GelfChunkHeader = std::array<std::uint8_t, 12>;
+
+/// \brief Maximum number of chunks a single GELF message may be split into.
+const size_t GelfMaxChunks{128};
+
+/// \brief Create the chunk headers required for sending a message of the
+/// given size. No headers are created if the message fits in one datagram.
+/// \return False if the message requires more than GelfMaxChunks chunks.
+bool createGelfChunkHeaders(size_t MessageSize, size_t MaxDatagramSize,
+                            std::uint64_t MessageId,
+                            std::vector<GelfChunkHeader> &Headers);
+
+class GraylogUdpConnection::Impl {
+public:
+  using Status = Log::Status;
+  Impl(std::string Host, int Port, size_t MaxQueueLength,
+       size_t MaxDatagramSize, CompressionSettings Compression,
+       bool ConnectOnFirstUse);
+  virtual ~Impl();
+  virtual void sendMessage(std::string Msg) {
+    start();
+    auto MsgFunc = [=]() { return Msg; };
+    if (not LogMessages.try_enqueue(MsgFunc)) {
+      ++MessagesDropped;
+    }
+  }
+  virtual void
+  sendDeferredMessage(std::function<std::string(void)> MessageCreator) {
+    start();
+    if (not LogMessages.try_enqueue(std::move(MessageCreator))) {
+      ++MessagesDropped;
+    }
+  }
+  Status getConnectionStatus() const;
+  virtual bool flush(std::chrono::system_clock::duration TimeOut);
+  virtual size_t queueSize() { return LogMessages.size_approx(); }
+  size_t messagesDropped() const { return MessagesDropped.load(); }
+  CompressionStatistics compressionStatistics() const {
+    return Compressor.statistics();
+  }
+
+protected:
+  struct Datagram {
+    size_t MessageIndex;
+    size_t Offset;
+    size_t Length;
+    size_t HeaderIndex;
+  };
+  static const size_t NoHeader{~size_t(0)};
+
+  /// \brief Start the thread sending the messages, unless already started.
+  void start();
+  void threadFunction();
+  bool openSocket();
+  void setState(Status NewState);
+  void addToBatch(std::string &&Message);
+  void sendBatch();
+  size_t sendDatagrams(size_t First, size_t Count);
+  std::uint64_t nextMessageId();
+
+  std::atomic<Status> ConnectionState{Status::ADDR_LOOKUP};
+  std::atomic_bool RunThread{true};
+  std::atomic<size_t> MessagesDropped{0};
+
+  std::string HostAddress;
+  std::string HostPort;
+  size_t MaxDatagramSize;
+
+  std::uint64_t MessageIdSeed;
+  std::uint64_t MessageIdCounter{0};
+
+  GelfCompressor Compressor;
+  /// \brief Swapped with the messages that are compressed so that its
+  /// memory is reused.
+  std::string CompressedMessage;
+
+  std::vector<std::string> BatchMessages;
+  std::vector<GelfChunkHeader> BatchHeaders;
+  std::vector<Datagram> BatchDatagrams;
+  std::vector<std::shared_ptr<std::promise<void>>> CompletedFlushes;
+
+  moodycamel::BlockingConcurrentQueue<std::function<std::string(void)>>
+      LogMessages;
+
+private:
+  asio::io_service Service;
+  asio::ip::udp::socket Socket;
+  std::once_flag Started;
+  std::thread SendThread;
+};
+
+} // namespace Log
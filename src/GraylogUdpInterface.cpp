@@ -0,0 +1,87 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief The interface implementation for sending messages to a graylog
+/// server using UDP.
+///
+//===----------------------------------------------------------------------===//
+
+#include "graylog_logger/GraylogUdpInterface.hpp"
+#include "GelfSerializer.hpp"
+#include "GraylogUdpConnection.hpp"
+#include <ciso646>
+
+namespace Log {
+
+GraylogUdpConnection::GraylogUdpConnection(std::string Host, int Port,
+                                           size_t MaxQueueSize,
+                                           size_t MaxDatagramSize,
+                                           CompressionSettings Compression,
+                                           bool ConnectOnFirstUse)
+    : Pimpl(std::make_unique<GraylogUdpConnection::Impl>(
+          std::move(Host), Port, MaxQueueSize, MaxDatagramSize, Compression,
+          ConnectOnFirstUse)) {}
+
+GraylogUdpConnection::~GraylogUdpConnection() = default;
+
+void GraylogUdpConnection::sendMessage(std::string Msg) {
+  Pimpl->sendMessage(std::move(Msg));
+}
+
+void GraylogUdpConnection::sendDeferredMessage(
+    std::function<std::string(void)> MessageCreator) {
+  Pimpl->sendDeferredMessage(std::move(MessageCreator));
+}
+
+bool GraylogUdpConnection::flush(std::chrono::system_clock::duration TimeOut) {
+  return Pimpl->flush(TimeOut);
+}
+
+Status GraylogUdpConnection::getConnectionStatus() const {
+  return Pimpl->getConnectionStatus();
+}
+
+bool GraylogUdpConnection::messageQueueEmpty() {
+  return Pimpl->queueSize() == 0;
+}
+
+size_t GraylogUdpConnection::messageQueueSize() { return Pimpl->queueSize(); }
+
+size_t GraylogUdpConnection::messagesDropped() const {
+  return Pimpl->messagesDropped();
+}
+
+CompressionStatistics GraylogUdpConnection::compressionStatistics() const {
+  return Pimpl->compressionStatistics();
+}
+
+GraylogUdpInterface::GraylogUdpInterface(const std::string &Host,
+                                         const int Port,
+                                         const size_t MaxQueueLength,
+                                         const size_t MaxDatagramSize,
+                                         CompressionSettings Compression,
+                                         bool ConnectOnFirstUse)
+    : GraylogUdpConnection(Host, Port, MaxQueueLength, MaxDatagramSize,
+                           Compression, ConnectOnFirstUse) {}
+
+GraylogUdpInterface::~GraylogUdpInterface() = default;
+
+void GraylogUdpInterface::addMessage(const LogMessage &Message) {
+  sendMessage(serializeOnThisThread(Message));
+}
+
+void GraylogUdpInterface::addSharedMessage(const LogMessage_P &Message) {
+  sendDeferredMessage([Message]() { return serializeOnThisThread(*Message); });
+}
+
+bool GraylogUdpInterface::flush(std::chrono::system_clock::duration TimeOut) {
+  return GraylogUdpConnection::flush(TimeOut);
+}
+
+bool GraylogUdpInterface::emptyQueue() { return messageQueueEmpty(); }
+
+size_t GraylogUdpInterface::queueSize() { return messageQueueSize(); }
+
+} // namespace Log
@@ -0,0 +1,140 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the minimal streaming JSON writer.
+///
+//===----------------------------------------------------------------------===//
+
+#include "JsonWriter.hpp"
+#include <array>
+#include <ciso646>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Log {
+namespace Json {
+
+void appendEscaped(std::string &Out, const std::string &Value) {
+  static const char HexChars[] = "0123456789abcdef";
+  auto RunStart = Value.data();
+  auto const End = Value.data() + Value.size();
+  for (auto Current = RunStart; Current != End; ++Current) {
+    auto const Char = static_cast<unsigned char>(*Current);
+    if (Char >= 0x20 and Char != '"' and Char != '\\') {
+      continue;
+    }
+    Out.append(RunStart, Current);
+    RunStart = Current + 1;
+    switch (Char) {
+    case '"':
+      Out.append("\\\"");
+      break;
+    case '\\':
+      Out.append("\\\\");
+      break;
+    case '\n':
+      Out.append("\\n");
+      break;
+    case '\r':
+      Out.append("\\r");
+      break;
+    case '\t':
+      Out.append("\\t");
+      break;
+    case '\b':
+      Out.append("\\b");
+      break;
+    case '\f':
+      Out.append("\\f");
+      break;
+    default:
+      Out.append("\\u00");
+      Out.push_back(HexChars[Char >> 4]);
+      Out.push_back(HexChars[Char & 0x0f]);
+      break;
+    }
+  }
+  Out.append(RunStart, End);
+}
+
+void appendString(std::string &Out, const std::string &Value) {
+  Out.push_back('"');
+  appendEscaped(Out, Value);
+  Out.push_back('"');
+}
+
+void appendInt(std::string &Out, std::int64_t Value) {
+  std::array<char, 24> Buffer{};
+  auto Position = Buffer.end();
+  // Work with the unsigned magnitude to handle INT64_MIN correctly.
+  auto Magnitude = static_cast<std::uint64_t>(Value);
+  if (Value < 0) {
+    Magnitude = ~Magnitude + 1;
+  }
+  do {
+    *--Position = static_cast<char>('0' + Magnitude % 10);
+    Magnitude /= 10;
+  } while (Magnitude != 0);
+  if (Value < 0) {
+    *--Position = '-';
+  }
+  Out.append(Position, Buffer.end());
+}
+
+void appendDouble(std::string &Out, double Value) {
+  if (not std::isfinite(Value)) {
+    Out.append("null");
+    return;
+  }
+  std::array<char, 32> Buffer{};
+  // Try the shorter representation first and only fall back to the full
+  // precision one if the value does not survive the round trip.
+  auto Length = std::snprintf(Buffer.data(), Buffer.size(), "%.15g", Value);
+  if (std::strtod(Buffer.data(), nullptr) != Value) {
+    Length = std::snprintf(Buffer.data(), Buffer.size(), "%.17g", Value);
+  }
+  // Some locales use a decimal comma, which is not valid JSON.
+  for (auto Iter = Buffer.begin(); Iter != Buffer.begin() + Length; ++Iter) {
+    if (*Iter == ',') {
+      *Iter = '.';
+    }
+  }
+  Out.append(Buffer.data(), static_cast<size_t>(Length));
+}
+
+void appendTimestamp(std::string &Out, const system_time &Timestamp) {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  auto const Milliseconds =
+      duration_cast<milliseconds>(Timestamp.time_since_epoch()).count();
+  if (Milliseconds < 0) {
+    appendDouble(Out, static_cast<double>(Milliseconds) / 1000);
+    return;
+  }
+  appendInt(Out, Milliseconds / 1000);
+  auto const Fraction = static_cast<int>(Milliseconds % 1000);
+  Out.push_back('.');
+  Out.push_back(static_cast<char>('0' + Fraction / 100));
+  Out.push_back(static_cast<char>('0' + (Fraction / 10) % 10));
+  Out.push_back(static_cast<char>('0' + Fraction % 10));
+}
+
+void appendField(std::string &Out, const AdditionalField &Field) {
+  switch (Field.FieldType) {
+  case AdditionalField::Type::typeStr:
+    appendString(Out, Field.strVal);
+    break;
+  case AdditionalField::Type::typeDbl:
+    appendDouble(Out, Field.dblVal);
+    break;
+  case AdditionalField::Type::typeInt:
+    appendInt(Out, Field.intVal);
+    break;
+  }
+}
+
+} // namespace Json
+} // namespace Log
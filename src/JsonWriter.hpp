@@ -0,0 +1,51 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Minimal streaming JSON writer used for serialising log messages.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/LogUtil.hpp"
+#include <cstdint>
+#include <string>
+
+namespace Log {
+namespace Json {
+
+/// \brief Append an escaped JSON string to a buffer without the surrounding
+/// quotes.
+/// \note Bytes outside of the ASCII range are copied verbatim, i.e. the input
+/// is assumed to be UTF-8 encoded.
+void appendEscaped(std::string &Out, const std::string &Value);
+
+/// \brief Append a quoted and escaped JSON string to a buffer.
+void appendString(std::string &Out, const std::string &Value);
+
+/// \brief Append an integer value to a buffer.
+void appendInt(std::string &Out, std::int64_t Value);
+
+/// \brief Append a floating point value to a buffer using the shortest
+/// representation that will parse back to the same value.
+/// \note NaN and infinity are written as null, as JSON has no representation
+/// for these values.
+void appendDouble(std::string &Out, double Value);
+
+/// \brief Append a timestamp as (fractional) seconds since the epoch with
+/// millisecond resolution.
+void appendTimestamp(std::string &Out, const system_time &Timestamp);
+
+/// \brief Append the value stored in an AdditionalField instance.
+void appendField(std::string &Out, const AdditionalField &Field);
+
+/// \brief Append a key followed by a colon. Commas are left to the caller.
+inline void appendKey(std::string &Out, const std::string &Key) {
+  appendString(Out, Key);
+  Out.push_back(':');
+}
+
+} // namespace Json
+} // namespace Log
@@ -9,9 +9,22 @@
 
 #include "graylog_logger/Log.hpp"
 #include "graylog_logger/Logger.hpp"
+#include <atomic>
 #include <ciso646>
+#include <cstdlib>
+#include <mutex>
 
 namespace Log {
+namespace {
+std::atomic<std::chrono::system_clock::duration::rep> ExitTimeOut{0};
+std::once_flag ExitHandlerRegistered;
+
+void shutdownAtExit() {
+  Logger::Inst().shutdown(std::chrono::system_clock::duration(
+      ExitTimeOut.load(std::memory_order_relaxed)));
+}
+} // namespace
+
 void Msg(const Severity Level, const std::string &Message) {
   Logger::Inst().log(Level, Message);
 }
@@ -46,6 +59,19 @@ bool Flush(std::chrono::system_clock::duration TimeOut) {
   return Logger::Inst().flush(TimeOut);
 }
 
+ShutdownReport Shutdown(std::chrono::system_clock::duration TimeOut) {
+  return Logger::Inst().shutdown(TimeOut);
+}
+
+void ShutdownAtExit(std::chrono::system_clock::duration TimeOut) {
+  ExitTimeOut.store(TimeOut.count(), std::memory_order_relaxed);
+  // Exit handlers and destructors of static objects run in the reverse order
+  // of their registration, so the logger must exist before the handler is
+  // registered for it to still exist when the handler is called.
+  Logger::Inst();
+  std::call_once(ExitHandlerRegistered, []() { std::atexit(shutdownAtExit); });
+}
+
 void AddField(const std::string &Key, const AdditionalField &Value) {
   Logger::Inst().addField(Key, Value);
 }
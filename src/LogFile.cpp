@@ -0,0 +1,744 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the log file writers.
+///
+//===----------------------------------------------------------------------===//
+
+#include "LogFile.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <ciso646>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <climits>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Log {
+
+namespace {
+size_t fileSize(int FileDescriptor) {
+  struct stat FileInfo {};
+  if (FileDescriptor == -1 or fstat(FileDescriptor, &FileInfo) != 0) {
+    return 0;
+  }
+  return static_cast<size_t>(FileInfo.st_size);
+}
+
+/// \return errno if the sync failed, 0 otherwise.
+int syncFile(int FileDescriptor) {
+  if (FileDescriptor == -1) {
+    return 0;
+  }
+#ifdef _WIN32
+  auto Result = _commit(FileDescriptor);
+#elif defined(__APPLE__)
+  auto Result = fsync(FileDescriptor);
+#else
+  auto Result = fdatasync(FileDescriptor);
+#endif
+  return Result == 0 ? 0 : errno;
+}
+} // namespace
+
+void LogFile::sync() {}
+
+AppendFile::~AppendFile() { AppendFile::close(); }
+
+bool AppendFile::open(const std::string &Name) {
+  close();
+#ifdef _WIN32
+  FileDescriptor =
+      _open(Name.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY,
+            _S_IREAD | _S_IWRITE);
+#else
+  FileDescriptor =
+      ::open(Name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+  Error = FileDescriptor == -1 ? errno : 0;
+  FileSize = fileSize(FileDescriptor);
+  return FileDescriptor != -1;
+}
+
+size_t AppendFile::write(const char *Data, size_t Size) {
+  auto Written = append(Data, Size);
+  if (Written < Size and Written > 0) {
+    // Remove the partial lines, the caller writes them again elsewhere or
+    // drops them.
+    FileSize -= Written;
+#ifdef _WIN32
+    auto Result = _chsize_s(FileDescriptor, static_cast<__int64>(FileSize));
+#else
+    auto Result = ::ftruncate(FileDescriptor, static_cast<off_t>(FileSize));
+#endif
+    (void)Result;
+    return 0;
+  }
+  return Written;
+}
+
+size_t AppendFile::append(const char *Data, size_t Size) {
+  if (FileDescriptor == -1) {
+    if (Size > 0 and Error == 0) {
+      Error = EBADF;
+    }
+    return 0;
+  }
+  size_t Written{0};
+  while (Written < Size) {
+#ifdef _WIN32
+    auto Result = _write(FileDescriptor, Data + Written,
+                         static_cast<unsigned int>(Size - Written));
+#else
+    auto Result = ::write(FileDescriptor, Data + Written, Size - Written);
+#endif
+    if (Result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      Error = errno;
+      break;
+    }
+    Written += static_cast<size_t>(Result);
+  }
+  FileSize += Written;
+  return Written;
+}
+
+void AppendFile::sync() {
+  if (auto Result = syncFile(FileDescriptor)) {
+    Error = Result;
+  }
+}
+
+void AppendFile::close() {
+  if (FileDescriptor != -1) {
+#ifdef _WIN32
+    _close(FileDescriptor);
+#else
+    ::close(FileDescriptor);
+#endif
+    FileDescriptor = -1;
+  }
+  FileSize = 0;
+}
+
+#ifndef _WIN32
+size_t SharedAppendFile::write(const char *Data, size_t Size) {
+  bool Locked = LockLargeWrites and Size > PIPE_BUF and lock();
+  auto Written = append(Data, Size);
+  if (Locked) {
+    unlock();
+  }
+  return Written;
+}
+
+size_t SharedAppendFile::size() const { return fileSize(FileDescriptor); }
+
+bool SharedAppendFile::lock() {
+  while (FileDescriptor != -1) {
+    if (flock(FileDescriptor, LOCK_EX) == 0) {
+      return true;
+    }
+    if (errno != EINTR) {
+      break;
+    }
+  }
+  return false;
+}
+
+void SharedAppendFile::unlock() {
+  if (FileDescriptor != -1) {
+    flock(FileDescriptor, LOCK_UN);
+  }
+}
+
+bool SharedAppendFile::isFile(const std::string &Name) const {
+  struct stat PathInfo {};
+  struct stat FileInfo {};
+  return FileDescriptor != -1 and stat(Name.c_str(), &PathInfo) == 0 and
+         fstat(FileDescriptor, &FileInfo) == 0 and
+         PathInfo.st_dev == FileInfo.st_dev and
+         PathInfo.st_ino == FileInfo.st_ino;
+}
+
+MappedFile::MappedFile(size_t ChunkSize) {
+  // The offset given to mmap() must be a multiple of the page size. Windows
+  // start at the page holding the end of the file and span whole pages.
+  auto PageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  this->ChunkSize =
+      std::max(PageSize, (ChunkSize + PageSize - 1) / PageSize * PageSize);
+}
+
+MappedFile::~MappedFile() { MappedFile::close(); }
+
+bool MappedFile::open(const std::string &Name) {
+  close();
+  FileDescriptor = ::open(Name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (FileDescriptor == -1) {
+    Error = errno;
+    return false;
+  }
+  Error = 0;
+  AllocatedSize = fileSize(FileDescriptor);
+  // Skip the zero bytes of space that was allocated but not written to, at
+  // most one window.
+  FileSize = AllocatedSize;
+  std::array<char, 64 * 1024> Buffer{};
+  auto ScanLimit = AllocatedSize - std::min(AllocatedSize, ChunkSize);
+  while (FileSize > ScanLimit) {
+    auto Length = std::min(Buffer.size(), FileSize - ScanLimit);
+    auto Result = ::pread(FileDescriptor, Buffer.data(), Length,
+                          static_cast<off_t>(FileSize - Length));
+    if (Result != static_cast<ssize_t>(Length)) {
+      break;
+    }
+    auto DataLength = Length;
+    while (DataLength > 0 and Buffer[DataLength - 1] == 0) {
+      --DataLength;
+    }
+    if (DataLength > 0) {
+      FileSize -= Length - DataLength;
+      break;
+    }
+    FileSize -= Length;
+  }
+  return true;
+}
+
+size_t MappedFile::write(const char *Data, size_t Size) {
+  if (FileDescriptor == -1) {
+    if (Size > 0 and Error == 0) {
+      Error = EBADF;
+    }
+    return 0;
+  }
+  size_t Written{0};
+  while (Written < Size) {
+    if (Window == nullptr or FileSize == WindowOffset + WindowSize) {
+      unmapWindow();
+      if (not mapWindow()) {
+        // Data beyond FileSize is removed when the file is closed.
+        FileSize -= Written;
+        return 0;
+      }
+    }
+    auto Length =
+        std::min(Size - Written, WindowOffset + WindowSize - FileSize);
+    std::memcpy(Window + (FileSize - WindowOffset), Data + Written, Length);
+    FileSize += Length;
+    Written += Length;
+  }
+  return Written;
+}
+
+bool MappedFile::mapWindow() {
+  auto PageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto Offset = FileSize / PageSize * PageSize;
+  if (AllocatedSize < Offset + ChunkSize) {
+    // Allocating the blocks up front means that running out of disk space is
+    // reported here instead of by SIGBUS when writing to the mapping.
+    auto Result =
+        posix_fallocate(FileDescriptor, static_cast<off_t>(AllocatedSize),
+                        static_cast<off_t>(Offset + ChunkSize - AllocatedSize));
+    if (Result != 0) {
+      Error = Result;
+      return false;
+    }
+    AllocatedSize = Offset + ChunkSize;
+  }
+  auto Address = ::mmap(nullptr, ChunkSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        FileDescriptor, static_cast<off_t>(Offset));
+  if (Address == MAP_FAILED) {
+    Error = errno;
+    return false;
+  }
+  Window = static_cast<char *>(Address);
+  WindowOffset = Offset;
+  WindowSize = ChunkSize;
+  return true;
+}
+
+void MappedFile::unmapWindow() {
+  if (Window != nullptr) {
+    ::munmap(Window, WindowSize);
+    Window = nullptr;
+  }
+}
+
+void MappedFile::sync() {
+  // The page cache is shared with the mapping, i.e. this includes the pages
+  // modified through it. msync() can not be used as the window may be
+  // replaced concurrently.
+  if (auto Result = syncFile(FileDescriptor)) {
+    Error = Result;
+  }
+}
+
+void MappedFile::close() {
+  unmapWindow();
+  if (FileDescriptor != -1) {
+    // Remove the space allocated beyond the data.
+    if (AllocatedSize > FileSize) {
+      auto Result = ::ftruncate(FileDescriptor, static_cast<off_t>(FileSize));
+      (void)Result;
+    }
+    ::close(FileDescriptor);
+    FileDescriptor = -1;
+  }
+  FileSize = 0;
+  AllocatedSize = 0;
+}
+#endif
+
+#ifdef HAVE_IO_URING
+namespace {
+int enterRing(int RingFd, unsigned ToSubmit, unsigned MinComplete,
+              unsigned Flags) {
+  while (true) {
+    auto Result = syscall(__NR_io_uring_enter, RingFd, ToSubmit, MinComplete,
+                          Flags, nullptr, 0);
+    if (Result >= 0 or errno != EINTR) {
+      return static_cast<int>(Result);
+    }
+  }
+}
+
+void *mapRing(int RingFd, size_t Size, off_t Offset) {
+  auto Address = ::mmap(nullptr, Size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, RingFd, Offset);
+  return Address == MAP_FAILED ? nullptr : Address;
+}
+
+/// \brief user_data of the completion of a sync.
+const std::uint64_t SyncMarker{~std::uint64_t(0)};
+
+template <typename T> T *ringField(void *Ring, unsigned Offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(Ring) + Offset);
+}
+
+/// \return errno if the data could not be written, otherwise 0.
+int writeAt(int FileDescriptor, const char *Data, size_t Size,
+            size_t Offset) {
+  size_t Written{0};
+  while (Written < Size) {
+    auto Result = ::pwrite(FileDescriptor, Data + Written, Size - Written,
+                           static_cast<off_t>(Offset + Written));
+    if (Result < 0 and errno == EINTR) {
+      continue;
+    }
+    if (Result <= 0) {
+      return Result < 0 ? errno : EIO;
+    }
+    Written += static_cast<size_t>(Result);
+  }
+  return 0;
+}
+} // namespace
+
+UringFile::UringFile(size_t WritesInFlight)
+    : Writes(std::max<size_t>(WritesInFlight, 1)) {
+  // One entry per buffer and one for a sync.
+  if (not setUpRing(static_cast<unsigned>(Writes.size() + 1))) {
+    releaseRing();
+  }
+}
+
+UringFile::~UringFile() {
+  UringFile::close();
+  releaseRing();
+}
+
+void UringFile::releaseRing() {
+  if (Sqes != nullptr) {
+    ::munmap(Sqes, SqesSize);
+    Sqes = nullptr;
+  }
+  if (CqRing != nullptr and CqRing != SqRing) {
+    ::munmap(CqRing, CqRingSize);
+  }
+  CqRing = nullptr;
+  if (SqRing != nullptr) {
+    ::munmap(SqRing, SqRingSize);
+    SqRing = nullptr;
+  }
+  if (RingFd != -1) {
+    ::close(RingFd);
+    RingFd = -1;
+  }
+}
+
+bool UringFile::setUpRing(unsigned Entries) {
+  io_uring_params Params{};
+  RingFd = static_cast<int>(syscall(__NR_io_uring_setup, Entries, &Params));
+  if (RingFd == -1) {
+    return false;
+  }
+  // IORING_OP_WRITE was added in the same kernel version (5.6) as this
+  // feature flag.
+  if (not(Params.features & IORING_FEAT_RW_CUR_POS)) {
+    return false;
+  }
+  SqRingSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+  CqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+  bool SingleMap = Params.features & IORING_FEAT_SINGLE_MMAP;
+  if (SingleMap) {
+    SqRingSize = CqRingSize = std::max(SqRingSize, CqRingSize);
+  }
+  SqRing = mapRing(RingFd, SqRingSize, IORING_OFF_SQ_RING);
+  if (SqRing == nullptr) {
+    return false;
+  }
+  CqRing = SingleMap ? SqRing : mapRing(RingFd, CqRingSize, IORING_OFF_CQ_RING);
+  SqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+  Sqes = mapRing(RingFd, SqesSize, IORING_OFF_SQES);
+  if (CqRing == nullptr or Sqes == nullptr) {
+    return false;
+  }
+  SqHead = ringField<unsigned>(SqRing, Params.sq_off.head);
+  SqTail = ringField<unsigned>(SqRing, Params.sq_off.tail);
+  SqMask = ringField<unsigned>(SqRing, Params.sq_off.ring_mask);
+  SqArray = ringField<unsigned>(SqRing, Params.sq_off.array);
+  CqHead = ringField<unsigned>(CqRing, Params.cq_off.head);
+  CqTail = ringField<unsigned>(CqRing, Params.cq_off.tail);
+  CqMask = ringField<unsigned>(CqRing, Params.cq_off.ring_mask);
+  Cqes = ringField<void>(CqRing, Params.cq_off.cqes);
+  return true;
+}
+
+bool UringFile::open(const std::string &Name) {
+  close();
+  FileDescriptor = ::open(Name.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  Error = FileDescriptor == -1 ? errno : 0;
+  FileSize = fileSize(FileDescriptor);
+  return FileDescriptor != -1;
+}
+
+size_t UringFile::write(const char *Data, size_t Size) {
+  if (FileDescriptor == -1) {
+    if (Size > 0 and Error == 0) {
+      Error = EBADF;
+    }
+    return 0;
+  }
+  while (Writes[NextWrite].InFlight and not RingFailed) {
+    reap(true);
+  }
+  if (RingFailed) {
+    // The buffers may still be in use by the kernel.
+    if (auto Result = writeAt(FileDescriptor, Data, Size, FileSize)) {
+      Error = Result;
+      return 0;
+    }
+  } else {
+    auto &CWrite = Writes[NextWrite];
+    CWrite.Buffer.assign(Data, Size);
+    CWrite.Offset = FileSize;
+    CWrite.Written = 0;
+    CWrite.InFlight = true;
+    ++WritesInProgress;
+    submit(NextWrite);
+    NextWrite = (NextWrite + 1) % Writes.size();
+  }
+  // Errors are reported by error() once the write has completed.
+  FileSize += Size;
+  return Size;
+}
+
+io_uring_sqe *UringFile::nextSqe() {
+  auto SqIndex = *SqTail & *SqMask;
+  auto Sqe = static_cast<io_uring_sqe *>(Sqes) + SqIndex;
+  std::memset(Sqe, 0, sizeof(*Sqe));
+  SqArray[SqIndex] = SqIndex;
+  return Sqe;
+}
+
+bool UringFile::submitSqe() {
+  __atomic_store_n(SqTail, *SqTail + 1, __ATOMIC_RELEASE);
+  if (enterRing(RingFd, 1, 0, 0) != 1) {
+    abandonRing();
+    return false;
+  }
+  return true;
+}
+
+void UringFile::submit(size_t Index) {
+  auto &CWrite = Writes[Index];
+  auto Sqe = nextSqe();
+  Sqe->opcode = IORING_OP_WRITE;
+  Sqe->fd = FileDescriptor;
+  Sqe->addr = reinterpret_cast<std::uintptr_t>(CWrite.Buffer.data() +
+                                               CWrite.Written);
+  Sqe->len = static_cast<unsigned>(CWrite.Buffer.size() - CWrite.Written);
+  Sqe->off = CWrite.Offset + CWrite.Written;
+  Sqe->user_data = Index;
+  submitSqe();
+}
+
+bool UringFile::submitSync() {
+  if (FileDescriptor == -1 or RingFailed) {
+    return false;
+  }
+  // The submission queue has room for one entry per buffer plus one sync.
+  while (SyncsInProgress > 0 and not RingFailed) {
+    reap(true);
+  }
+  if (RingFailed) {
+    return false;
+  }
+  auto Sqe = nextSqe();
+  Sqe->opcode = IORING_OP_FSYNC;
+  Sqe->fd = FileDescriptor;
+  Sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+  // Not started before the writes submitted earlier have completed.
+  Sqe->flags = IOSQE_IO_DRAIN;
+  Sqe->user_data = SyncMarker;
+  ++SyncsInProgress;
+  return submitSqe();
+}
+
+void UringFile::sync() {
+  if (auto Result = syncFile(FileDescriptor)) {
+    Error = Result;
+  }
+}
+
+void UringFile::reap(bool Wait) {
+  if (Wait and enterRing(RingFd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+    abandonRing();
+    return;
+  }
+  auto Head = *CqHead;
+  auto Tail = __atomic_load_n(CqTail, __ATOMIC_ACQUIRE);
+  for (; Head != Tail; ++Head) {
+    auto &Cqe = static_cast<io_uring_cqe *>(Cqes)[Head & *CqMask];
+    if (Cqe.user_data == SyncMarker) {
+      --SyncsInProgress;
+      if (Cqe.res < 0) {
+        Error = -Cqe.res;
+      }
+      continue;
+    }
+    auto &CWrite = Writes[Cqe.user_data];
+    auto Result = Cqe.res;
+    if (Result > 0) {
+      CWrite.Written += static_cast<size_t>(Result);
+    }
+    if ((Result > 0 and CWrite.Written < CWrite.Buffer.size()) or
+        Result == -EINTR or Result == -EAGAIN) {
+      // Short write; write the rest.
+      submit(Cqe.user_data);
+    } else {
+      if (Result < 0) {
+        Error = -Result;
+      } else if (CWrite.Written < CWrite.Buffer.size()) {
+        Error = EIO;
+      }
+      CWrite.InFlight = false;
+      --WritesInProgress;
+    }
+    if (RingFailed) {
+      return;
+    }
+  }
+  __atomic_store_n(CqHead, Head, __ATOMIC_RELEASE);
+}
+
+void UringFile::abandonRing() {
+  RingFailed = true;
+  // Writes at explicit offsets can safely be repeated.
+  for (size_t i = 0; i < Writes.size(); ++i) {
+    auto &CWrite = Writes[i];
+    if (CWrite.InFlight) {
+      if (auto Result = writeAt(
+              FileDescriptor, CWrite.Buffer.data() + CWrite.Written,
+              CWrite.Buffer.size() - CWrite.Written,
+              CWrite.Offset + CWrite.Written)) {
+        Error = Result;
+      }
+      CWrite.InFlight = false;
+    }
+  }
+  WritesInProgress = 0;
+  SyncsInProgress = 0;
+}
+
+void UringFile::wait() {
+  while ((WritesInProgress > 0 or SyncsInProgress > 0) and not RingFailed) {
+    reap(true);
+  }
+}
+
+void UringFile::close() {
+  if (FileDescriptor != -1) {
+    wait();
+    ::close(FileDescriptor);
+    FileDescriptor = -1;
+  }
+  FileSize = 0;
+}
+#endif
+
+#ifdef WITH_ZLIB
+namespace {
+/// \brief CPU time used by the calling thread in nanoseconds.
+std::int64_t threadCpuTime() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  timespec Now{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Now);
+  return std::int64_t(Now.tv_sec) * 1000000000 + Now.tv_nsec;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+} // namespace
+
+struct GzipFile::Stream {
+  z_stream ZStream{};
+  bool Initialised{false};
+};
+
+GzipFile::GzipFile(std::unique_ptr<LogFile> File, int Level, size_t FrameSize)
+    : File(std::move(File)), FrameSize(FrameSize),
+      Deflater(std::make_unique<Stream>()) {
+  // Adding 16 to the window size selects the gzip framing.
+  Deflater->Initialised =
+      deflateInit2(&Deflater->ZStream, Level, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipFile::~GzipFile() {
+  GzipFile::close();
+  if (Deflater->Initialised) {
+    deflateEnd(&Deflater->ZStream);
+  }
+}
+
+bool GzipFile::open(const std::string &Name) {
+  FrameInput = 0;
+  FrameCrc = crc32(0, nullptr, 0);
+  Broken = false;
+  Error = 0;
+  if (Deflater->Initialised) {
+    deflateReset(&Deflater->ZStream);
+  }
+  return Deflater->Initialised and File->open(Name);
+}
+
+bool GzipFile::compress(const char *Data, size_t Size, int Flush) {
+  auto &ZStream = Deflater->ZStream;
+  ZStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(Data));
+  ZStream.avail_in = uInt(Size);
+  while (true) {
+    // Room for the compressed data and the flush markers.
+    auto Offset = Buffer.size();
+    Buffer.resize(Offset + deflateBound(&ZStream, uLong(ZStream.avail_in)) +
+                  64);
+    ZStream.next_out = reinterpret_cast<Bytef *>(&Buffer[Offset]);
+    ZStream.avail_out = uInt(Buffer.size() - Offset);
+    auto Result = deflate(&ZStream, Flush);
+    Buffer.resize(Buffer.size() - ZStream.avail_out);
+    if (Result == Z_STREAM_ERROR) {
+      return false;
+    }
+    if (ZStream.avail_in == 0 and ZStream.avail_out != 0 and
+        (Flush != Z_FINISH or Result == Z_STREAM_END)) {
+      break;
+    }
+  }
+  if (Flush == Z_FINISH) {
+    deflateReset(&ZStream);
+  }
+  return true;
+}
+
+size_t GzipFile::write(const char *Data, size_t Size) {
+  if (not isOpen() or Broken or Size == 0) {
+    return 0;
+  }
+  auto StartTime = threadCpuTime();
+  Buffer.clear();
+  bool EndOfFrame = FrameInput + Size >= FrameSize;
+  bool Compressed = compress(Data, Size, EndOfFrame ? Z_FINISH : Z_SYNC_FLUSH);
+  CpuTimeNs += threadCpuTime() - StartTime;
+  if (not Compressed) {
+    Broken = true;
+    Error = EIO;
+    return 0;
+  }
+  ++Writes;
+  BytesIn += Size;
+  BytesOut += Buffer.size();
+  if (File->write(Buffer.data(), Buffer.size()) != Buffer.size()) {
+    // The compressor has consumed data that is not in the file.
+    Broken = true;
+    return 0;
+  }
+  if (EndOfFrame) {
+    FrameInput = 0;
+    FrameCrc = crc32(0, nullptr, 0);
+  } else {
+    FrameInput += Size;
+    FrameCrc = crc32(FrameCrc, reinterpret_cast<const Bytef *>(Data),
+                     uInt(Size));
+  }
+  return Size;
+}
+
+void GzipFile::close() {
+  if (isOpen() and FrameInput > 0) {
+    Buffer.clear();
+    if (Broken) {
+      // The data in the file ends at a flush point, i.e. on a byte boundary.
+      // An empty final block (fixed Huffman codes) and a trailer covering the
+      // input that was written finish the member.
+      Buffer = {'\x03', '\x00'};
+      for (auto Value : {FrameCrc, uLong(FrameInput)}) {
+        for (int i = 0; i < 4; ++i) {
+          Buffer.push_back(static_cast<char>((Value >> (8 * i)) & 0xff));
+        }
+      }
+    } else if (not compress(nullptr, 0, Z_FINISH)) {
+      Buffer.clear();
+    }
+    BytesOut += Buffer.size();
+    File->write(Buffer.data(), Buffer.size());
+  }
+  FrameInput = 0;
+  File->close();
+}
+
+CompressionStatistics GzipFile::statistics() const {
+  CompressionStatistics Statistics;
+  Statistics.MessagesCompressed = Writes.load();
+  Statistics.BytesIn = BytesIn.load();
+  Statistics.BytesOut = BytesOut.load();
+  Statistics.CpuTime = std::chrono::nanoseconds(CpuTimeNs.load());
+  return Statistics;
+}
+#endif
+
+} // namespace Log
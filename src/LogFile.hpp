@@ -0,0 +1,305 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief The different ways of writing to a log file.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/Compression.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_IO_URING
+struct io_uring_sqe;
+#endif
+
+namespace Log {
+
+/// \brief An open log file to which data is appended.
+class LogFile {
+public:
+  virtual ~LogFile() = default;
+  /// \brief Open (or create) the file for appending.
+  /// \return False if the file could not be opened.
+  virtual bool open(const std::string &Name) = 0;
+  /// \brief Append data to the file.
+  /// \return The number of bytes written; less than Size on failure, see
+  /// error().
+  virtual size_t write(const char *Data, size_t Size) = 0;
+  /// \brief Wait until all data passed to write() has been written to the
+  /// file.
+  virtual void wait() {}
+  /// \brief Force the data written to the file to stable storage
+  /// (fdatasync()). May be called from another thread than the one writing
+  /// to the file, but not while the file is being opened or closed. Failures
+  /// are reported by error().
+  virtual void sync();
+  /// \brief Start forcing the data passed to write() so far to stable
+  /// storage without waiting for it.
+  /// \return False if not supported, in which case sync() should be called
+  /// from a separate thread.
+  virtual bool submitSync() { return false; }
+  virtual void close() = 0;
+  virtual bool isOpen() const = 0;
+  /// \brief Size of the (logical) contents of the file.
+  virtual size_t size() const = 0;
+  /// \brief errno of the last failed write or sync (e.g. ENOSPC if the disk
+  /// is full) or of a failed open(); 0 if there has been no failure since the
+  /// file was opened.
+  virtual int error() const { return Error; }
+
+protected:
+  /// \brief Atomic as sync() may be called from another thread.
+  std::atomic<int> Error{0};
+};
+
+/// \brief Appends to the file using write() on a file opened with O_APPEND.
+///
+/// If a write fails part way (e.g. because the disk is full), the file is
+/// truncated to its previous size, i.e. it never ends with part of a line.
+class AppendFile : public LogFile {
+public:
+  ~AppendFile() override;
+  bool open(const std::string &Name) override;
+  /// \return Size, or 0 on failure.
+  size_t write(const char *Data, size_t Size) override;
+  void close() override;
+  bool isOpen() const override { return FileDescriptor != -1; }
+  size_t size() const override { return FileSize; }
+  void sync() override;
+
+protected:
+  /// \brief Write all of the data, unless an error occurs.
+  /// \return The number of bytes written.
+  size_t append(const char *Data, size_t Size);
+
+  int FileDescriptor{-1};
+  size_t FileSize{0};
+};
+
+#ifndef _WIN32
+/// \brief Appends to a file that other processes append to as well.
+///
+/// Every call to write() appends the data using a single write() on a file
+/// opened with O_APPEND, i.e. the data is not interleaved with that of
+/// other processes. POSIX only guarantees this for writes of at most
+/// PIPE_BUF bytes to pipes and FIFOs, though most local file systems also
+/// serialise larger appends to regular files. An advisory lock (flock())
+/// can be held while writing more than PIPE_BUF bytes for file systems that
+/// do not, provided all processes writing to the file use it. Failed writes
+/// are not undone, as other processes may have appended to the file since.
+class SharedAppendFile : public AppendFile {
+public:
+  explicit SharedAppendFile(bool LockLargeWrites)
+      : LockLargeWrites(LockLargeWrites) {}
+  size_t write(const char *Data, size_t Size) override;
+  /// \brief Size of the file, including the data of other processes.
+  size_t size() const override;
+  /// \brief Take the advisory lock of the file, waiting for other processes
+  /// to release it. Released by unlock() or close().
+  bool lock();
+  void unlock();
+  /// \brief Does the path still refer to the open file? Not if it has been
+  /// renamed (e.g. rotated by another process) or deleted.
+  bool isFile(const std::string &Name) const;
+
+private:
+  bool LockLargeWrites;
+};
+#endif
+
+/// \brief Appends to the file by copying data into a memory mapped window of
+/// the file.
+///
+/// The file is extended (and its blocks allocated) ChunkSize bytes at a time
+/// and a window of that size is mapped, so that system calls are only made
+/// once per chunk. Writeback is left to the kernel. When closed, the file is
+/// truncated to the length of the data written. Trailing zero bytes left by
+/// a process that did not close the file are removed when it is reopened,
+/// i.e. the data written must not end with zero bytes.
+/// \note Readers of the file see zero bytes following the data until the
+/// file is closed. Only a single process may write to the file.
+class MappedFile : public LogFile {
+public:
+  explicit MappedFile(size_t ChunkSize);
+  ~MappedFile() override;
+  bool open(const std::string &Name) override;
+  /// \return Size, or 0 if space for the data could not be allocated.
+  size_t write(const char *Data, size_t Size) override;
+  void close() override;
+  bool isOpen() const override { return FileDescriptor != -1; }
+  size_t size() const override { return FileSize; }
+  /// \brief Also writes the pages modified through the mapping.
+  void sync() override;
+
+private:
+  /// \brief Map a new window starting at (or just before) the end of the
+  /// data, extending the file if required.
+  bool mapWindow();
+  void unmapWindow();
+
+  size_t ChunkSize;
+  int FileDescriptor{-1};
+  /// \brief Length of the data in the file.
+  size_t FileSize{0};
+  /// \brief Length of the file including space allocated for future data.
+  size_t AllocatedSize{0};
+  char *Window{nullptr};
+  /// \brief File offset of the mapped window.
+  size_t WindowOffset{0};
+  size_t WindowSize{0};
+};
+
+#ifdef WITH_ZLIB
+/// \brief Compresses the data (gzip) before passing it on to another file.
+///
+/// The compressor is flushed (Z_SYNC_FLUSH) at the end of every write, so
+/// that everything written so far can be decompressed even if the file is
+/// cut short by a crash. After FrameSize bytes of input, the gzip member is
+/// finished and a new one started, i.e. the file consists of independent
+/// frames. gzip and zcat decompress all of them.
+/// \note size() is the compressed size of the file.
+class GzipFile : public LogFile {
+public:
+  /// \param[in] File The file the compressed data is written to.
+  /// \param[in] Level zlib compression level, -1 for the default.
+  /// \param[in] FrameSize Uncompressed size of a gzip member.
+  GzipFile(std::unique_ptr<LogFile> File, int Level, size_t FrameSize);
+  ~GzipFile() override;
+  bool open(const std::string &Name) override;
+  size_t write(const char *Data, size_t Size) override;
+  void wait() override { File->wait(); }
+  void sync() override { File->sync(); }
+  bool submitSync() override { return File->submitSync(); }
+  /// \brief Finishes the current gzip member. If a write failed, the member
+  /// is finished after the data that was written.
+  void close() override;
+  bool isOpen() const override { return File->isOpen(); }
+  size_t size() const override { return File->size(); }
+  /// \return EIO if compressing failed, otherwise the error of the file.
+  int error() const override {
+    return Error != 0 ? Error.load() : File->error();
+  }
+  /// \brief May be called from any thread.
+  CompressionStatistics statistics() const;
+
+private:
+  /// \brief Compress data, appending the result to Buffer.
+  bool compress(const char *Data, size_t Size, int Flush);
+
+  std::unique_ptr<LogFile> File;
+  size_t FrameSize;
+  struct Stream;
+  std::unique_ptr<Stream> Deflater;
+  /// \brief Input of the current gzip member written to the file, and its
+  /// CRC-32.
+  size_t FrameInput{0};
+  unsigned long FrameCrc{0};
+  /// \brief Set when compressing or writing the compressed data failed, i.e.
+  /// the state of the compressor no longer matches the file. Nothing more is
+  /// written to the file until it is reopened.
+  bool Broken{false};
+  std::string Buffer;
+
+  std::atomic<std::uint64_t> Writes{0};
+  std::atomic<std::uint64_t> BytesIn{0};
+  std::atomic<std::uint64_t> BytesOut{0};
+  std::atomic<std::int64_t> CpuTimeNs{0};
+};
+#endif
+
+#ifdef HAVE_IO_URING
+/// \brief Writes to the file asynchronously using io_uring.
+///
+/// Data passed to write() is copied into one of several buffers and a write
+/// at the end of the file is submitted to the kernel without waiting for it
+/// to complete, so that the next batch of messages can be formatted while
+/// the previous one is being written. Only if all buffers are in use does
+/// write() wait for a write to complete. The io_uring system calls are used
+/// directly, without liburing.
+/// \note Writes are made at explicit offsets, i.e. only one process may
+/// write to the file. Errors are only reported by error() once the failed
+/// write has completed, i.e. usually after a later call to write(). The data
+/// of failed writes is lost.
+class UringFile : public LogFile {
+public:
+  /// \param[in] WritesInFlight Number of buffers (and writes that may be in
+  /// progress).
+  explicit UringFile(size_t WritesInFlight);
+  ~UringFile() override;
+  /// \brief Could the io_uring instance be created? If not (old kernel,
+  /// io_uring disabled), the file can not be used.
+  bool available() const { return RingFd != -1; }
+  bool open(const std::string &Name) override;
+  size_t write(const char *Data, size_t Size) override;
+  /// \brief Also waits for outstanding syncs.
+  void wait() override;
+  void close() override;
+  bool isOpen() const override { return FileDescriptor != -1; }
+  size_t size() const override { return FileSize; }
+  /// \brief Only covers writes that have completed.
+  void sync() override;
+  /// \brief Submits an fdatasync that starts once all writes submitted
+  /// before it have completed.
+  bool submitSync() override;
+
+private:
+  struct Write {
+    std::string Buffer;
+    /// \brief File offset of the buffer.
+    size_t Offset{0};
+    /// \brief Number of bytes of the buffer written so far.
+    size_t Written{0};
+    bool InFlight{false};
+  };
+  bool setUpRing(unsigned Entries);
+  /// \brief The next free submission queue entry, cleared.
+  io_uring_sqe *nextSqe();
+  /// \brief Submit the entry returned by nextSqe().
+  bool submitSqe();
+  /// \brief Submit a write of the unwritten part of a buffer. If that fails,
+  /// the ring is no longer used and the data is written synchronously.
+  void submit(size_t Index);
+  /// \brief Handle completed writes, waiting for at least one if Wait is set.
+  void reap(bool Wait);
+  void releaseRing();
+  /// \brief Stop using the ring after an error. Writes that may not have
+  /// been submitted are repeated synchronously.
+  void abandonRing();
+
+  int RingFd{-1};
+  bool RingFailed{false};
+  int FileDescriptor{-1};
+  size_t FileSize{0};
+  std::vector<Write> Writes;
+  size_t WritesInProgress{0};
+  size_t SyncsInProgress{0};
+  size_t NextWrite{0};
+
+  // Shared memory of the ring, see io_uring_setup(2).
+  void *SqRing{nullptr};
+  size_t SqRingSize{0};
+  void *CqRing{nullptr};
+  size_t CqRingSize{0};
+  void *Sqes{nullptr};
+  size_t SqesSize{0};
+  unsigned *SqHead{nullptr};
+  unsigned *SqTail{nullptr};
+  unsigned *SqMask{nullptr};
+  unsigned *SqArray{nullptr};
+  unsigned *CqHead{nullptr};
+  unsigned *CqTail{nullptr};
+  unsigned *CqMask{nullptr};
+  void *Cqes{nullptr};
+};
+#endif
+
+} // namespace Log
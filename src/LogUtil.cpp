@@ -20,6 +20,16 @@ void BaseLogHandler::setMessageStringCreatorFunction(
   BaseLogHandler::MessageParser = std::move(ParserFunction);
 }
 
+ShutdownReport
+BaseLogHandler::shutdown(std::chrono::system_clock::duration TimeOut) {
+  ShutdownReport Report;
+  Report.Completed = flush(TimeOut);
+  if (not Report.Completed) {
+    Report.UndeliveredMessages = queueSize();
+  }
+  return Report;
+}
+
 std::string BaseLogHandler::messageToString(const LogMessage &Message) {
   if (nullptr != MessageParser) {
     return MessageParser(Message);
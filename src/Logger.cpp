@@ -21,7 +21,9 @@ Logger &Logger::Inst() {
 }
 
 Logger::Logger() {
-  Logger::addLogHandler(std::make_shared<ConsoleInterface>());
+  // Added directly rather than through the executor so that its thread is
+  // only started when the logger is used.
+  Handlers.push_back(std::make_shared<ConsoleInterface>());
 }
 
 void Logger::addLogHandler(const LogHandler_P &Handler) {
@@ -9,6 +9,7 @@
 
 #include "graylog_logger/LoggingBase.hpp"
 #include "Semaphore.hpp"
+#include <algorithm>
 #include <chrono>
 #include <ciso646>
 #include <sys/types.h>
@@ -94,25 +95,66 @@ std::string get_process_name() {
 }
 #endif
 
-LoggingBase::LoggingBase() {
-  Executor.SendWork([=]() {
+namespace {
+/// \brief Host and process name, looked up once per process. The process id
+/// is not included as it changes in a forked child.
+struct ProcessInfo {
+  ProcessInfo() {
     const int StringBufferSize = 100;
     std::array<char, StringBufferSize> StringBuffer{};
     const int res =
         gethostname(static_cast<char *>(StringBuffer.data()), StringBufferSize);
     if (0 == res) {
-      BaseMsg.Host = std::string(static_cast<char *>(StringBuffer.data()));
+      Host = std::string(static_cast<char *>(StringBuffer.data()));
     }
-    BaseMsg.ProcessId = getpid();
-    BaseMsg.ProcessName = get_process_name();
-  });
+    ProcessName = get_process_name();
+  }
+  std::string Host;
+  std::string ProcessName;
+};
+
+const ProcessInfo &processInfo() {
+  static const ProcessInfo Info;
+  return Info;
 }
+} // namespace
+
+// Nothing is done until the first message is logged, so that creating a
+// logger which is never used is cheap.
+LoggingBase::LoggingBase() = default;
 
-LoggingBase::~LoggingBase() { LoggingBase::removeAllHandlers(); }
+const LogMessage &LoggingBase::baseMessage() {
+  if (not HasProcessInfo) {
+    auto &Info = processInfo();
+    BaseMsg.Host = Info.Host;
+    BaseMsg.ProcessName = Info.ProcessName;
+    HasProcessInfo = true;
+  }
+  // Looked up for every message, so that a forked child does not report the
+  // process id of its parent.
+  BaseMsg.ProcessId = getpid();
+  return BaseMsg;
+}
+
+// The executor is destroyed before the handlers, i.e. it finishes the work
+// using them first. That includes waiting for the handlers that were still
+// shutting down when shutdown() gave up on them.
+LoggingBase::~LoggingBase() {
+  if (ShutDown.load(std::memory_order_relaxed)) {
+    Executor.SendWork([this]() {
+      for (auto &CThread : ShutdownThreads) {
+        CThread.join();
+      }
+    });
+  }
+}
 
 void LoggingBase::addLogHandler(const LogHandler_P &Handler) {
   Semaphore Check;
-  Executor.SendWork([=, &Check]() {
+  // Captured by reference as this function waits for the work to be done,
+  // so that no copy of the pointer outlives the call.
+  Executor.SendWork([this, &Handler, &Check]() {
+    std::lock_guard<std::mutex> Lock(HandlersMutex);
     Handlers.push_back(Handler);
     Check.notify();
   });
@@ -122,13 +164,72 @@ void LoggingBase::addLogHandler(const LogHandler_P &Handler) {
 void LoggingBase::removeAllHandlers() {
   Semaphore Check;
   Executor.SendWork([=, &Check]() {
+    std::lock_guard<std::mutex> Lock(HandlersMutex);
     Handlers.clear();
     Check.notify();
   });
   Check.wait();
 }
 
-std::vector<LogHandler_P> LoggingBase::getHandlers() { return Handlers; }
+ShutdownReport
+LoggingBase::shutdown(std::chrono::system_clock::duration TimeOut) {
+  using std::chrono::steady_clock;
+  auto const Deadline = steady_clock::now() + TimeOut;
+  // Handlers are given the time out but might return slightly later. The
+  // executor is waited for a little longer, so that it can report on them.
+  auto const HandlersGiveUpAt = Deadline + std::chrono::milliseconds(50);
+  auto const GiveUpAt = HandlersGiveUpAt + std::chrono::milliseconds(50);
+  ShutDown.store(true, std::memory_order_relaxed);
+  auto Done = std::make_shared<std::promise<ShutdownReport>>();
+  auto DoneFuture = Done->get_future();
+  // Queued after the messages logged before the call, so that those are
+  // handed to the handlers first.
+  Executor.SendWork([=]() {
+    auto Remaining = std::max(Deadline - steady_clock::now(),
+                              steady_clock::duration::zero());
+    std::vector<std::future<ShutdownReport>> Reports;
+    for (auto &CHandler : Handlers) {
+      // A thread of its own (rather than std::async) so that a handler that
+      // does not return in time does not block the executor. The threads are
+      // joined when the logger is destroyed.
+      std::packaged_task<ShutdownReport()> Task([=]() {
+        return CHandler->shutdown(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                Remaining));
+      });
+      Reports.push_back(Task.get_future());
+      ShutdownThreads.emplace_back(std::move(Task));
+    }
+    ShutdownReport Combined;
+    for (size_t i = 0; i < Reports.size(); ++i) {
+      if (Reports[i].wait_until(HandlersGiveUpAt) !=
+          std::future_status::ready) {
+        Combined.Completed = false;
+        Combined.UndeliveredMessages += Handlers[i]->queueSize();
+        continue;
+      }
+      auto Report = Reports[i].get();
+      Combined.Completed = Combined.Completed and Report.Completed;
+      Combined.UndeliveredMessages += Report.UndeliveredMessages;
+    }
+    Done->set_value(Combined);
+  });
+  if (DoneFuture.wait_until(GiveUpAt) != std::future_status::ready) {
+    // The executor is still busy with earlier work.
+    ShutdownReport Report;
+    Report.Completed = false;
+    for (auto &CHandler : getHandlers()) {
+      Report.UndeliveredMessages += CHandler->queueSize();
+    }
+    return Report;
+  }
+  return DoneFuture.get();
+}
+
+std::vector<LogHandler_P> LoggingBase::getHandlers() {
+  std::lock_guard<std::mutex> Lock(HandlersMutex);
+  return Handlers;
+}
 
 void LoggingBase::setMinSeverity(Severity Level) {
   auto WorkDone = std::make_shared<std::promise<void>>();
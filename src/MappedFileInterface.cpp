@@ -0,0 +1,38 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implements the memory mapped log file handler.
+///
+//===----------------------------------------------------------------------===//
+
+#include "graylog_logger/MappedFileInterface.hpp"
+#include "LogFile.hpp"
+#include "graylog_logger/Log.hpp"
+#include <ciso646>
+
+namespace Log {
+
+namespace {
+/// \brief The trailing zero bytes of a file that was not closed are removed
+/// when it is reopened, i.e. the data must not end with zero bytes. Lines of
+/// text always end with a newline, binary records and gzip trailers may not.
+FileConfig linesOnly(FileConfig Config) {
+  if (Config.Format == FileFormat::Binary or Config.Compress) {
+    Log::Msg(Severity::Warning,
+             "Memory mapped log files can not be binary or compressed.");
+    if (Config.Format == FileFormat::Binary) {
+      Config.Format = FileFormat::Text;
+    }
+    Config.Compress = false;
+  }
+  return Config;
+}
+} // namespace
+
+MappedFileInterface::MappedFileInterface(FileConfig Config, size_t ChunkSize)
+    : FileInterface(linesOnly(std::move(Config)),
+                    std::make_unique<MappedFile>(ChunkSize)) {}
+
+} // namespace Log
@@ -0,0 +1,227 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the on-disk message spool.
+///
+//===----------------------------------------------------------------------===//
+
+#include "MessageSpool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <ciso646>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Log {
+
+namespace {
+const std::string SegmentPrefix{"graylog-spool-"};
+const std::string SegmentSuffix{".seg"};
+const size_t RecordHeaderSize{sizeof(std::uint32_t)};
+} // namespace
+
+MessageSpool::MessageSpool(SpoolSettings Settings)
+    : Settings(std::move(Settings)) {
+  if (this->Settings.Directory.empty()) {
+    return;
+  }
+  if (::mkdir(this->Settings.Directory.c_str(), 0755) != 0 and
+      errno != EEXIST) {
+    return;
+  }
+  Usable = true;
+  findExistingSegments();
+}
+
+MessageSpool::~MessageSpool() {
+  unmapReadSegment();
+  if (WriteFd != -1) {
+    ::close(WriteFd);
+  }
+}
+
+std::string MessageSpool::segmentPath(std::uint64_t Number) const {
+  char Name[32];
+  std::snprintf(Name, sizeof(Name), "%016llx",
+                static_cast<unsigned long long>(Number));
+  return Settings.Directory + "/" + SegmentPrefix + Name + SegmentSuffix;
+}
+
+void MessageSpool::findExistingSegments() {
+  auto Directory = ::opendir(Settings.Directory.c_str());
+  if (Directory == nullptr) {
+    Usable = false;
+    return;
+  }
+  while (auto Entry = ::readdir(Directory)) {
+    std::string Name(Entry->d_name);
+    if (Name.size() != SegmentPrefix.size() + 16 + SegmentSuffix.size() or
+        Name.compare(0, SegmentPrefix.size(), SegmentPrefix) != 0 or
+        Name.compare(Name.size() - SegmentSuffix.size(), SegmentSuffix.size(),
+                     SegmentSuffix) != 0) {
+      continue;
+    }
+    auto Number =
+        std::strtoull(Name.c_str() + SegmentPrefix.size(), nullptr, 16);
+    struct stat FileInfo {};
+    if (::stat(segmentPath(Number).c_str(), &FileInfo) != 0) {
+      continue;
+    }
+    Segments.push_back({Number, static_cast<size_t>(FileInfo.st_size)});
+    BytesInSpool += static_cast<size_t>(FileInfo.st_size);
+  }
+  ::closedir(Directory);
+  std::sort(Segments.begin(), Segments.end(),
+            [](auto &a, auto &b) { return a.Number < b.Number; });
+  if (not Segments.empty()) {
+    NextSegmentNumber = Segments.back().Number + 1;
+  }
+}
+
+bool MessageSpool::startNewSegment() {
+  if (WriteFd != -1) {
+    ::close(WriteFd);
+    WriteFd = -1;
+  }
+  auto Number = NextSegmentNumber++;
+  WriteFd = ::open(segmentPath(Number).c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (WriteFd == -1) {
+    return false;
+  }
+  Segments.push_back({Number, 0});
+  return true;
+}
+
+bool MessageSpool::push(const std::string &Message) {
+  std::lock_guard<std::mutex> Lock(SpoolMutex);
+  auto const RecordSize = RecordHeaderSize + Message.size();
+  if (not Usable or Message.size() > UINT32_MAX or
+      BytesInSpool + RecordSize > Settings.MaxSize) {
+    ++Dropped;
+    return false;
+  }
+  if (WriteFd == -1 or Segments.back().Size >= Settings.SegmentSize) {
+    if (not startNewSegment()) {
+      ++Dropped;
+      return false;
+    }
+  }
+  auto Length = static_cast<std::uint32_t>(Message.size());
+  iovec Vectors[2];
+  Vectors[0].iov_base = &Length;
+  Vectors[0].iov_len = RecordHeaderSize;
+  Vectors[1].iov_base = const_cast<char *>(Message.data());
+  Vectors[1].iov_len = Message.size();
+  auto Written = ::writev(WriteFd, Vectors, 2);
+  if (Written != static_cast<ssize_t>(RecordSize)) {
+    // Undo a partial write so that the segment does not contain a broken
+    // record.
+    if (Written > 0 and
+        ::ftruncate(WriteFd, static_cast<off_t>(Segments.back().Size)) != 0) {
+      ::close(WriteFd);
+      WriteFd = -1;
+    }
+    ++Dropped;
+    return false;
+  }
+  Segments.back().Size += RecordSize;
+  BytesInSpool += RecordSize;
+  return true;
+}
+
+bool MessageSpool::mapReadSegment() {
+  unmapReadSegment();
+  auto &Front = Segments.front();
+  ReadFd = ::open(segmentPath(Front.Number).c_str(), O_RDONLY | O_CLOEXEC);
+  if (ReadFd == -1 or Front.Size == 0) {
+    return false;
+  }
+  auto Mapping =
+      ::mmap(nullptr, Front.Size, PROT_READ, MAP_PRIVATE, ReadFd, 0);
+  if (Mapping == MAP_FAILED) {
+    return false;
+  }
+  ReadMap = static_cast<const char *>(Mapping);
+  ReadMapSize = Front.Size;
+  return true;
+}
+
+void MessageSpool::unmapReadSegment() {
+  if (ReadMap != nullptr) {
+    ::munmap(const_cast<char *>(ReadMap), ReadMapSize);
+    ReadMap = nullptr;
+    ReadMapSize = 0;
+  }
+  if (ReadFd != -1) {
+    ::close(ReadFd);
+    ReadFd = -1;
+  }
+}
+
+void MessageSpool::removeReadSegment() {
+  unmapReadSegment();
+  auto &Front = Segments.front();
+  if (Segments.size() == 1 and WriteFd != -1) {
+    ::close(WriteFd);
+    WriteFd = -1;
+  }
+  ::unlink(segmentPath(Front.Number).c_str());
+  BytesInSpool -= Front.Size - std::min(ReadOffset, Front.Size);
+  ReadOffset = 0;
+  Segments.pop_front();
+}
+
+bool MessageSpool::pop(std::string &Message) {
+  std::lock_guard<std::mutex> Lock(SpoolMutex);
+  while (not Segments.empty()) {
+    auto &Front = Segments.front();
+    if (ReadOffset + RecordHeaderSize > ReadMapSize and
+        ReadMapSize < Front.Size) {
+      // Messages have been appended since the segment was mapped.
+      if (not mapReadSegment()) {
+        removeReadSegment();
+        continue;
+      }
+    }
+    if (ReadOffset + RecordHeaderSize > ReadMapSize) {
+      // All messages of the segment have been read. The segment is also
+      // removed if it is the one being written to, so that the spool files
+      // are deleted once the spool is empty.
+      removeReadSegment();
+      continue;
+    }
+    std::uint32_t Length{0};
+    std::memcpy(&Length, ReadMap + ReadOffset, RecordHeaderSize);
+    if (ReadOffset + RecordHeaderSize + Length > ReadMapSize) {
+      // Truncated record, e.g. after a crash. Skip the rest of the segment.
+      removeReadSegment();
+      continue;
+    }
+    Message.assign(ReadMap + ReadOffset + RecordHeaderSize, Length);
+    ReadOffset += RecordHeaderSize + Length;
+    BytesInSpool -= RecordHeaderSize + Length;
+    return true;
+  }
+  return false;
+}
+
+bool MessageSpool::empty() const {
+  std::lock_guard<std::mutex> Lock(SpoolMutex);
+  return BytesInSpool == 0;
+}
+
+size_t MessageSpool::size() const {
+  std::lock_guard<std::mutex> Lock(SpoolMutex);
+  return BytesInSpool;
+}
+
+} // namespace Log
@@ -0,0 +1,82 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief On-disk first-in first-out queue of messages.
+///
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "graylog_logger/ConnectionSettings.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace Log {
+
+/// \brief A bounded first-in first-out queue of messages stored in a
+/// directory of segment files.
+///
+/// Messages are appended to the newest segment file as a 32 bit length
+/// followed by the message. Segments are read through a read-only memory
+/// mapping and deleted once all their messages have been read. The read
+/// position is not persisted: after a restart all messages in the remaining
+/// segments are read again.
+///
+/// \note Thread safe.
+class MessageSpool {
+public:
+  explicit MessageSpool(SpoolSettings Settings);
+  ~MessageSpool();
+
+  /// \brief Append a message to the spool.
+  /// \return False if the message was dropped because the spool is full or
+  /// can not be written.
+  bool push(const std::string &Message);
+
+  /// \brief Remove the oldest message from the spool.
+  /// \return False if the spool is empty.
+  bool pop(std::string &Message);
+
+  bool empty() const;
+
+  /// \brief Size (in bytes) of the messages in the spool, including record
+  /// headers.
+  size_t size() const;
+
+  size_t messagesDropped() const { return Dropped.load(); }
+
+private:
+  struct Segment {
+    std::uint64_t Number;
+    size_t Size;
+  };
+
+  std::string segmentPath(std::uint64_t Number) const;
+  void findExistingSegments();
+  bool startNewSegment();
+  bool mapReadSegment();
+  void unmapReadSegment();
+  void removeReadSegment();
+
+  SpoolSettings Settings;
+  mutable std::mutex SpoolMutex;
+  /// \brief Oldest segment first. New messages are appended to the last
+  /// segment if WriteFd is open.
+  std::deque<Segment> Segments;
+  std::uint64_t NextSegmentNumber{0};
+  int WriteFd{-1};
+  int ReadFd{-1};
+  const char *ReadMap{nullptr};
+  size_t ReadMapSize{0};
+  size_t ReadOffset{0};
+  size_t BytesInSpool{0};
+  bool Usable{false};
+  std::atomic<size_t> Dropped{0};
+};
+
+} // namespace Log
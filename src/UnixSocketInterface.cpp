@@ -0,0 +1,154 @@
+/* Copyright (C) 2026 European Spallation Source, ERIC. See LICENSE file */
+//===----------------------------------------------------------------------===//
+///
+/// \file
+///
+/// \brief Implementation of the Unix domain socket log handler.
+///
+//===----------------------------------------------------------------------===//
+
+#include "graylog_logger/UnixSocketInterface.hpp"
+#include "GelfSerializer.hpp"
+#include <cerrno>
+#include <ciso646>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace Log {
+
+namespace {
+const auto ReconnectDelay = std::chrono::seconds(1);
+
+#ifdef MSG_NOSIGNAL
+const int SendFlags{MSG_DONTWAIT | MSG_NOSIGNAL};
+#else
+const int SendFlags{MSG_DONTWAIT};
+#endif
+} // namespace
+
+UnixSocketInterface::UnixSocketInterface(std::string SocketPath)
+    : SocketPath(std::move(SocketPath)),
+      Serializer(std::make_unique<GelfSerializer>()) {
+  std::lock_guard<std::mutex> Lock(SocketMutex);
+  connectSocket();
+}
+
+UnixSocketInterface::~UnixSocketInterface() {
+  std::lock_guard<std::mutex> Lock(SocketMutex);
+  closeSocket();
+}
+
+bool UnixSocketInterface::connectSocket() {
+  auto Now = std::chrono::steady_clock::now();
+  if (Now < NextConnectAttempt) {
+    return false;
+  }
+  NextConnectAttempt = Now + ReconnectDelay;
+  sockaddr_un Address{};
+  Address.sun_family = AF_UNIX;
+  if (SocketPath.size() >= sizeof(Address.sun_path)) {
+    return false;
+  }
+  std::memcpy(Address.sun_path, SocketPath.c_str(), SocketPath.size() + 1);
+  Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Socket == -1) {
+    return false;
+  }
+  fcntl(Socket, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int Enable{1};
+  setsockopt(Socket, SOL_SOCKET, SO_NOSIGPIPE, &Enable, sizeof(Enable));
+#endif
+  if (connect(Socket, reinterpret_cast<sockaddr *>(&Address),
+              sizeof(Address)) == -1) {
+    closeSocket();
+    return false;
+  }
+  return true;
+}
+
+void UnixSocketInterface::closeSocket() {
+  if (Socket != -1) {
+    close(Socket);
+    Socket = -1;
+  }
+  if (BytesWritten < Buffer.size()) {
+    // The relay discards the incomplete message.
+    ++MessagesDropped;
+  }
+  Buffer.clear();
+  BytesWritten = 0;
+}
+
+bool UnixSocketInterface::writePending() {
+  while (BytesWritten < Buffer.size()) {
+    auto Result = send(Socket, Buffer.data() + BytesWritten,
+                       Buffer.size() - BytesWritten, SendFlags);
+    if (Result >= 0) {
+      BytesWritten += static_cast<size_t>(Result);
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN or errno == EWOULDBLOCK) {
+      return true;
+    } else {
+      closeSocket();
+      return false;
+    }
+  }
+  return true;
+}
+
+void UnixSocketInterface::addMessage(const LogMessage &Message) {
+  std::lock_guard<std::mutex> Lock(SocketMutex);
+  if (Socket == -1 and not connectSocket()) {
+    ++MessagesDropped;
+    return;
+  }
+  // Finish writing a partially written message first in order to not break
+  // the framing.
+  if (not writePending() or BytesWritten < Buffer.size()) {
+    ++MessagesDropped;
+    return;
+  }
+  Buffer.clear();
+  BytesWritten = 0;
+  Serializer->serialize(Message, Buffer);
+  Buffer.push_back('\0');
+  if (not writePending()) {
+    return;
+  }
+  if (BytesWritten == 0) {
+    Buffer.clear();
+    ++MessagesDropped;
+  }
+}
+
+bool UnixSocketInterface::flush(std::chrono::system_clock::duration TimeOut) {
+  auto EndTime = std::chrono::system_clock::now() + TimeOut;
+  std::unique_lock<std::mutex> Lock(SocketMutex);
+  while (Socket != -1 and writePending() and BytesWritten < Buffer.size() and
+         std::chrono::system_clock::now() < EndTime) {
+    Lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    Lock.lock();
+  }
+  return BytesWritten == Buffer.size();
+}
+
+bool UnixSocketInterface::emptyQueue() { return queueSize() == 0; }
+
+size_t UnixSocketInterface::queueSize() {
+  std::lock_guard<std::mutex> Lock(SocketMutex);
+  return BytesWritten < Buffer.size() ? 1 : 0;
+}
+
+bool UnixSocketInterface::isConnected() const {
+  std::lock_guard<std::mutex> Lock(SocketMutex);
+  return Socket != -1;
+}
+
+} // namespace Log
@@ -42,3 +42,23 @@ TEST(BaseLogHandler, NewStringCreatorTest) {
   standIn.setMessageStringCreatorFunction(&MyStringCreator);
   ASSERT_EQ(standIn.messageToString(msg), testString);
 }
+
+class UnflushableHandler : public BaseLogHandlerStandIn {
+public:
+  bool flush(std::chrono::system_clock::duration) override { return false; }
+  size_t queueSize() override { return 5; }
+};
+
+TEST(BaseLogHandler, ShutdownSucceedsIfFlushSucceeds) {
+  BaseLogHandlerStandIn standIn;
+  auto Report = standIn.shutdown(std::chrono::milliseconds(10));
+  EXPECT_TRUE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 0u);
+}
+
+TEST(BaseLogHandler, ShutdownReportsQueueSizeIfFlushFails) {
+  UnflushableHandler UnderTest;
+  auto Report = UnderTest.shutdown(std::chrono::milliseconds(10));
+  EXPECT_FALSE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 5u);
+}
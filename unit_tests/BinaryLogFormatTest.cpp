@@ -0,0 +1,288 @@
+//
+//  BinaryLogFormatTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "BinaryLogFormat.hpp"
+#include "FileRotation.hpp"
+#include "graylog_logger/BinaryLogReader.hpp"
+#include "graylog_logger/FileInterface.hpp"
+#include <ciso646>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <limits>
+
+using namespace Log;
+using namespace Log::BinaryLog;
+
+namespace {
+const std::string BinaryTestName("binaryTest.bin");
+
+void writeFile(const std::string &Path, const std::string &Content) {
+  std::ofstream OutStream(Path, std::ios::binary);
+  OutStream << Content;
+}
+
+LogMessage numberedMessage(int Number) {
+  LogMessage Message;
+  Message.MessageString = "Message number " + std::to_string(Number);
+  Message.Timestamp = system_time(std::chrono::seconds(1792413045 + Number));
+  Message.SeverityLevel = Severity(Number % 9);
+  Message.Host = "host";
+  Message.ProcessName = "process";
+  Message.ProcessId = 1234;
+  Message.ThreadId = "thread";
+  Message.addField("number", std::int64_t(Number));
+  return Message;
+}
+
+/// \brief A file of numbered messages (one per second).
+std::string encodeMessages(int NrOfMessages, bool WithIndex) {
+  Encoder UnderTest;
+  std::string Out;
+  UnderTest.startSegment(Out, 0, 0);
+  for (int i = 0; i < NrOfMessages; ++i) {
+    UnderTest.encode(numberedMessage(i), Out, 0);
+  }
+  if (WithIndex) {
+    UnderTest.finishSegment(Out, 0);
+  }
+  return Out;
+}
+
+std::vector<int> readNumbers(BinaryLogReader &Reader,
+                             const BinaryLogQuery &Query) {
+  std::vector<int> Numbers;
+  Reader.read(Query, [&Numbers](const LogMessage &Message) {
+    auto &Number = Message.AdditionalFields.at(0).second;
+    Numbers.push_back(static_cast<int>(Number.intVal));
+  });
+  return Numbers;
+}
+
+std::vector<int> range(int Begin, int End, int Step = 1) {
+  std::vector<int> Numbers;
+  for (int i = Begin; i < End; i += Step) {
+    Numbers.push_back(i);
+  }
+  return Numbers;
+}
+} // namespace
+
+class BinaryLogFormat : public ::testing::Test {
+public:
+  void SetUp() override { removeTestFiles(); }
+  void TearDown() override { removeTestFiles(); }
+  void removeTestFiles() {
+    std::remove(BinaryTestName.c_str());
+    for (auto &File : findRotatedFiles(BinaryTestName)) {
+      std::remove(File.c_str());
+    }
+  }
+};
+
+TEST_F(BinaryLogFormat, VarintRoundTrip) {
+  std::vector<std::uint64_t> Values{0, 1, 127, 128, 300,
+                                    std::numeric_limits<std::uint64_t>::max()};
+  std::vector<std::int64_t> SignedValues{
+      0, -1, 1, -64, 64, std::numeric_limits<std::int64_t>::min(),
+      std::numeric_limits<std::int64_t>::max()};
+  std::string Out;
+  for (auto Value : Values) {
+    appendVarint(Out, Value);
+  }
+  for (auto Value : SignedValues) {
+    appendSignedVarint(Out, Value);
+  }
+  Decoder Input(Out.data(), Out.size());
+  for (auto Value : Values) {
+    EXPECT_EQ(Input.varint(), Value);
+  }
+  for (auto Value : SignedValues) {
+    EXPECT_EQ(Input.signedVarint(), Value);
+  }
+  EXPECT_TRUE(Input.good());
+  EXPECT_TRUE(Input.atEnd());
+  Input.varint();
+  EXPECT_FALSE(Input.good());
+}
+
+TEST_F(BinaryLogFormat, MessageRoundTrip) {
+  auto Original = numberedMessage(3);
+  Original.Timestamp = std::chrono::system_clock::now();
+  Original.addField("string", std::string("value"));
+  Original.addField("double", 3.25);
+  Original.addField("negative", std::int64_t(-42));
+  Encoder UnderTest;
+  std::string Out;
+  UnderTest.startSegment(Out, 0, 0);
+  UnderTest.encode(Original, Out, 0);
+  writeFile(BinaryTestName, Out);
+
+  BinaryLogReader Reader(BinaryTestName);
+  ASSERT_TRUE(Reader.isValid());
+  std::vector<LogMessage> Messages;
+  Reader.read([&Messages](const LogMessage &Message) {
+    Messages.push_back(Message);
+  });
+  ASSERT_EQ(Messages.size(), 1u);
+  auto &Decoded = Messages.front();
+  EXPECT_EQ(Decoded.MessageString, Original.MessageString);
+  EXPECT_EQ(Decoded.Timestamp, Original.Timestamp);
+  EXPECT_EQ(Decoded.SeverityLevel, Original.SeverityLevel);
+  EXPECT_EQ(Decoded.Host, Original.Host);
+  EXPECT_EQ(Decoded.ProcessName, Original.ProcessName);
+  EXPECT_EQ(Decoded.ProcessId, Original.ProcessId);
+  EXPECT_EQ(Decoded.ThreadId, Original.ThreadId);
+  ASSERT_EQ(Decoded.AdditionalFields.size(), 4u);
+  for (size_t i = 0; i < Decoded.AdditionalFields.size(); ++i) {
+    auto &Field = Decoded.AdditionalFields[i];
+    auto &Expected = Original.AdditionalFields[i];
+    EXPECT_EQ(Field.first, Expected.first);
+    EXPECT_EQ(Field.second.FieldType, Expected.second.FieldType);
+    EXPECT_EQ(Field.second.strVal, Expected.second.strVal);
+    EXPECT_EQ(Field.second.intVal, Expected.second.intVal);
+    EXPECT_EQ(Field.second.dblVal, Expected.second.dblVal);
+  }
+}
+
+TEST_F(BinaryLogFormat, StringsAreInterned) {
+  Encoder UnderTest;
+  std::string Out;
+  UnderTest.startSegment(Out, 0, 0);
+  auto Message = numberedMessage(1);
+  UnderTest.encode(Message, Out, 0);
+  auto FirstSize = Out.size();
+  UnderTest.encode(Message, Out, 0);
+  auto SecondSize = Out.size() - FirstSize;
+  auto Strings = Message.Host.size() + Message.ProcessName.size() +
+                 Message.ThreadId.size() +
+                 Message.AdditionalFields.front().first.size();
+  EXPECT_LT(SecondSize + Strings, FirstSize);
+}
+
+TEST_F(BinaryLogFormat, IndexIsWrittenAndFound) {
+  auto Data = encodeMessages(10, true);
+  writeFile(BinaryTestName, Data);
+  auto IndexOffset = lastIndexOffset(BinaryTestName);
+  ASSERT_GT(IndexOffset, 0u);
+  ASSERT_LT(IndexOffset, Data.size());
+  EXPECT_EQ(Data[IndexOffset], static_cast<char>(RecordType::Index));
+  EXPECT_EQ(decodeTrailer(Data.data() + Data.size() - TrailerSize),
+            IndexOffset);
+  BinaryLogReader Reader(BinaryTestName);
+  EXPECT_TRUE(Reader.hasIndex());
+  EXPECT_EQ(readNumbers(Reader, BinaryLogQuery()), range(0, 10));
+}
+
+TEST_F(BinaryLogFormat, TimeRangeQuerySeeks) {
+  const int NrOfMessages{20000};
+  auto Data = encodeMessages(NrOfMessages, true);
+  writeFile(BinaryTestName, Data);
+  BinaryLogReader Reader(BinaryTestName);
+  ASSERT_TRUE(Reader.hasIndex());
+  BinaryLogQuery Query;
+  Query.From = system_time(std::chrono::seconds(1792413045 + 15000));
+  Query.To = Query.From + std::chrono::seconds(9);
+  EXPECT_EQ(readNumbers(Reader, Query), range(15000, 15010));
+  EXPECT_LT(Reader.bytesRead(), Data.size() / 5);
+  EXPECT_EQ(readNumbers(Reader, BinaryLogQuery()), range(0, NrOfMessages));
+  EXPECT_GT(Reader.bytesRead(), Data.size() / 2);
+}
+
+TEST_F(BinaryLogFormat, SeverityQuery) {
+  writeFile(BinaryTestName, encodeMessages(100, true));
+  BinaryLogReader Reader(BinaryTestName);
+  BinaryLogQuery Query;
+  Query.MinimumSeverity = Severity::Emergency;
+  EXPECT_EQ(readNumbers(Reader, Query), range(0, 100, 9));
+}
+
+TEST_F(BinaryLogFormat, FileWithoutIndexIsScanned) {
+  auto Data = encodeMessages(100, false);
+  // A partially written record at the end of the file is ignored.
+  Data.append(encodeMessages(1, false), 0, 10);
+  writeFile(BinaryTestName, Data);
+  BinaryLogReader Reader(BinaryTestName);
+  ASSERT_TRUE(Reader.isValid());
+  EXPECT_FALSE(Reader.hasIndex());
+  BinaryLogQuery Query;
+  Query.From = system_time(std::chrono::seconds(1792413045 + 90));
+  EXPECT_EQ(readNumbers(Reader, Query), range(90, 100));
+}
+
+TEST_F(BinaryLogFormat, TextFileIsNotValid) {
+  writeFile(BinaryTestName, "2026-10-19 12:00:00 (host) Info: Message\n");
+  BinaryLogReader Reader(BinaryTestName);
+  EXPECT_FALSE(Reader.isValid());
+  EXPECT_EQ(readNumbers(Reader, BinaryLogQuery()), std::vector<int>());
+  BinaryLogReader Missing("missing" + BinaryTestName);
+  EXPECT_FALSE(Missing.isValid());
+}
+
+namespace {
+void writeBinaryMessages(FileConfig Config, int Begin, int End) {
+  Config.Format = FileFormat::Binary;
+  FileInterface UnderTest(std::move(Config));
+  for (int i = Begin; i < End; ++i) {
+    UnderTest.addMessage(numberedMessage(i));
+  }
+}
+} // namespace
+
+TEST_F(BinaryLogFormat, FileInterfaceAppendsSegments) {
+  FileConfig Config{BinaryTestName};
+  writeBinaryMessages(Config, 0, 3000);
+  writeBinaryMessages(Config, 3000, 5000);
+  BinaryLogReader Reader(BinaryTestName);
+  ASSERT_TRUE(Reader.hasIndex());
+  EXPECT_EQ(readNumbers(Reader, BinaryLogQuery()), range(0, 5000));
+  BinaryLogQuery Query;
+  Query.From = system_time(std::chrono::seconds(1792413045 + 2990));
+  Query.To = Query.From + std::chrono::seconds(19);
+  EXPECT_EQ(readNumbers(Reader, Query), range(2990, 3010));
+}
+
+TEST_F(BinaryLogFormat, FileInterfaceRotatesBetweenMessages) {
+  FileConfig Config{BinaryTestName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 10000;
+  Config.MaxRotatedFiles = 0;
+  const int NrOfMessages{5000};
+  writeBinaryMessages(Config, 0, NrOfMessages);
+  auto Files = findRotatedFiles(BinaryTestName);
+  EXPECT_GT(Files.size(), 5u);
+  Files.push_back(BinaryTestName);
+  std::vector<int> Numbers;
+  for (auto &File : Files) {
+    BinaryLogReader Reader(File);
+    ASSERT_TRUE(Reader.hasIndex());
+    auto FileNumbers = readNumbers(Reader, BinaryLogQuery());
+    Numbers.insert(Numbers.end(), FileNumbers.begin(), FileNumbers.end());
+  }
+  EXPECT_EQ(Numbers, range(0, NrOfMessages));
+}
+
+#ifdef __linux__
+TEST_F(BinaryLogFormat, FileInterfaceWritesToFallbackFile) {
+  // Writes to /dev/full fail as if the disk was full.
+  FileConfig Config{"/dev/full"};
+  Config.Format = FileFormat::Binary;
+  Config.FallbackName = BinaryTestName;
+  {
+    FileInterface UnderTest(Config);
+    for (int i = 0; i < 100; ++i) {
+      UnderTest.addMessage(numberedMessage(i));
+    }
+    ASSERT_TRUE(UnderTest.flush(std::chrono::seconds(1)));
+    EXPECT_TRUE(UnderTest.statistics().UsingFallback);
+    EXPECT_EQ(UnderTest.messagesDropped(), 0u);
+  }
+  BinaryLogReader Reader(BinaryTestName);
+  ASSERT_TRUE(Reader.hasIndex());
+  EXPECT_EQ(readNumbers(Reader, BinaryLogQuery()), range(0, 100));
+}
+#endif
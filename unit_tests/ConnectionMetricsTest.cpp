@@ -0,0 +1,55 @@
+//
+//  ConnectionMetricsTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "AtomicHistogram.hpp"
+#include <ciso646>
+#include <gtest/gtest.h>
+
+using namespace Log;
+
+TEST(AtomicHistogram, Buckets) {
+  AtomicHistogram UnderTest;
+  UnderTest.record(0);
+  UnderTest.record(1);
+  UnderTest.record(2);
+  UnderTest.record(3);
+  UnderTest.record(4);
+  UnderTest.record(1000);
+  auto Result = UnderTest.snapshot();
+  EXPECT_EQ(Result.Counts[0], 1u);
+  EXPECT_EQ(Result.Counts[1], 1u);
+  EXPECT_EQ(Result.Counts[2], 2u);
+  EXPECT_EQ(Result.Counts[3], 1u);
+  EXPECT_EQ(Result.Counts[10], 1u);
+  EXPECT_EQ(Result.count(), 6u);
+}
+
+TEST(AtomicHistogram, LargeValuesInLastBucket) {
+  AtomicHistogram UnderTest;
+  UnderTest.record(~std::uint64_t(0));
+  auto Result = UnderTest.snapshot();
+  EXPECT_EQ(Result.Counts[Histogram::NrOfBuckets - 1], 1u);
+}
+
+TEST(Histogram, EmptyPercentile) {
+  Histogram UnderTest;
+  EXPECT_EQ(UnderTest.count(), 0u);
+  EXPECT_EQ(UnderTest.percentile(0.5), 0u);
+}
+
+TEST(Histogram, Percentiles) {
+  AtomicHistogram Values;
+  for (int i = 0; i < 99; ++i) {
+    Values.record(10);
+  }
+  Values.record(5000);
+  auto UnderTest = Values.snapshot();
+  EXPECT_EQ(UnderTest.percentile(0.5), 16u);
+  EXPECT_EQ(UnderTest.percentile(0.98), 16u);
+  EXPECT_EQ(UnderTest.percentile(0.999), 8192u);
+  EXPECT_EQ(UnderTest.percentile(1.0), 8192u);
+}
@@ -0,0 +1,91 @@
+//
+//  Decompress.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "Decompress.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <array>
+#include <ciso646>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+bool IsCompressed(const std::string &Data) {
+  if (Data.size() < 2) {
+    return false;
+  }
+  auto First = static_cast<unsigned char>(Data[0]);
+  auto Second = static_cast<unsigned char>(Data[1]);
+  bool IsGzip = First == 0x1f and Second == 0x8b;
+  bool IsZlib = First == 0x78 and (First * 256 + Second) % 31 == 0;
+  return IsGzip or IsZlib;
+}
+
+#ifdef WITH_ZLIB
+std::string Decompress(const std::string &Data) {
+  z_stream Stream{};
+  // Automatic detection of zlib or gzip headers.
+  if (inflateInit2(&Stream, 15 + 32) != Z_OK) {
+    return {};
+  }
+  Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(Data.data()));
+  Stream.avail_in = uInt(Data.size());
+  std::string Result;
+  std::array<char, 16384> Buffer{};
+  int Status{Z_OK};
+  while (Status == Z_OK) {
+    Stream.next_out = reinterpret_cast<Bytef *>(Buffer.data());
+    Stream.avail_out = uInt(Buffer.size());
+    Status = inflate(&Stream, Z_NO_FLUSH);
+    Result.append(Buffer.data(), Buffer.size() - Stream.avail_out);
+  }
+  inflateEnd(&Stream);
+  if (Status != Z_STREAM_END) {
+    return {};
+  }
+  return Result;
+}
+
+std::string DecompressMembers(const std::string &Data) {
+  z_stream Stream{};
+  if (inflateInit2(&Stream, 15 + 16) != Z_OK) {
+    return {};
+  }
+  Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(Data.data()));
+  Stream.avail_in = uInt(Data.size());
+  std::string Result;
+  std::array<char, 16384> Buffer{};
+  while (Stream.avail_in > 0) {
+    Stream.next_out = reinterpret_cast<Bytef *>(Buffer.data());
+    Stream.avail_out = uInt(Buffer.size());
+    auto Status = inflate(&Stream, Z_NO_FLUSH);
+    Result.append(Buffer.data(), Buffer.size() - Stream.avail_out);
+    if (Status == Z_STREAM_END) {
+      inflateReset(&Stream);
+    } else if (Status != Z_OK) {
+      break;
+    }
+  }
+  // Flush the output of a truncated member.
+  int Status{Z_OK};
+  while (Status == Z_OK) {
+    Stream.next_out = reinterpret_cast<Bytef *>(Buffer.data());
+    Stream.avail_out = uInt(Buffer.size());
+    Status = inflate(&Stream, Z_SYNC_FLUSH);
+    Result.append(Buffer.data(), Buffer.size() - Stream.avail_out);
+    if (Stream.avail_out != 0) {
+      break;
+    }
+  }
+  inflateEnd(&Stream);
+  return Result;
+}
+#else
+std::string Decompress(const std::string &) { return {}; }
+
+std::string DecompressMembers(const std::string &) { return {}; }
+#endif
@@ -0,0 +1,22 @@
+//
+//  Decompress.hpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#pragma once
+
+#include <string>
+
+/// \brief Is the data a zlib or gzip compressed message?
+bool IsCompressed(const std::string &Data);
+
+/// \brief Decompress zlib or gzip compressed data.
+/// \return The decompressed data or an empty string on failure.
+std::string Decompress(const std::string &Data);
+
+/// \brief Decompress concatenated gzip members, e.g. a compressed log file.
+/// \return The data decompressed before the end of the input or the first
+/// error, i.e. also the readable part of a truncated file.
+std::string DecompressMembers(const std::string &Data);
@@ -7,12 +7,21 @@
 //
 
 #include "graylog_logger/FileInterface.hpp"
+#include "Decompress.hpp"
+#include "FileRotation.hpp"
+#include "FileSyncer.hpp"
+#include "LogFile.hpp"
 #include "Semaphore.hpp"
+#include "graylog_logger/LibConfig.hpp"
 #include "graylog_logger/Log.hpp"
+#include "graylog_logger/MappedFileInterface.hpp"
+#include <atomic>
+#include <cerrno>
 #include <ciso646>
 #include <cstdio>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
 
 using namespace Log;
 
@@ -66,6 +75,9 @@ public:
     if (fileExists(usedFileName)) {
       deleteFile(usedFileName);
     }
+    for (auto &File : findRotatedFiles(usedFileName)) {
+      deleteFile(File);
+    }
   };
 };
 
@@ -155,3 +167,546 @@ TEST_F(FileInterfaceTest, FlushFail) {
   Signal1.notify();
   Signal2.wait();
 }
+
+class FileInterfaceFormatStandIn : public FileInterface {
+public:
+  explicit FileInterfaceFormatStandIn(FileConfig Config)
+      : FileInterface(std::move(Config)) {}
+  using BaseLogHandler::messageToString;
+};
+
+TEST_F(FileInterfaceTest, DefaultFormat) {
+  LogMessage Msg;
+  Msg.Timestamp = std::chrono::system_clock::now();
+  Msg.Host = "some_host";
+  Msg.SeverityLevel = Severity::Warning;
+  Msg.MessageString = fileTestString;
+  std::string Expected;
+  {
+    FileInterfaceFormatStandIn UnderTest(FileConfig{usedFileName});
+    Expected = UnderTest.messageToString(Msg);
+    UnderTest.addMessage(Msg);
+  }
+  std::ifstream InStream(usedFileName, std::ios::in);
+  std::string LogLine;
+  std::getline(InStream, LogLine);
+  EXPECT_EQ(LogLine, Expected);
+}
+
+TEST_F(FileInterfaceTest, MessagesAreWrittenInOrder) {
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  const int NrOfMessages{10000};
+  {
+    FileInterface UnderTest(Config);
+    auto Msg = std::make_shared<LogMessage>();
+    for (int i = 0; i < NrOfMessages; ++i) {
+      Msg->MessageString = std::to_string(i);
+      UnderTest.addSharedMessage(std::make_shared<LogMessage>(*Msg));
+    }
+    EXPECT_TRUE(UnderTest.flush(5s));
+  }
+  std::ifstream InStream(usedFileName, std::ios::in);
+  std::string LogLine;
+  int LineNr{0};
+  while (std::getline(InStream, LogLine)) {
+    auto Expected = ": " + std::to_string(LineNr);
+    ASSERT_EQ(LogLine.substr(LogLine.size() - Expected.size()), Expected);
+    ++LineNr;
+  }
+  EXPECT_EQ(LineNr, NrOfMessages);
+}
+
+TEST_F(FileInterfaceTest, FlushWritesBufferedMessages) {
+  FileInterfaceStandIn UnderTest(usedFileName);
+  UnderTest.setMessageStringCreatorFunction(FileTestStringCreator);
+  for (int i = 0; i < 10; ++i) {
+    UnderTest.addMessage(LogMessage());
+  }
+  EXPECT_TRUE(UnderTest.flush(1s));
+  std::ifstream InStream(usedFileName, std::ios::in);
+  std::string LogLine;
+  int NrOfLines{0};
+  while (std::getline(InStream, LogLine)) {
+    EXPECT_EQ(LogLine, fileTestString);
+    ++NrOfLines;
+  }
+  EXPECT_EQ(NrOfLines, 10);
+}
+
+namespace {
+std::vector<std::string> readLines(const std::string &Name) {
+  std::ifstream InStream(Name, std::ios::in);
+  std::vector<std::string> Lines;
+  std::string Line;
+  while (std::getline(InStream, Line)) {
+    Lines.push_back(Line);
+  }
+  return Lines;
+}
+
+void writeNumberedMessages(FileInterface &UnderTest, int NrOfMessages) {
+  UnderTest.setMessageStringCreatorFunction(
+      [](const LogMessage &Msg) { return Msg.MessageString; });
+  for (int i = 0; i < NrOfMessages; ++i) {
+    auto Msg = std::make_shared<LogMessage>();
+    Msg->MessageString = std::to_string(i);
+    UnderTest.addSharedMessage(Msg);
+  }
+}
+
+void writeNumberedMessages(FileConfig Config, int NrOfMessages) {
+  FileInterface UnderTest(std::move(Config));
+  writeNumberedMessages(UnderTest, NrOfMessages);
+}
+} // namespace
+
+TEST_F(FileInterfaceTest, JsonLinesContainAllFields) {
+  FileConfig Config{usedFileName};
+  Config.Format = FileFormat::Json;
+  LogMessage Message;
+  Message.MessageString = "A message\nspanning \"two\" lines";
+  Message.Timestamp = system_time(std::chrono::milliseconds(1792413045123));
+  Message.SeverityLevel = Severity::Warning;
+  Message.Host = "some_host";
+  Message.ProcessName = "some_process";
+  Message.ProcessId = 4321;
+  Message.ThreadId = "0x1234";
+  Message.addField("string", std::string("value"));
+  Message.addField("int", std::int64_t(-42));
+  Message.addField("double", 3.25);
+  {
+    FileInterface UnderTest(Config);
+    // Only used for text files.
+    UnderTest.setMessageStringCreatorFunction(FileTestStringCreator);
+    UnderTest.addMessage(Message);
+    Message.AdditionalFields.clear();
+    UnderTest.addMessage(Message);
+  }
+  auto Lines = readLines(usedFileName);
+  ASSERT_EQ(Lines.size(), 2u);
+  auto First = nlohmann::json::parse(Lines[0]);
+  EXPECT_EQ(First["short_message"], Message.MessageString);
+  EXPECT_EQ(First["timestamp"], 1792413045.123);
+  EXPECT_EQ(First["level"], int(Severity::Warning));
+  EXPECT_EQ(First["host"], "some_host");
+  EXPECT_EQ(First["_process"], "some_process");
+  EXPECT_EQ(First["_process_id"], 4321);
+  EXPECT_EQ(First["_thread_id"], "0x1234");
+  EXPECT_EQ(First["_string"], "value");
+  EXPECT_EQ(First["_int"], -42);
+  EXPECT_EQ(First["_double"], 3.25);
+  auto Second = nlohmann::json::parse(Lines[1]);
+  EXPECT_EQ(Second["short_message"], Message.MessageString);
+  EXPECT_EQ(Second.count("_string"), 0u);
+}
+
+TEST_F(FileInterfaceTest, SizeRotationKeepsEveryLine) {
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 1000;
+  Config.MaxRotatedFiles = 0;
+  const int NrOfMessages{5000};
+  writeNumberedMessages(Config, NrOfMessages);
+  auto Files = findRotatedFiles(usedFileName);
+  EXPECT_GT(Files.size(), 10u);
+  Files.push_back(usedFileName);
+  int LineNr{0};
+  for (auto &File : Files) {
+    struct stat FileStats {};
+    ASSERT_EQ(stat(File.c_str(), &FileStats), 0);
+    EXPECT_LE(FileStats.st_size, 1000);
+    for (auto &Line : readLines(File)) {
+      ASSERT_EQ(Line, std::to_string(LineNr));
+      ++LineNr;
+    }
+  }
+  EXPECT_EQ(LineNr, NrOfMessages);
+}
+
+TEST_F(FileInterfaceTest, OldRotatedFilesAreDeleted) {
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 1000;
+  Config.MaxRotatedFiles = 3;
+  writeNumberedMessages(Config, 5000);
+  auto Files = findRotatedFiles(usedFileName);
+  ASSERT_EQ(Files.size(), 3u);
+  // The newest files are kept.
+  auto LastLines = readLines(usedFileName);
+  auto Lines = readLines(Files.back());
+  ASSERT_FALSE(Lines.empty());
+  auto NextLine = std::stoi(Lines.back()) + 1;
+  EXPECT_EQ(LastLines.empty() ? 5000 : std::stoi(LastLines.front()),
+            NextLine);
+}
+
+#ifdef WITH_ZLIB
+TEST_F(FileInterfaceTest, RotatedFilesAreCompressed) {
+  FileConfig Config{usedFileName};
+  Config.MaxFileSize = 1000;
+  Config.CompressRotatedFiles = true;
+  writeNumberedMessages(Config, 1000);
+  auto Files = findRotatedFiles(usedFileName);
+  ASSERT_FALSE(Files.empty());
+  for (auto &File : Files) {
+    EXPECT_EQ(File.substr(File.size() - 3), ".gz");
+  }
+}
+
+TEST_F(FileInterfaceTest, CompressedFileKeepsEveryLine) {
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 2000;
+  Config.MaxRotatedFiles = 0;
+  Config.CompressRotatedFiles = true;
+  Config.Compress = true;
+  Config.CompressionFrameSize = 1000;
+  const int NrOfMessages{5000};
+  CompressionStatistics Statistics;
+  {
+    FileInterface UnderTest(Config);
+    writeNumberedMessages(UnderTest, NrOfMessages);
+    UnderTest.flush(std::chrono::seconds(10));
+    Statistics = UnderTest.compressionStatistics();
+  }
+  EXPECT_GT(Statistics.ratio(), 1.5);
+  auto Files = findRotatedFiles(usedFileName);
+  EXPECT_GT(Files.size(), 2u);
+  Files.push_back(usedFileName);
+  std::string Expected;
+  for (int i = 0; i < NrOfMessages; ++i) {
+    Expected += std::to_string(i) + "\n";
+  }
+  std::string Lines;
+  for (auto &File : Files) {
+    // Rotated files are not compressed a second time.
+    EXPECT_NE(File.substr(File.size() - 3), ".gz");
+    std::ifstream InStream(File, std::ios::binary);
+    std::string Compressed((std::istreambuf_iterator<char>(InStream)),
+                           std::istreambuf_iterator<char>());
+    // Finishing the last frame may add a few bytes.
+    EXPECT_LE(Compressed.size(), 2000u + 64u);
+    Lines += DecompressMembers(Compressed);
+  }
+  EXPECT_EQ(Lines, Expected);
+}
+#endif
+
+TEST_F(FileInterfaceTest, MappedFileKeepsEveryLine) {
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 10000;
+  Config.MaxRotatedFiles = 0;
+  const int NrOfMessages{20000};
+  {
+    MappedFileInterface UnderTest(Config, 4096);
+    writeNumberedMessages(UnderTest, NrOfMessages);
+  }
+  auto Files = findRotatedFiles(usedFileName);
+  EXPECT_GT(Files.size(), 5u);
+  Files.push_back(usedFileName);
+  int LineNr{0};
+  for (auto &File : Files) {
+    for (auto &Line : readLines(File)) {
+      ASSERT_EQ(Line, std::to_string(LineNr));
+      ++LineNr;
+    }
+  }
+  EXPECT_EQ(LineNr, NrOfMessages);
+}
+
+TEST_F(FileInterfaceTest, ReopenedMappedFileKeepsEveryLine) {
+  // Compressed files could end with zero bytes, which would be removed when
+  // the file is reopened; they are written as text instead.
+  FileConfig Config{usedFileName};
+  Config.Compress = true;
+  for (int i = 0; i < 2; ++i) {
+    MappedFileInterface UnderTest(Config, 4096);
+    writeNumberedMessages(UnderTest, 100);
+  }
+  auto Lines = readLines(usedFileName);
+  ASSERT_EQ(Lines.size(), 200u);
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(Lines[i], std::to_string(i % 100));
+  }
+}
+
+TEST_F(FileInterfaceTest, IoUringKeepsEveryLine) {
+  // Falls back to write() where io_uring is not available.
+  FileConfig Config{usedFileName};
+  Config.BufferSize = 256;
+  Config.MaxFileSize = 10000;
+  Config.MaxRotatedFiles = 0;
+  Config.UseIoUring = true;
+  const int NrOfMessages{20000};
+  writeNumberedMessages(Config, NrOfMessages);
+  auto Files = findRotatedFiles(usedFileName);
+  Files.push_back(usedFileName);
+  int LineNr{0};
+  for (auto &File : Files) {
+    for (auto &Line : readLines(File)) {
+      ASSERT_EQ(Line, std::to_string(LineNr));
+      ++LineNr;
+    }
+  }
+  EXPECT_EQ(LineNr, NrOfMessages);
+}
+
+TEST_F(FileInterfaceTest, IoUringFlushWritesMessages) {
+  FileConfig Config{usedFileName};
+  Config.UseIoUring = true;
+  FileInterface UnderTest(Config);
+  UnderTest.setMessageStringCreatorFunction(FileTestStringCreator);
+  for (int i = 0; i < 10; ++i) {
+    UnderTest.addMessage(LogMessage());
+  }
+  EXPECT_TRUE(UnderTest.flush(1s));
+  auto Lines = readLines(usedFileName);
+  EXPECT_EQ(Lines, std::vector<std::string>(10, fileTestString));
+}
+
+class FileInterfaceSyncStandIn : public FileInterface {
+public:
+  explicit FileInterfaceSyncStandIn(FileConfig Config)
+      : FileInterface(std::move(Config)) {}
+  size_t syncs() { return Syncer == nullptr ? 0 : Syncer->syncs(); }
+  bool waitForSyncs(size_t Syncs) {
+    auto Deadline = std::chrono::steady_clock::now() + 5s;
+    while (syncs() < Syncs and std::chrono::steady_clock::now() < Deadline) {
+      std::this_thread::sleep_for(1ms);
+    }
+    return syncs() >= Syncs;
+  }
+};
+
+TEST_F(FileInterfaceTest, NoSyncsByDefault) {
+  FileInterfaceSyncStandIn UnderTest(FileConfig{usedFileName});
+  for (int i = 0; i < 100; ++i) {
+    UnderTest.addMessage(LogMessage());
+  }
+  EXPECT_TRUE(UnderTest.flush(1s));
+  EXPECT_EQ(UnderTest.syncs(), 0u);
+}
+
+TEST_F(FileInterfaceTest, SyncEveryNMessages) {
+  FileConfig Config{usedFileName};
+  Config.Durability.EveryNMessages = 10;
+  FileInterfaceSyncStandIn UnderTest(Config);
+  for (int i = 0; i < 9; ++i) {
+    UnderTest.addMessage(LogMessage());
+  }
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(UnderTest.syncs(), 0u);
+  UnderTest.addMessage(LogMessage());
+  EXPECT_TRUE(UnderTest.waitForSyncs(1));
+}
+
+TEST_F(FileInterfaceTest, SyncOnSeverity) {
+  FileConfig Config{usedFileName};
+  Config.Durability.SyncOnSeverity = true;
+  Config.Durability.MinimumSeverity = Severity::Error;
+  FileInterfaceSyncStandIn UnderTest(Config);
+  LogMessage Msg;
+  Msg.SeverityLevel = Severity::Warning;
+  UnderTest.addMessage(Msg);
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(UnderTest.syncs(), 0u);
+  Msg.SeverityLevel = Severity::Critical;
+  Msg.MessageString = fileTestString;
+  UnderTest.addMessage(Msg);
+  EXPECT_TRUE(UnderTest.waitForSyncs(1));
+  // Written before the sync was requested.
+  auto Lines = readLines(usedFileName);
+  ASSERT_EQ(Lines.size(), 2u);
+  EXPECT_NE(Lines[1].find(fileTestString), std::string::npos);
+}
+
+TEST_F(FileInterfaceTest, SyncAfterInterval) {
+  FileConfig Config{usedFileName};
+  Config.Durability.Interval = 20ms;
+  FileInterfaceSyncStandIn UnderTest(Config);
+  UnderTest.addMessage(LogMessage());
+  EXPECT_TRUE(UnderTest.waitForSyncs(1));
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(UnderTest.syncs(), 1u);
+}
+
+TEST_F(FileInterfaceTest, IoUringSyncKeepsEveryLine) {
+  FileConfig Config{usedFileName};
+  Config.UseIoUring = true;
+  Config.Durability.EveryNMessages = 7;
+  Config.Durability.Interval = 1ms;
+  const int NrOfMessages{2000};
+  writeNumberedMessages(Config, NrOfMessages);
+  auto Lines = readLines(usedFileName);
+  ASSERT_EQ(Lines.size(), static_cast<size_t>(NrOfMessages));
+  for (int i = 0; i < NrOfMessages; ++i) {
+    ASSERT_EQ(Lines[i], std::to_string(i));
+  }
+}
+
+namespace {
+/// \brief Writes to and syncs of the log file (but not of other files) fail
+/// while DiskFull is set.
+class DiskFullFile : public AppendFile {
+public:
+  explicit DiskFullFile(std::atomic<bool> &DiskFull) : DiskFull(DiskFull) {}
+  bool open(const std::string &Name) override {
+    IsLogFile = Name == usedFileName;
+    return AppendFile::open(Name);
+  }
+  size_t write(const char *Data, size_t Size) override {
+    if (DiskFull and IsLogFile) {
+      Error = ENOSPC;
+      return 0;
+    }
+    return AppendFile::write(Data, Size);
+  }
+  void sync() override {
+    if (DiskFull and IsLogFile) {
+      Error = ENOSPC;
+      return;
+    }
+    AppendFile::sync();
+  }
+
+private:
+  std::atomic<bool> &DiskFull;
+  bool IsLogFile{false};
+};
+
+class FileInterfaceFailureStandIn : public FileInterface {
+public:
+  FileInterfaceFailureStandIn(FileConfig Config, std::atomic<bool> &DiskFull)
+      : FileInterface(std::move(Config),
+                      std::make_unique<DiskFullFile>(DiskFull)) {
+    setMessageStringCreatorFunction(
+        [](const LogMessage &Msg) { return Msg.MessageString; });
+  }
+  using FileInterface::Executor;
+  void addMessages(int First, int Last) {
+    for (int i = First; i < Last; ++i) {
+      auto Msg = std::make_shared<LogMessage>();
+      Msg->MessageString = std::to_string(i);
+      addSharedMessage(Msg);
+    }
+  }
+};
+
+std::vector<std::string> numbers(int First, int Last) {
+  std::vector<std::string> Numbers;
+  for (int i = First; i < Last; ++i) {
+    Numbers.push_back(std::to_string(i));
+  }
+  return Numbers;
+}
+
+const std::string FallbackFileName("testFileName.fallback.log");
+} // namespace
+
+TEST_F(FileInterfaceTest, DiskFullDropsMessagesUntilSpaceReturns) {
+  std::atomic<bool> DiskFull{false};
+  FileConfig Config{usedFileName};
+  Config.RetryInterval = 0ms;
+  FileInterfaceFailureStandIn UnderTest(Config, DiskFull);
+  UnderTest.addMessages(0, 5);
+  ASSERT_TRUE(UnderTest.flush(1s));
+  DiskFull = true;
+  UnderTest.addMessages(5, 15);
+  ASSERT_TRUE(UnderTest.flush(1s));
+  auto Statistics = UnderTest.statistics();
+  EXPECT_TRUE(Statistics.WriteFailed);
+  EXPECT_FALSE(Statistics.UsingFallback);
+  EXPECT_EQ(Statistics.MessagesDroppedWriteFailed, 10u);
+  EXPECT_EQ(Statistics.BytesDropped, 25u);
+  EXPECT_GE(Statistics.WriteErrors, 1u);
+  EXPECT_EQ(Statistics.LastError, ENOSPC);
+  DiskFull = false;
+  UnderTest.addMessages(15, 20);
+  ASSERT_TRUE(UnderTest.flush(1s));
+  EXPECT_FALSE(UnderTest.statistics().WriteFailed);
+  EXPECT_EQ(UnderTest.messagesDropped(), 10u);
+  auto Expected = numbers(0, 5);
+  auto Recovered = numbers(15, 20);
+  Expected.insert(Expected.end(), Recovered.begin(), Recovered.end());
+  EXPECT_EQ(readLines(usedFileName), Expected);
+}
+
+TEST_F(FileInterfaceTest, DiskFullSwitchesToFallbackFile) {
+  std::remove(FallbackFileName.c_str());
+  std::atomic<bool> DiskFull{false};
+  FileConfig Config{usedFileName};
+  Config.FallbackName = FallbackFileName;
+  Config.RetryInterval = 0ms;
+  {
+    FileInterfaceFailureStandIn UnderTest(Config, DiskFull);
+    UnderTest.addMessages(0, 5);
+    ASSERT_TRUE(UnderTest.flush(1s));
+    DiskFull = true;
+    UnderTest.addMessages(5, 15);
+    ASSERT_TRUE(UnderTest.flush(1s));
+    auto Statistics = UnderTest.statistics();
+    EXPECT_TRUE(Statistics.WriteFailed);
+    EXPECT_TRUE(Statistics.UsingFallback);
+    DiskFull = false;
+    UnderTest.addMessages(15, 20);
+    ASSERT_TRUE(UnderTest.flush(1s));
+    EXPECT_FALSE(UnderTest.statistics().UsingFallback);
+    EXPECT_EQ(UnderTest.messagesDropped(), 0u);
+  }
+  auto Expected = numbers(0, 5);
+  auto Recovered = numbers(15, 20);
+  Expected.insert(Expected.end(), Recovered.begin(), Recovered.end());
+  EXPECT_EQ(readLines(usedFileName), Expected);
+  EXPECT_EQ(readLines(FallbackFileName), numbers(5, 15));
+  std::remove(FallbackFileName.c_str());
+}
+
+TEST_F(FileInterfaceTest, FailedSyncIsReported) {
+  std::remove(FallbackFileName.c_str());
+  std::atomic<bool> DiskFull{false};
+  FileConfig Config{usedFileName};
+  Config.Durability.Interval = 10s;
+  Config.FallbackName = FallbackFileName;
+  Config.RetryInterval = 1h;
+  {
+    FileInterfaceFailureStandIn UnderTest(Config, DiskFull);
+    UnderTest.addMessages(0, 5);
+    ASSERT_TRUE(UnderTest.flush(1s));
+    DiskFull = true;
+    EXPECT_FALSE(UnderTest.flush(1s));
+    auto Statistics = UnderTest.statistics();
+    EXPECT_TRUE(Statistics.WriteFailed);
+    EXPECT_TRUE(Statistics.UsingFallback);
+    EXPECT_EQ(Statistics.LastError, ENOSPC);
+    UnderTest.addMessages(5, 10);
+    EXPECT_TRUE(UnderTest.flush(1s));
+  }
+  EXPECT_EQ(readLines(usedFileName), numbers(0, 5));
+  EXPECT_EQ(readLines(FallbackFileName), numbers(5, 10));
+  std::remove(FallbackFileName.c_str());
+}
+
+TEST_F(FileInterfaceTest, FullQueueDropsMessages) {
+  std::atomic<bool> DiskFull{false};
+  FileConfig Config{usedFileName};
+  Config.MaxQueuedBytes = 10 * (sizeof(LogMessage) + 10);
+  FileInterfaceFailureStandIn UnderTest(Config, DiskFull);
+  // Stands in for a slow disk.
+  Semaphore Blocked, Release;
+  UnderTest.Executor.SendWork([&]() {
+    Blocked.notify();
+    Release.wait();
+  });
+  Blocked.wait();
+  const int NrOfMessages{100};
+  UnderTest.addMessages(0, NrOfMessages);
+  auto Statistics = UnderTest.statistics();
+  EXPECT_EQ(Statistics.MessagesDroppedQueueFull, 90u);
+  EXPECT_LE(Statistics.QueuedBytes, Config.MaxQueuedBytes);
+  Release.notify();
+  ASSERT_TRUE(UnderTest.flush(1s));
+  EXPECT_EQ(UnderTest.statistics().QueuedBytes, 0u);
+  EXPECT_EQ(readLines(usedFileName), numbers(0, 10));
+}
@@ -0,0 +1,132 @@
+//
+//  FileRotationTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "Decompress.hpp"
+#include "FileRotation.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <ciso646>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace Log;
+
+namespace {
+const std::string RotationTestName("rotationTest.log");
+
+bool pathExists(const std::string &Path) {
+  struct stat FileInfo {};
+  return stat(Path.c_str(), &FileInfo) == 0;
+}
+
+void writeFile(const std::string &Path, const std::string &Content) {
+  std::ofstream OutStream(Path, std::ios::binary);
+  OutStream << Content;
+}
+
+std::string readFile(const std::string &Path) {
+  std::ifstream InStream(Path, std::ios::binary);
+  std::stringstream Content;
+  Content << InStream.rdbuf();
+  return Content.str();
+}
+} // namespace
+
+class FileRotation : public ::testing::Test {
+public:
+  void SetUp() override { removeTestFiles(); }
+  void TearDown() override { removeTestFiles(); }
+  void removeTestFiles() {
+    for (auto &File : findRotatedFiles(RotationTestName)) {
+      std::remove(File.c_str());
+    }
+    for (auto &File : ExtraFiles) {
+      std::remove((RotationTestName + File).c_str());
+    }
+  }
+  std::vector<std::string> ExtraFiles{"", ".other", ".20260101-000000.tmp",
+                                      ".20260101-000000.gz.tmp"};
+};
+
+TEST_F(FileRotation, NameContainsUtcTime) {
+  EXPECT_EQ(rotatedFileName(RotationTestName, 0),
+            RotationTestName + ".19700101-000000");
+  EXPECT_EQ(rotatedFileName(RotationTestName, 1792413045),
+            RotationTestName + ".20261019-123045");
+}
+
+TEST_F(FileRotation, NameIsUnique) {
+  auto First = rotatedFileName(RotationTestName, 0);
+  writeFile(First, "a");
+  auto Second = rotatedFileName(RotationTestName, 0);
+  EXPECT_EQ(Second, First + ".1");
+  writeFile(Second + ".gz", "b");
+  EXPECT_EQ(rotatedFileName(RotationTestName, 0), First + ".2");
+  // Counters of deleted files are not reused.
+  std::remove(First.c_str());
+  EXPECT_EQ(rotatedFileName(RotationTestName, 0), First + ".2");
+}
+
+TEST_F(FileRotation, FindsRotatedFilesOldestFirst) {
+  std::vector<std::string> Expected{
+      RotationTestName + ".20250101-000000.gz",
+      RotationTestName + ".20260101-000000",
+      RotationTestName + ".20260101-000000.2",
+      RotationTestName + ".20260101-000000.10.gz"};
+  for (auto i : {2, 0, 3, 1}) {
+    writeFile(Expected[i], "data");
+  }
+  for (auto &File : ExtraFiles) {
+    writeFile(RotationTestName + File, "data");
+  }
+  EXPECT_EQ(findRotatedFiles(RotationTestName), Expected);
+}
+
+TEST_F(FileRotation, RemovesOldestFiles) {
+  for (int i = 0; i < 5; ++i) {
+    writeFile(rotatedFileName(RotationTestName, i * 3600), "data");
+  }
+  removeOldRotatedFiles(RotationTestName, 2);
+  std::vector<std::string> Expected{RotationTestName + ".19700101-030000",
+                                    RotationTestName + ".19700101-040000"};
+  EXPECT_EQ(findRotatedFiles(RotationTestName), Expected);
+}
+
+TEST_F(FileRotation, NextRotationTimeIsAligned) {
+  using std::chrono::hours;
+  using std::chrono::seconds;
+  using std::chrono::system_clock;
+  auto Now = system_clock::time_point(seconds(1792413045));
+  EXPECT_EQ(nextRotationTime(Now, hours(1)),
+            system_clock::time_point(seconds(1792414800)));
+  auto OnTheHour = system_clock::time_point(seconds(1792414800));
+  EXPECT_EQ(nextRotationTime(OnTheHour, hours(1)), OnTheHour + hours(1));
+}
+
+#ifdef WITH_ZLIB
+TEST_F(FileRotation, CompressedFileCanBeDecompressed) {
+  auto Path = rotatedFileName(RotationTestName, 0);
+  std::string Content;
+  for (int i = 0; i < 10000; ++i) {
+    Content += "Log line number " + std::to_string(i) + "\n";
+  }
+  writeFile(Path, Content);
+  ASSERT_TRUE(compressFile(Path));
+  EXPECT_FALSE(pathExists(Path));
+  auto Compressed = readFile(Path + ".gz");
+  EXPECT_LT(Compressed.size(), Content.size());
+  EXPECT_EQ(Decompress(Compressed), Content);
+}
+#endif
+
+TEST_F(FileRotation, FailedCompressionKeepsFile) {
+  auto Path = rotatedFileName(RotationTestName, 0);
+  EXPECT_FALSE(compressFile(Path));
+  EXPECT_FALSE(pathExists(Path + ".gz"));
+}
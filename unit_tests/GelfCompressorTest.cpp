@@ -0,0 +1,110 @@
+//
+//  GelfCompressorTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "Decompress.hpp"
+#include "GelfCompressor.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <ciso646>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace Log;
+
+#ifdef WITH_ZLIB
+
+namespace {
+std::string GetCompressibleMessage() {
+  std::string Message;
+  for (int i = 0; Message.size() < 4000; ++i) {
+    Message += R"({"version":"1.1","host":"some_host","short_message":")" +
+               std::to_string(i) + "\"}";
+  }
+  return Message;
+}
+} // namespace
+
+TEST(GelfCompressor, NoCompression) {
+  GelfCompressor UnderTest(CompressionSettings{});
+  std::string Out;
+  EXPECT_FALSE(UnderTest.compress(GetCompressibleMessage(), Out));
+  EXPECT_EQ(UnderTest.statistics().MessagesUncompressed, 1u);
+}
+
+TEST(GelfCompressor, BelowThresholdIsNotCompressed) {
+  GelfCompressor UnderTest({Compression::Gzip, -1, 100});
+  std::string Out;
+  EXPECT_FALSE(UnderTest.compress(std::string(99, 'a'), Out));
+  EXPECT_TRUE(UnderTest.compress(std::string(100, 'a'), Out));
+}
+
+TEST(GelfCompressor, IncompressibleMessageIsNotCompressed) {
+  GelfCompressor UnderTest({Compression::Gzip, -1, 0});
+  std::minstd_rand Generator;
+  std::string Message;
+  for (int i = 0; i < 200; ++i) {
+    Message.push_back(static_cast<char>(Generator()));
+  }
+  std::string Out;
+  EXPECT_FALSE(UnderTest.compress(Message, Out));
+  EXPECT_EQ(UnderTest.statistics().MessagesUncompressed, 1u);
+}
+
+TEST(GelfCompressor, GzipRoundTrip) {
+  GelfCompressor UnderTest({Compression::Gzip, 9, 0});
+  auto Message = GetCompressibleMessage();
+  std::string Out;
+  ASSERT_TRUE(UnderTest.compress(Message, Out));
+  EXPECT_EQ(static_cast<unsigned char>(Out[0]), 0x1f);
+  EXPECT_EQ(static_cast<unsigned char>(Out[1]), 0x8b);
+  EXPECT_EQ(Decompress(Out), Message);
+}
+
+TEST(GelfCompressor, ZlibRoundTrip) {
+  GelfCompressor UnderTest({Compression::Zlib, 1, 0});
+  auto Message = GetCompressibleMessage();
+  std::string Out;
+  ASSERT_TRUE(UnderTest.compress(Message, Out));
+  EXPECT_TRUE(IsCompressed(Out));
+  EXPECT_EQ(static_cast<unsigned char>(Out[0]), 0x78);
+  EXPECT_EQ(Decompress(Out), Message);
+}
+
+TEST(GelfCompressor, StateIsReusedBetweenMessages) {
+  GelfCompressor UnderTest({Compression::Gzip, -1, 0});
+  std::string Out;
+  for (int i = 0; i < 10; ++i) {
+    auto Message = GetCompressibleMessage() + std::to_string(i);
+    ASSERT_TRUE(UnderTest.compress(Message, Out));
+    EXPECT_EQ(Decompress(Out), Message);
+  }
+}
+
+TEST(GelfCompressor, Statistics) {
+  GelfCompressor UnderTest({Compression::Gzip, -1, 100});
+  auto Message = GetCompressibleMessage();
+  std::string Out;
+  UnderTest.compress(Message, Out);
+  UnderTest.compress(Message, Out);
+  UnderTest.compress("Too short", Out);
+  auto Statistics = UnderTest.statistics();
+  EXPECT_EQ(Statistics.MessagesCompressed, 2u);
+  EXPECT_EQ(Statistics.MessagesUncompressed, 1u);
+  EXPECT_EQ(Statistics.BytesIn, 2 * Message.size());
+  EXPECT_EQ(Statistics.BytesOut, 2 * Out.size());
+  EXPECT_GT(Statistics.ratio(), 5.0);
+  EXPECT_GT(Statistics.CpuTime.count(), 0);
+}
+
+#else
+
+TEST(GelfCompressor, WithoutZlibMessagesAreNotCompressed) {
+  GelfCompressor UnderTest({Compression::Gzip, -1, 0});
+  std::string Out;
+  EXPECT_FALSE(UnderTest.compress(std::string(1000, 'a'), Out));
+}
+
+#endif
@@ -0,0 +1,101 @@
+//
+//  GelfSerializerTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "GelfSerializer.hpp"
+#include <ciso646>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+using namespace Log;
+
+namespace {
+LogMessage GetSerializerTestMsg() {
+  LogMessage retMsg;
+  retMsg.Host = "Some host";
+  retMsg.MessageString = "A message with \"quotes\",\ttabs and\nnew lines.";
+  retMsg.ProcessId = 667;
+  retMsg.ProcessName = "some_process_name";
+  retMsg.SeverityLevel = Severity::Warning;
+  retMsg.ThreadId = "0xff0011aacc";
+  retMsg.Timestamp = system_time(std::chrono::milliseconds(1234567890123));
+  return retMsg;
+}
+} // namespace
+
+TEST(GelfSerializer, StandardFields) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  auto JsonObject = nlohmann::json::parse(UnderTest.serialize(TestMsg));
+  EXPECT_EQ(JsonObject["version"], "1.1");
+  EXPECT_EQ(JsonObject["host"], TestMsg.Host);
+  EXPECT_EQ(JsonObject["short_message"], TestMsg.MessageString);
+  EXPECT_EQ(JsonObject["level"], int(TestMsg.SeverityLevel));
+  EXPECT_EQ(JsonObject["_process_id"], TestMsg.ProcessId);
+  EXPECT_EQ(JsonObject["_process"], TestMsg.ProcessName);
+  EXPECT_EQ(JsonObject["_thread_id"], TestMsg.ThreadId);
+  EXPECT_DOUBLE_EQ(JsonObject["timestamp"].get<double>(), 1234567890.123);
+  EXPECT_EQ(JsonObject.size(), 8u);
+}
+
+TEST(GelfSerializer, HeaderIsOnlyBuiltOnce) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  for (int i = 0; i < 10; ++i) {
+    TestMsg.MessageString = "Message nr. " + std::to_string(i);
+    auto JsonObject = nlohmann::json::parse(UnderTest.serialize(TestMsg));
+    EXPECT_EQ(JsonObject["short_message"], TestMsg.MessageString);
+  }
+  EXPECT_EQ(UnderTest.headerRebuilds(), 1u);
+}
+
+TEST(GelfSerializer, HeaderIsRebuiltOnChange) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  UnderTest.serialize(TestMsg);
+  TestMsg.Host = "Some other host";
+  auto JsonObject = nlohmann::json::parse(UnderTest.serialize(TestMsg));
+  EXPECT_EQ(JsonObject["host"], TestMsg.Host);
+  EXPECT_EQ(UnderTest.headerRebuilds(), 2u);
+}
+
+TEST(GelfSerializer, AdditionalFields) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  TestMsg.addField("a_string", std::string("some \\ string"));
+  TestMsg.addField("an_int", std::int64_t(-9223372036854775807 - 1));
+  TestMsg.addField("a_double", 0.1);
+  TestMsg.addField("not_a_number", std::numeric_limits<double>::quiet_NaN());
+  auto JsonObject = nlohmann::json::parse(UnderTest.serialize(TestMsg));
+  EXPECT_EQ(JsonObject["_a_string"], "some \\ string");
+  EXPECT_EQ(JsonObject["_an_int"].get<std::int64_t>(),
+            std::numeric_limits<std::int64_t>::min());
+  EXPECT_EQ(JsonObject["_a_double"].get<double>(), 0.1);
+  EXPECT_TRUE(JsonObject["_not_a_number"].is_null());
+}
+
+TEST(GelfSerializer, AdditionalFieldOverridesStandardField) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  TestMsg.addField("process", std::string("other_name"));
+  TestMsg.addField("thread_id", std::int64_t(42));
+  auto JsonString = UnderTest.serialize(TestMsg);
+  auto JsonObject = nlohmann::json::parse(JsonString);
+  EXPECT_EQ(JsonObject["_process"], "other_name");
+  EXPECT_EQ(JsonObject["_thread_id"], 42);
+  EXPECT_EQ(JsonObject["_process_id"], TestMsg.ProcessId);
+  EXPECT_EQ(JsonString.find("some_process_name"), std::string::npos);
+}
+
+TEST(GelfSerializer, ControlCharactersAreEscaped) {
+  GelfSerializer UnderTest;
+  auto TestMsg = GetSerializerTestMsg();
+  TestMsg.MessageString = std::string("\x01\x1f\b\f\r", 5);
+  auto JsonObject = nlohmann::json::parse(UnderTest.serialize(TestMsg));
+  EXPECT_EQ(JsonObject["short_message"], TestMsg.MessageString);
+}
@@ -0,0 +1,226 @@
+//
+//  GraylogHttpInterfaceTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "graylog_logger/GraylogHttpInterface.hpp"
+#include "GraylogHttpConnection.hpp"
+#include "LogTestHttpServer.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <ciso646>
+#include <gtest/gtest.h>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+using namespace Log;
+using namespace std::chrono_literals;
+
+namespace {
+const int httpTestPort = 2528;
+
+template <typename Predicate>
+bool WaitFor(Predicate Pred, std::chrono::milliseconds TimeOut = 2000ms) {
+  auto EndTime = std::chrono::steady_clock::now() + TimeOut;
+  while (not Pred()) {
+    if (std::chrono::steady_clock::now() > EndTime) {
+      return false;
+    }
+    std::this_thread::sleep_for(5ms);
+  }
+  return true;
+}
+} // namespace
+
+TEST(HttpResponseHeader, StatusAndContentLength) {
+  auto Result = parseHttpResponseHeader(
+      "HTTP/1.1 202 Accepted\r\nContent-Length: 12\r\n\r\n");
+  EXPECT_EQ(Result.StatusCode, 202);
+  EXPECT_EQ(Result.ContentLength, 12u);
+  EXPECT_FALSE(Result.Chunked);
+  EXPECT_FALSE(Result.Close);
+}
+
+TEST(HttpResponseHeader, ChunkedAndClose) {
+  auto Result =
+      parseHttpResponseHeader("HTTP/1.1 503 Service Unavailable\r\n"
+                              "transfer-encoding: chunked\r\n"
+                              "Connection: Close\r\n\r\n");
+  EXPECT_EQ(Result.StatusCode, 503);
+  EXPECT_TRUE(Result.Chunked);
+  EXPECT_TRUE(Result.Close);
+}
+
+TEST(HttpResponseHeader, Http10ClosesConnection) {
+  auto Result = parseHttpResponseHeader("HTTP/1.0 200 OK\r\n\r\n");
+  EXPECT_EQ(Result.StatusCode, 200);
+  EXPECT_TRUE(Result.Close);
+}
+
+TEST(HttpResponseHeader, NotHttp) {
+  EXPECT_EQ(parseHttpResponseHeader("SSH-2.0-OpenSSH\r\n\r\n").StatusCode, 0);
+}
+
+class GraylogHttpCom : public ::testing::Test {
+public:
+  static void SetUpTestCase() {
+    Server = std::make_unique<LogTestHttpServer>(httpTestPort);
+  }
+  static void TearDownTestCase() { Server.reset(); }
+  void SetUp() override { Server->Clear(); }
+  static std::unique_ptr<LogTestHttpServer> Server;
+};
+
+std::unique_ptr<LogTestHttpServer> GraylogHttpCom::Server;
+
+TEST_F(GraylogHttpCom, UnknownHost) {
+  GraylogHttpConnection UnderTest("no_host", httpTestPort, 100);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_NE(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogHttpCom, SingleMessage) {
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100);
+  std::string TestString("This is a test string!");
+  UnderTest.sendMessage(TestString);
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  ASSERT_EQ(Server->GetNrOfMessages(), 1);
+  EXPECT_EQ(Server->GetMessages()[0], TestString);
+  EXPECT_EQ(Server->GetNrOfRequests(), 1);
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogHttpCom, ConnectsOnFirstMessage) {
+  HttpSettings Settings;
+  Settings.ConnectOnFirstUse = true;
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100, Settings);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(Server->GetNrOfConnections(), 0);
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::ADDR_LOOKUP);
+  UnderTest.sendMessage("The first message");
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  EXPECT_EQ(Server->GetNrOfMessages(), 1);
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogHttpCom, FlushWithFullQueue) {
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 1);
+  for (int i = 0; i < 1000; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(UnderTest.flush(2000ms));
+  EXPECT_EQ(UnderTest.messageQueueSize(), 0u);
+}
+
+TEST_F(GraylogHttpCom, FullQueueDropsMessages) {
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 1);
+  const int NrOfMessages{1000};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  EXPECT_GT(UnderTest.messagesDropped(), 0u);
+  EXPECT_EQ(Server->GetNrOfMessages() +
+                static_cast<int>(UnderTest.messagesDropped()),
+            NrOfMessages);
+}
+
+TEST_F(GraylogHttpCom, BatchesOnPersistentConnection) {
+  const int NrOfMessages{1000};
+  HttpSettings Settings;
+  Settings.MaxMessagesPerRequest = 50;
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, NrOfMessages * 2,
+                                  Settings);
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  for (int i = 0; i < NrOfMessages; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  ASSERT_TRUE(UnderTest.flush(5000ms));
+  auto Messages = Server->GetMessages();
+  ASSERT_EQ(Messages.size(), size_t(NrOfMessages));
+  for (int i = 0; i < NrOfMessages; ++i) {
+    EXPECT_EQ(Messages[i], "Message number " + std::to_string(i));
+  }
+  EXPECT_GE(Server->GetNrOfRequests(), NrOfMessages / 50);
+  EXPECT_LT(Server->GetNrOfRequests(), NrOfMessages / 2);
+  EXPECT_EQ(Server->GetNrOfConnections(), 1);
+}
+
+TEST_F(GraylogHttpCom, ChunkedResponses) {
+  Server->SetChunkedResponses(true);
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100);
+  for (int i = 0; i < 3; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+    ASSERT_TRUE(UnderTest.flush(2000ms));
+  }
+  EXPECT_EQ(Server->GetNrOfMessages(), 3);
+  EXPECT_EQ(Server->GetNrOfConnections(), 1);
+}
+
+TEST_F(GraylogHttpCom, RetryOnServerError) {
+  Server->QueueResponseCodes({503, 500});
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100);
+  UnderTest.sendMessage("Some message");
+  ASSERT_TRUE(UnderTest.flush(5000ms));
+  ASSERT_EQ(Server->GetNrOfMessages(), 1);
+  EXPECT_EQ(Server->GetMessages()[0], "Some message");
+  EXPECT_EQ(Server->GetNrOfRequests(), 3);
+  EXPECT_EQ(UnderTest.requestsRetried(), 2u);
+  EXPECT_EQ(UnderTest.messagesDropped(), 0u);
+}
+
+TEST_F(GraylogHttpCom, DropAfterMaxRetries) {
+  Server->SetDefaultResponseCode(500);
+  HttpSettings Settings;
+  Settings.MaxRetries = 1;
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100, Settings);
+  UnderTest.sendMessage("Some message");
+  UnderTest.sendMessage("Some other message");
+  ASSERT_TRUE(UnderTest.flush(5000ms));
+  EXPECT_EQ(Server->GetNrOfMessages(), 0);
+  EXPECT_EQ(UnderTest.messagesDropped(), 2u);
+  EXPECT_EQ(UnderTest.requestsRetried(), 1u);
+}
+
+TEST_F(GraylogHttpCom, ClientErrorIsNotRetried) {
+  Server->QueueResponseCodes({400});
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 100);
+  UnderTest.sendMessage("Some message");
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  EXPECT_EQ(UnderTest.messagesDropped(), 1u);
+  EXPECT_EQ(UnderTest.requestsRetried(), 0u);
+}
+
+#ifdef WITH_ZLIB
+TEST_F(GraylogHttpCom, CompressedBatches) {
+  HttpSettings Settings;
+  Settings.Compression = {Compression::Gzip, -1, 0};
+  GraylogHttpConnection UnderTest("localhost", httpTestPort, 1000, Settings);
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  for (int i = 0; i < 100; ++i) {
+    UnderTest.sendMessage(R"({"version":"1.1","short_message":"Message )" +
+                          std::to_string(i) + "\"}");
+  }
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  ASSERT_EQ(Server->GetNrOfMessages(), 100);
+  EXPECT_EQ(nlohmann::json::parse(Server->GetMessages()[99])["short_message"],
+            "Message 99");
+  EXPECT_EQ(Server->GetNrOfCompressedRequests(), Server->GetNrOfRequests());
+  EXPECT_GT(UnderTest.compressionStatistics().ratio(), 2.0);
+}
+#endif
+
+TEST_F(GraylogHttpCom, SharedMessageIsSentAsJson) {
+  GraylogHttpInterface UnderTest("localhost", httpTestPort);
+  auto Msg = std::make_shared<LogMessage>();
+  Msg->MessageString = "Some message";
+  Msg->Host = "some_host";
+  UnderTest.addSharedMessage(Msg);
+  ASSERT_TRUE(UnderTest.flush(2000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  auto JsonObject = nlohmann::json::parse(Server->GetMessages()[0]);
+  EXPECT_EQ(JsonObject["short_message"], Msg->MessageString);
+  EXPECT_EQ(JsonObject["host"], Msg->Host);
+}
@@ -6,17 +6,27 @@
 //  Copyright © 2016 European Spallation Source. All rights reserved.
 //
 
+#include "GraylogConnection.hpp"
 #include "graylog_logger/GraylogInterface.hpp"
+#include "LogTestProxy.hpp"
 #include "LogTestServer.hpp"
 #include "Semaphore.hpp"
 #include <ciso646>
 #include <cmath>
+#include <cstdio>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <thread>
 
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 using namespace Log;
 
 MATCHER(IsJSON, "") {
@@ -308,6 +318,20 @@ TEST(GraylogInterfaceCom, TestQueueSize) {
   EXPECT_EQ(con.queueSize(), 1);
 }
 
+TEST_F(GraylogConnectionCom, SharedMessageIsSerialisedByConnection) {
+  GraylogInterfaceStandIn con("localhost", testPort, 100);
+  EXPECT_CALL(con, sendMessage(::testing::_)).Times(0);
+  auto Msg = std::make_shared<LogMessage>(GetPopulatedLogMsg());
+  con.addSharedMessage(Msg);
+  EXPECT_TRUE(con.flush(std::chrono::milliseconds(500)));
+  std::this_thread::sleep_for(sleepTime);
+  auto ReceivedMessage = logServer->GetLatestMessage();
+  ASSERT_THAT(ReceivedMessage, IsJSON());
+  auto JsonObject = nlohmann::json::parse(ReceivedMessage);
+  EXPECT_EQ(JsonObject["short_message"], Msg->MessageString);
+  EXPECT_EQ(JsonObject["_thread_id"], Msg->ThreadId);
+}
+
 TEST(GraylogInterfaceCom, TestQueueSizeLimit) {
   int MaxNrOfMessages = 64;
   GraylogInterface con("localhost", testPort, MaxNrOfMessages);
@@ -363,3 +387,565 @@ TEST(GraylogInterface, FlushFail) {
   cInter.sendMessageBase("tst_msg");
   EXPECT_FALSE(cInter.flush(50ms));
 }
+
+#ifndef _WIN32
+namespace {
+void RemoveSpoolDirectory(const std::string &Directory) {
+  for (int i = 0; i < 16; ++i) {
+    char Name[64];
+    std::snprintf(Name, sizeof(Name), "/graylog-spool-%016x.seg", i);
+    std::remove((Directory + Name).c_str());
+  }
+  std::remove(Directory.c_str());
+}
+} // namespace
+
+TEST_F(GraylogConnectionCom, QueueOverflowIsSpooled) {
+  const std::string SpoolDirectory{"graylog_spool_overflow_test"};
+  RemoveSpoolDirectory(SpoolDirectory);
+  ConnectionSettings Settings;
+  Settings.Spool.Directory = SpoolDirectory;
+  {
+    GraylogConnection con("localhost", testPort, 4, Settings);
+    std::this_thread::sleep_for(sleepTime);
+    ASSERT_EQ(con.getConnectionStatus(), Status::SEND_LOOP);
+    auto MessagesBefore = logServer->GetNrOfMessages();
+    const int NrOfMessages{2000};
+    for (int i = 0; i < NrOfMessages; ++i) {
+      con.sendMessage("Message number " + std::to_string(i));
+    }
+    EXPECT_GT(con.spoolSize(), 0u);
+    auto EndTime = std::chrono::steady_clock::now() + 5s;
+    while (logServer->GetNrOfMessages() - MessagesBefore < NrOfMessages and
+           std::chrono::steady_clock::now() < EndTime) {
+      std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(logServer->GetNrOfMessages() - MessagesBefore, NrOfMessages);
+    EXPECT_EQ(con.spoolSize(), 0u);
+  }
+  RemoveSpoolDirectory(SpoolDirectory);
+}
+
+TEST_F(GraylogConnectionCom, SpooledMessagesAreSentAfterRestart) {
+  const std::string SpoolDirectory{"graylog_spool_restart_test"};
+  RemoveSpoolDirectory(SpoolDirectory);
+  ConnectionSettings Settings;
+  Settings.Spool.Directory = SpoolDirectory;
+  {
+    // No server on this port, messages are spooled.
+    GraylogConnection con("localhost", testPort + 1, 100, Settings);
+    con.sendMessage("A spooled message");
+    EXPECT_GT(con.spoolSize(), 0u);
+  }
+  auto MessagesBefore = logServer->GetNrOfMessages();
+  {
+    GraylogConnection con("localhost", testPort, 100, Settings);
+    auto EndTime = std::chrono::steady_clock::now() + 2s;
+    while (logServer->GetNrOfMessages() == MessagesBefore and
+           std::chrono::steady_clock::now() < EndTime) {
+      std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(logServer->GetNrOfMessages() - MessagesBefore, 1);
+    EXPECT_EQ(logServer->GetLatestMessage(), "A spooled message");
+    EXPECT_EQ(con.spoolSize(), 0u);
+  }
+  RemoveSpoolDirectory(SpoolDirectory);
+}
+#endif
+
+TEST(ReconnectDelay, GrowsExponentially) {
+  ReconnectSettings Settings;
+  Settings.Jitter = 0.0;
+  EXPECT_EQ(reconnectDelay(Settings, 0, 0.5), 100ms);
+  EXPECT_EQ(reconnectDelay(Settings, 1, 0.5), 200ms);
+  EXPECT_EQ(reconnectDelay(Settings, 3, 0.5), 800ms);
+}
+
+TEST(ReconnectDelay, IsLimitedByMaxDelay) {
+  ReconnectSettings Settings;
+  Settings.Jitter = 0.0;
+  EXPECT_EQ(reconnectDelay(Settings, 10, 0.5), Settings.MaxDelay);
+  EXPECT_EQ(reconnectDelay(Settings, 100000, 0.5), Settings.MaxDelay);
+}
+
+TEST(ReconnectDelay, JitterBounds) {
+  ReconnectSettings Settings;
+  Settings.Jitter = 0.2;
+  EXPECT_EQ(reconnectDelay(Settings, 0, 0.0), 80ms);
+  EXPECT_EQ(reconnectDelay(Settings, 0, 0.5), 100ms);
+  EXPECT_EQ(reconnectDelay(Settings, 0, 1.0), 120ms);
+}
+
+namespace {
+bool WaitForMessages(const std::vector<LogTestServer *> &Servers,
+                     int NrOfMessages) {
+  auto EndTime = std::chrono::steady_clock::now() + 5s;
+  while (std::chrono::steady_clock::now() < EndTime) {
+    int Received{0};
+    for (auto Server : Servers) {
+      Received += Server->GetNrOfMessages();
+    }
+    if (Received >= NrOfMessages) {
+      return true;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  return false;
+}
+} // namespace
+
+TEST(GraylogConnectionPool, MessagesAreDistributed) {
+  const int FirstPort{2529};
+  const int SecondPort{2530};
+  LogTestServer FirstServer(FirstPort);
+  LogTestServer SecondServer(SecondPort);
+  ConnectionSettings Settings;
+  Settings.AdditionalServers.push_back({"localhost", SecondPort});
+  GraylogConnection con("localhost", FirstPort, 10000, Settings);
+  auto EndTime = std::chrono::steady_clock::now() + 2s;
+  while ((FirstServer.GetNrOfConnections() == 0 or
+          SecondServer.GetNrOfConnections() == 0) and
+         std::chrono::steady_clock::now() < EndTime) {
+    std::this_thread::sleep_for(10ms);
+  }
+  const int NrOfMessages{2000};
+  const std::string Padding(200, 'x');
+  for (int i = 0; i < NrOfMessages; ++i) {
+    con.sendMessage(Padding + std::to_string(i));
+  }
+  EXPECT_TRUE(WaitForMessages({&FirstServer, &SecondServer}, NrOfMessages));
+  EXPECT_EQ(FirstServer.GetNrOfMessages() + SecondServer.GetNrOfMessages(),
+            NrOfMessages);
+  EXPECT_GT(FirstServer.GetNrOfMessages(), 0);
+  EXPECT_GT(SecondServer.GetNrOfMessages(), 0);
+}
+
+TEST(GraylogConnectionPool, FailoverToOtherServer) {
+  const int FirstPort{2529};
+  const int SecondPort{2530};
+  auto FirstServer = std::make_unique<LogTestServer>(FirstPort);
+  LogTestServer SecondServer(SecondPort);
+  ConnectionSettings Settings;
+  Settings.AdditionalServers.push_back({"localhost", SecondPort});
+  GraylogConnection con("localhost", FirstPort, 100, Settings);
+  std::this_thread::sleep_for(sleepTime);
+  FirstServer.reset();
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(con.getConnectionStatus(), Status::SEND_LOOP);
+  const int NrOfMessages{50};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    con.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(WaitForMessages({&SecondServer}, NrOfMessages));
+  EXPECT_EQ(SecondServer.GetNrOfMessages(), NrOfMessages);
+}
+
+TEST(GraylogConnectionRegistry, ConnectionIsShared) {
+  const int Port{2531};
+  LogTestServer Server(Port);
+  auto FirstConnection = std::make_unique<GraylogConnection>("localhost", Port,
+                                                             100);
+  GraylogConnection SecondConnection("localhost", Port, 100);
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Server.GetNrOfConnections(), 1);
+  FirstConnection->sendMessage("First message");
+  SecondConnection.sendMessage("Second message");
+  EXPECT_TRUE(WaitForMessages({&Server}, 2));
+  FirstConnection.reset();
+  SecondConnection.sendMessage("Third message");
+  EXPECT_TRUE(WaitForMessages({&Server}, 3));
+  EXPECT_EQ(Server.GetNrOfConnections(), 1);
+  EXPECT_EQ(SecondConnection.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST(GraylogConnectionRegistry, DifferentPortsAreNotShared) {
+  const int FirstPort{2531};
+  const int SecondPort{2532};
+  LogTestServer FirstServer(FirstPort);
+  LogTestServer SecondServer(SecondPort);
+  GraylogConnection FirstConnection("localhost", FirstPort, 100);
+  GraylogConnection SecondConnection("localhost", SecondPort, 100);
+  FirstConnection.sendMessage("First message");
+  SecondConnection.sendMessage("Second message");
+  EXPECT_TRUE(WaitForMessages({&FirstServer}, 1));
+  EXPECT_TRUE(WaitForMessages({&SecondServer}, 1));
+}
+
+TEST(GraylogConnectionRegistry, DifferentSettingsAreReported) {
+  const int Port{2531};
+  LogTestServer Server(Port);
+  GraylogConnection FirstConnection("localhost", Port, 100);
+  GraylogConnection SameConnection("localhost", Port, 100);
+  ConnectionSettings Settings;
+  Settings.ConnectOnFirstUse = true;
+  GraylogConnection OtherSettings("localhost", Port, 100, Settings);
+  GraylogConnection OtherQueueLength("localhost", Port, 200);
+  EXPECT_FALSE(FirstConnection.metrics().SharedWithDifferentSettings);
+  EXPECT_FALSE(SameConnection.metrics().SharedWithDifferentSettings);
+  EXPECT_TRUE(OtherSettings.metrics().SharedWithDifferentSettings);
+  EXPECT_TRUE(OtherQueueLength.metrics().SharedWithDifferentSettings);
+}
+
+TEST(GraylogConnectionRegistry, ConnectionIsClosedWithLastUser) {
+  const int Port{2531};
+  LogTestServer Server(Port);
+  {
+    GraylogConnection FirstConnection("localhost", Port, 100);
+    GraylogConnection SecondConnection("localhost", Port, 100);
+    std::this_thread::sleep_for(sleepTime);
+    EXPECT_EQ(Server.GetNrOfConnections(), 1);
+  }
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Server.GetNrOfConnections(), 0);
+}
+
+namespace {
+/// \brief Accepts connections (in the kernel) but never reads from them.
+class StalledServer {
+public:
+  explicit StalledServer(int Port, int ReceiveBufferSize = 0)
+      : Acceptor(Service) {
+    asio::ip::tcp::endpoint Endpoint(asio::ip::address_v4::loopback(), Port);
+    Acceptor.open(Endpoint.protocol());
+    if (ReceiveBufferSize > 0) {
+      // Inherited by the accepted connections.
+      Acceptor.set_option(
+          asio::socket_base::receive_buffer_size(ReceiveBufferSize));
+    }
+    Acceptor.bind(Endpoint);
+    Acceptor.listen();
+  }
+
+private:
+  asio::io_service Service;
+  asio::ip::tcp::acceptor Acceptor;
+};
+} // namespace
+
+TEST(GraylogConnectionFlush, FlushFailsUntilMessagesAreWritten) {
+  const int Port{2533};
+  StalledServer Server(Port);
+  GraylogConnection con("localhost", Port, 1000);
+  std::this_thread::sleep_for(sleepTime);
+  ASSERT_EQ(con.getConnectionStatus(), Status::SEND_LOOP);
+  // More data than fits in the socket buffers.
+  const std::string LargeMessage(100000, 'x');
+  for (int i = 0; i < 500; ++i) {
+    con.sendMessage(LargeMessage);
+  }
+  EXPECT_FALSE(con.flush(500ms));
+}
+
+TEST(GraylogConnectionFlush, FlushWithFullQueue) {
+  const int Port{2534};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 1);
+  std::this_thread::sleep_for(sleepTime);
+  for (int i = 0; i < 1000; ++i) {
+    con.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(con.flush(2s));
+  EXPECT_EQ(con.messageQueueSize(), 0u);
+}
+
+TEST(GraylogConnectionFlush, FlushSucceedsWhenMessagesAreWritten) {
+  const int Port{2534};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 100);
+  std::this_thread::sleep_for(sleepTime);
+  const int NrOfMessages{50};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    con.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(con.flush(2s));
+  EXPECT_TRUE(WaitForMessages({&Server}, NrOfMessages));
+}
+
+#ifdef __linux__
+TEST(GraylogConnectionFlush, FlushWaitsForAcknowledgement) {
+  const int Port{2534};
+  LogTestServer Server(Port);
+  ConnectionSettings Settings;
+  Settings.FlushWaitsForAcknowledgement = true;
+  GraylogConnection con("localhost", Port, 100, Settings);
+  std::this_thread::sleep_for(sleepTime);
+  con.sendMessage("A message");
+  EXPECT_TRUE(con.flush(2s));
+  // Acknowledged data has been received by the kernel of the server.
+  EXPECT_TRUE(WaitForMessages({&Server}, 1));
+}
+
+TEST(GraylogConnectionFlush, FlushFailsWithoutAcknowledgement) {
+  const int Port{2535};
+  // The message fits in the send buffer of the client but not in the
+  // receive buffer of the server, i.e. it is written but not acknowledged.
+  StalledServer Server(Port, 4096);
+  const std::string Message(50000, 'x');
+  {
+    GraylogConnection con("localhost", Port, 100);
+    std::this_thread::sleep_for(sleepTime);
+    con.sendMessage(Message);
+    EXPECT_TRUE(con.flush(500ms));
+  }
+  ConnectionSettings Settings;
+  Settings.FlushWaitsForAcknowledgement = true;
+  GraylogConnection con("localhost", Port, 100, Settings);
+  std::this_thread::sleep_for(sleepTime);
+  con.sendMessage(Message);
+  EXPECT_FALSE(con.flush(500ms));
+}
+#endif
+
+TEST(GraylogConnectionMetrics, MessagesAndBytesSent) {
+  const int Port{2536};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 100);
+  std::this_thread::sleep_for(sleepTime);
+  const int NrOfMessages{20};
+  std::uint64_t Bytes{0};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    auto Message = "Message number " + std::to_string(i);
+    Bytes += Message.size() + 1;
+    con.sendMessage(Message);
+  }
+  ASSERT_TRUE(con.flush(2s));
+  auto Metrics = con.metrics();
+  EXPECT_EQ(Metrics.MessagesSent, NrOfMessages);
+  EXPECT_EQ(Metrics.BytesSent, Bytes);
+  EXPECT_EQ(Metrics.MessagesDropped, 0u);
+  EXPECT_EQ(Metrics.Reconnects, 0u);
+  EXPECT_EQ(Metrics.Latency.count(), NrOfMessages);
+  EXPECT_GT(Metrics.WriteSizes.count(), 0u);
+  EXPECT_GT(Metrics.timeIn(Status::SEND_LOOP).count(), 0);
+  EXPECT_GT(Metrics.timeIn(Status::ADDR_LOOKUP).count(), 0);
+}
+
+TEST(GraylogConnectionMetrics, Reconnects) {
+  const int Port{2536};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 100);
+  std::this_thread::sleep_for(sleepTime);
+  Server.CloseAllConnections();
+  auto EndTime = std::chrono::steady_clock::now() + 2s;
+  while (con.metrics().Reconnects == 0 and
+         std::chrono::steady_clock::now() < EndTime) {
+    std::this_thread::sleep_for(10ms);
+  }
+  EXPECT_EQ(con.metrics().Reconnects, 1u);
+}
+
+TEST(GraylogConnectionMetrics, DroppedMessages) {
+  GraylogConnection con("localhost", 2537, 10);
+  for (int i = 0; i < 10000; ++i) {
+    con.sendMessage("A message");
+  }
+  EXPECT_GT(con.metrics().MessagesDropped, 0u);
+  EXPECT_EQ(con.metrics().MessagesSent, 0u);
+}
+
+namespace {
+class StateRecorder {
+public:
+  void add(Status OldState, Status NewState) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Transitions.emplace_back(OldState, NewState);
+  }
+  std::vector<std::pair<Status, Status>> get() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Transitions;
+  }
+  bool waitFor(Status State) {
+    auto EndTime = std::chrono::steady_clock::now() + 2s;
+    while (std::chrono::steady_clock::now() < EndTime) {
+      auto Current = get();
+      if (not Current.empty() and Current.back().second == State) {
+        return true;
+      }
+      std::this_thread::sleep_for(5ms);
+    }
+    return false;
+  }
+
+private:
+  std::mutex Mutex;
+  std::vector<std::pair<Status, Status>> Transitions;
+};
+} // namespace
+
+TEST(GraylogConnectionCallbacks, TransitionsAreReported) {
+  const int Port{2538};
+  StateRecorder Recorder;
+  GraylogConnection con("localhost", Port, 100);
+  con.addStateChangeCallback([&](Status OldState, Status NewState) {
+    Recorder.add(OldState, NewState);
+  });
+  // Started after adding the callback, so that the connection can not be
+  // established before it.
+  auto Server = std::make_unique<LogTestServer>(Port);
+  ASSERT_TRUE(Recorder.waitFor(Status::SEND_LOOP));
+  for (auto &Transition : Recorder.get()) {
+    EXPECT_NE(Transition.first, Transition.second);
+  }
+  Server.reset();
+  EXPECT_TRUE(Recorder.waitFor(Status::ADDR_RETRY_WAIT));
+  EXPECT_EQ(Recorder.get().back().first, Status::SEND_LOOP);
+}
+
+TEST(GraylogConnectionCallbacks, CallbackIsRunByExecutor) {
+  const int Port{2538};
+  StateRecorder Recorder;
+  std::atomic<int> ExecutedCallbacks{0};
+  GraylogConnection con("localhost", Port, 100);
+  con.addStateChangeCallback(
+      [&](Status OldState, Status NewState) {
+        Recorder.add(OldState, NewState);
+      },
+      [&](std::function<void()> Work) {
+        ++ExecutedCallbacks;
+        Work();
+      });
+  LogTestServer Server(Port);
+  ASSERT_TRUE(Recorder.waitFor(Status::SEND_LOOP));
+  EXPECT_EQ(ExecutedCallbacks, static_cast<int>(Recorder.get().size()));
+}
+
+TEST(GraylogConnectionCallbacks, RemovedCallbackIsNotCalled) {
+  std::atomic<int> Calls{0};
+  GraylogConnection con("localhost", 2539, 100);
+  auto Id = con.addStateChangeCallback([&](Status, Status) { ++Calls; });
+  con.removeStateChangeCallback(Id);
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Calls, 0);
+}
+
+TEST(GraylogConnectionCallbacks, CallbacksAreRemovedWithInstance) {
+  const int Port{2538};
+  auto Server = std::make_unique<LogTestServer>(Port);
+  std::atomic<int> Calls{0};
+  GraylogConnection con("localhost", Port, 100);
+  {
+    GraylogConnection SharedCon("localhost", Port, 100);
+    SharedCon.addStateChangeCallback([&](Status, Status) { ++Calls; });
+  }
+  Server.reset();
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Calls, 0);
+}
+
+TEST(GraylogConnectionSocket, SocketSettingsAreApplied) {
+  const int Port{2540};
+  LogTestServer Server(Port);
+  asio::io_service Service;
+  asio::ip::tcp::socket Socket(Service);
+  Socket.connect(
+      asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), Port));
+  SocketSettings Settings;
+  Settings.SendBufferSize = 16384;
+  applySocketSettings(Socket, Settings);
+  asio::ip::tcp::no_delay NoDelay;
+  Socket.get_option(NoDelay);
+  EXPECT_TRUE(NoDelay.value());
+  asio::socket_base::keep_alive KeepAlive;
+  Socket.get_option(KeepAlive);
+  EXPECT_TRUE(KeepAlive.value());
+  asio::socket_base::send_buffer_size SendBufferSize;
+  Socket.get_option(SendBufferSize);
+  EXPECT_GE(SendBufferSize.value(), Settings.SendBufferSize);
+#ifdef __linux__
+  int KeepIdle{0};
+  socklen_t Length{sizeof(KeepIdle)};
+  getsockopt(Socket.native_handle(), IPPROTO_TCP, TCP_KEEPIDLE, &KeepIdle,
+             &Length);
+  EXPECT_EQ(KeepIdle, Settings.KeepAliveIdle.count());
+#endif
+}
+
+TEST(GraylogConnectionSocket, StalledConnectionIsRecycled) {
+  const int ServerPort{2540};
+  const int ProxyPort{2541};
+  LogTestServer Server(ServerPort);
+  ConnectionSettings Settings;
+  Settings.Socket.StallTimeout = 300ms;
+  Settings.Socket.SendBufferSize = 4096;
+  StateRecorder Recorder;
+  GraylogConnection con("localhost", ProxyPort, 1000, Settings);
+  con.addStateChangeCallback([&](Status OldState, Status NewState) {
+    Recorder.add(OldState, NewState);
+  });
+  // Started after adding the callback, so that the connection can not be
+  // established before it.
+  auto Proxy = std::make_unique<LogTestProxy>(ProxyPort, ServerPort);
+  ASSERT_TRUE(Recorder.waitFor(Status::SEND_LOOP));
+  Proxy->setBlackhole(true);
+  const std::string Message(10000, 'x');
+  for (int i = 0; i < 200; ++i) {
+    con.sendMessage(Message);
+  }
+  EXPECT_TRUE(Recorder.waitFor(Status::ADDR_RETRY_WAIT));
+  Proxy->setBlackhole(false);
+  EXPECT_TRUE(Recorder.waitFor(Status::SEND_LOOP));
+  con.sendMessage("After the stall");
+  EXPECT_TRUE(con.flush(5s));
+  EXPECT_GE(con.metrics().Reconnects, 1u);
+}
+
+TEST(GraylogConnectionShutdown, QueuedMessagesAreDelivered) {
+  const int Port{2542};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 1000);
+  const int NrOfMessages{100};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    con.sendMessage("Message number " + std::to_string(i));
+  }
+  auto Report = con.shutdown(2s);
+  EXPECT_TRUE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 0u);
+  EXPECT_TRUE(WaitForMessages({&Server}, NrOfMessages));
+}
+
+TEST(GraylogConnectionShutdown, MessagesAfterShutdownAreDiscarded) {
+  const int Port{2542};
+  LogTestServer Server(Port);
+  GraylogConnection con("localhost", Port, 1000);
+  con.sendMessage("Before shutdown");
+  EXPECT_TRUE(con.shutdown(2s).Completed);
+  con.sendMessage("After shutdown");
+  EXPECT_TRUE(con.flush(2s));
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Server.GetNrOfMessages(), 1);
+}
+
+TEST(GraylogConnectionShutdown, UndeliveredMessagesAreReported) {
+  // No server is listening on this port.
+  const int Port{2543};
+  GraylogConnection con("localhost", Port, 1000);
+  const int NrOfMessages{10};
+  for (int i = 0; i < NrOfMessages; ++i) {
+    con.sendMessage("Message number " + std::to_string(i));
+  }
+  auto Start = std::chrono::steady_clock::now();
+  auto Report = con.shutdown(200ms);
+  EXPECT_LT(std::chrono::steady_clock::now() - Start, 1s);
+  EXPECT_FALSE(Report.Completed);
+  EXPECT_GE(Report.UndeliveredMessages, size_t(NrOfMessages));
+}
+
+TEST(GraylogConnectionLazy, ConnectsOnFirstMessage) {
+  const int Port{2544};
+  LogTestServer Server(Port);
+  ConnectionSettings Settings;
+  Settings.ConnectOnFirstUse = true;
+  GraylogConnection con("localhost", Port, 100, Settings);
+  std::this_thread::sleep_for(sleepTime);
+  EXPECT_EQ(Server.GetNrOfConnections(), 0);
+  EXPECT_EQ(con.getConnectionStatus(), Status::ADDR_LOOKUP);
+  con.sendMessage("The first message");
+  EXPECT_TRUE(WaitForMessages({&Server}, 1));
+  EXPECT_EQ(con.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST(GraylogConnectionLazy, UnusedConnectionIsDestroyed) {
+  ConnectionSettings Settings;
+  Settings.ConnectOnFirstUse = true;
+  GraylogConnection con("localhost", 2544, 100, Settings);
+}
@@ -0,0 +1,221 @@
+//
+//  GraylogUdpInterfaceTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "graylog_logger/GraylogUdpInterface.hpp"
+#include "GraylogUdpConnection.hpp"
+#include "LogTestUdpServer.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <ciso646>
+#include <gtest/gtest.h>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+using namespace Log;
+using namespace std::chrono_literals;
+
+namespace {
+const int udpTestPort = 2527;
+
+template <typename Predicate>
+bool WaitFor(Predicate Pred, std::chrono::milliseconds TimeOut = 2000ms) {
+  auto EndTime = std::chrono::steady_clock::now() + TimeOut;
+  while (not Pred()) {
+    if (std::chrono::steady_clock::now() > EndTime) {
+      return false;
+    }
+    std::this_thread::sleep_for(5ms);
+  }
+  return true;
+}
+} // namespace
+
+TEST(GelfChunking, SmallMessageIsNotChunked) {
+  std::vector<GelfChunkHeader> Headers;
+  EXPECT_TRUE(createGelfChunkHeaders(1420, 1420, 1, Headers));
+  EXPECT_TRUE(Headers.empty());
+}
+
+TEST(GelfChunking, ChunkHeaderContents) {
+  std::vector<GelfChunkHeader> Headers;
+  std::uint64_t MessageId{0x0102030405060708};
+  EXPECT_TRUE(createGelfChunkHeaders(3000, 1420, MessageId, Headers));
+  ASSERT_EQ(Headers.size(), 3u);
+  for (size_t i = 0; i < Headers.size(); ++i) {
+    EXPECT_EQ(Headers[i][0], 0x1e);
+    EXPECT_EQ(Headers[i][1], 0x0f);
+    for (size_t j = 0; j < 8; ++j) {
+      EXPECT_EQ(Headers[i][2 + j], j + 1);
+    }
+    EXPECT_EQ(Headers[i][10], i);
+    EXPECT_EQ(Headers[i][11], 3);
+  }
+}
+
+TEST(GelfChunking, ChunkLimit) {
+  std::vector<GelfChunkHeader> Headers;
+  const size_t DatagramSize{112};
+  const size_t MaxMessageSize{GelfMaxChunks * (DatagramSize - 12)};
+  EXPECT_TRUE(
+      createGelfChunkHeaders(MaxMessageSize, DatagramSize, 1, Headers));
+  EXPECT_EQ(Headers.size(), GelfMaxChunks);
+  Headers.clear();
+  EXPECT_FALSE(
+      createGelfChunkHeaders(MaxMessageSize + 1, DatagramSize, 1, Headers));
+  EXPECT_TRUE(Headers.empty());
+}
+
+class GraylogUdpCom : public ::testing::Test {
+public:
+  static void SetUpTestCase() {
+    Server = std::make_unique<LogTestUdpServer>(udpTestPort);
+  }
+  static void TearDownTestCase() { Server.reset(); }
+  void SetUp() override { Server->Clear(); }
+  static std::unique_ptr<LogTestUdpServer> Server;
+};
+
+std::unique_ptr<LogTestUdpServer> GraylogUdpCom::Server;
+
+TEST_F(GraylogUdpCom, UnknownHost) {
+  GraylogUdpConnection UnderTest("no_host", udpTestPort, 100);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_NE(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogUdpCom, SingleMessage) {
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 100);
+  std::string TestString("This is a test string!");
+  UnderTest.sendMessage(TestString);
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  EXPECT_EQ(Server->GetMessages()[0], TestString);
+  EXPECT_EQ(Server->GetNrOfChunks(), 0);
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogUdpCom, StartsOnFirstMessage) {
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 100, 1420, {},
+                                 true);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::ADDR_LOOKUP);
+  UnderTest.sendMessage("The first message");
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  EXPECT_EQ(UnderTest.getConnectionStatus(), Status::SEND_LOOP);
+}
+
+TEST_F(GraylogUdpCom, ChunkedMessage) {
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 100, 1420);
+  std::string TestString;
+  for (int i = 0; TestString.size() < 20000; ++i) {
+    TestString += std::to_string(i) + ",";
+  }
+  UnderTest.sendMessage(TestString);
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  EXPECT_EQ(Server->GetMessages()[0], TestString);
+  EXPECT_EQ(size_t(Server->GetNrOfChunks()), (TestString.size() + 1407) / 1408);
+  EXPECT_EQ(UnderTest.messagesDropped(), 0u);
+}
+
+TEST_F(GraylogUdpCom, TooLargeMessageIsDropped) {
+  const size_t DatagramSize{112};
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 100, DatagramSize);
+  UnderTest.sendMessage(std::string(GelfMaxChunks * 100 + 1, 'a'));
+  UnderTest.sendMessage("A small message");
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  EXPECT_EQ(Server->GetMessages()[0], "A small message");
+  EXPECT_EQ(UnderTest.messagesDropped(), 1u);
+}
+
+TEST_F(GraylogUdpCom, ManyMessages) {
+  const int NrOfMessages{2000};
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, NrOfMessages * 2);
+  auto StartTime = std::chrono::steady_clock::now();
+  for (int i = 0; i < NrOfMessages; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(UnderTest.flush(5000ms));
+  EXPECT_TRUE(
+      WaitFor([]() { return Server->GetNrOfMessages() == NrOfMessages; }))
+      << "Lost " << NrOfMessages - Server->GetNrOfMessages() << " messages.";
+  auto Elapsed = std::chrono::steady_clock::now() - StartTime;
+  RecordProperty(
+      "MessagesPerSecond",
+      std::to_string(NrOfMessages * 1000 /
+                     std::max<long long>(1, std::chrono::duration_cast<
+                                                std::chrono::milliseconds>(
+                                                Elapsed)
+                                                .count())));
+}
+
+TEST_F(GraylogUdpCom, FlushWithFullQueue) {
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 1);
+  for (int i = 0; i < 1000; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_TRUE(UnderTest.flush(2000ms));
+  EXPECT_EQ(UnderTest.messageQueueSize(), 0u);
+  // Let the server receive the remaining datagrams, so that they are not
+  // counted by the next test.
+  int Received{-1};
+  while (Received != Server->GetNrOfMessages()) {
+    Received = Server->GetNrOfMessages();
+    std::this_thread::sleep_for(50ms);
+  }
+}
+
+TEST_F(GraylogUdpCom, FullQueueDropsMessages) {
+  // Messages are not dequeued as the host can not be resolved.
+  GraylogUdpConnection UnderTest("no_host", udpTestPort, 10);
+  const size_t NrOfMessages{1000};
+  for (size_t i = 0; i < NrOfMessages; ++i) {
+    UnderTest.sendMessage("Message number " + std::to_string(i));
+  }
+  EXPECT_GT(UnderTest.messagesDropped(), 0u);
+  EXPECT_EQ(UnderTest.messagesDropped() + UnderTest.messageQueueSize(),
+            NrOfMessages);
+}
+
+TEST_F(GraylogUdpCom, SharedMessageIsSentAsJson) {
+  GraylogUdpInterface UnderTest("localhost", udpTestPort);
+  auto Msg = std::make_shared<LogMessage>();
+  Msg->MessageString = "Some message";
+  Msg->Host = "some_host";
+  UnderTest.addSharedMessage(Msg);
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 1; }));
+  auto JsonObject = nlohmann::json::parse(Server->GetMessages()[0]);
+  EXPECT_EQ(JsonObject["short_message"], Msg->MessageString);
+  EXPECT_EQ(JsonObject["host"], Msg->Host);
+}
+
+#ifdef WITH_ZLIB
+TEST_F(GraylogUdpCom, CompressedChunkedMessage) {
+  CompressionSettings Compression{Compression::Gzip, -1, 1000};
+  GraylogUdpConnection UnderTest("localhost", udpTestPort, 100, 1420,
+                                 Compression);
+  std::string TestString;
+  for (int i = 0; TestString.size() < 20000; ++i) {
+    TestString += "Some repeated text " + std::to_string(i) + ",";
+  }
+  UnderTest.sendMessage(TestString);
+  UnderTest.sendMessage("A short message");
+  EXPECT_TRUE(UnderTest.flush(1000ms));
+  ASSERT_TRUE(WaitFor([]() { return Server->GetNrOfMessages() == 2; }));
+  EXPECT_EQ(Server->GetMessages()[0], TestString);
+  EXPECT_EQ(Server->GetMessages()[1], "A short message");
+  EXPECT_EQ(Server->GetNrOfCompressedMessages(), 1);
+  EXPECT_LT(size_t(Server->GetNrOfChunks()), TestString.size() / 1408);
+  auto Statistics = UnderTest.compressionStatistics();
+  EXPECT_EQ(Statistics.MessagesCompressed, 1u);
+  EXPECT_EQ(Statistics.MessagesUncompressed, 1u);
+  EXPECT_GT(Statistics.ratio(), 2.0);
+}
+#endif
@@ -0,0 +1,367 @@
+//
+//  LogFileTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "Decompress.hpp"
+#include "FileSyncer.hpp"
+#include "LogFile.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <atomic>
+#include <cerrno>
+#include <ciso646>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace Log;
+using namespace std::chrono_literals;
+
+namespace {
+const std::string LogFileTestName("logFileTest.log");
+
+std::string readFile(const std::string &Path) {
+  std::ifstream InStream(Path, std::ios::binary);
+  std::stringstream Content;
+  Content << InStream.rdbuf();
+  return Content.str();
+}
+
+size_t sizeOnDisk(const std::string &Path) {
+  struct stat FileInfo {};
+  stat(Path.c_str(), &FileInfo);
+  return static_cast<size_t>(FileInfo.st_size);
+}
+
+std::string numberedLines(int First, int Last) {
+  std::string Lines;
+  for (int i = First; i < Last; ++i) {
+    Lines += "Line number " + std::to_string(i) + "\n";
+  }
+  return Lines;
+}
+} // namespace
+
+class LogFileTest : public ::testing::Test {
+public:
+  void SetUp() override { std::remove(LogFileTestName.c_str()); }
+  void TearDown() override { std::remove(LogFileTestName.c_str()); }
+};
+
+TEST_F(LogFileTest, AppendFileAppends) {
+  {
+    std::ofstream(LogFileTestName) << "Existing\n";
+  }
+  AppendFile UnderTest;
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  EXPECT_EQ(UnderTest.size(), 9u);
+  std::string Data{"New\n"};
+  EXPECT_EQ(UnderTest.write(Data.data(), Data.size()), Data.size());
+  EXPECT_EQ(UnderTest.size(), 13u);
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), "Existing\nNew\n");
+}
+
+TEST_F(LogFileTest, AppendFileReportsErrors) {
+  AppendFile UnderTest;
+  std::string Data{"Some data\n"};
+  EXPECT_FALSE(UnderTest.open("/non_existing_directory/file.log"));
+  EXPECT_EQ(UnderTest.error(), ENOENT);
+  EXPECT_EQ(UnderTest.write(Data.data(), Data.size()), 0u);
+#ifdef __linux__
+  // Writes to /dev/full fail as if the disk was full.
+  ASSERT_TRUE(UnderTest.open("/dev/full"));
+  EXPECT_EQ(UnderTest.error(), 0);
+  EXPECT_EQ(UnderTest.write(Data.data(), Data.size()), 0u);
+  EXPECT_EQ(UnderTest.error(), ENOSPC);
+#endif
+}
+
+TEST_F(LogFileTest, AppendFileRemovesPartialWrite) {
+  AppendFile UnderTest;
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  auto Data = numberedLines(0, 10);
+  ASSERT_EQ(UnderTest.write(Data.data(), Data.size()), Data.size());
+  // Only part of the next write fits below the file size limit.
+  rlimit Limit{};
+  getrlimit(RLIMIT_FSIZE, &Limit);
+  auto PreviousLimit = Limit;
+  auto PreviousHandler = std::signal(SIGXFSZ, SIG_IGN);
+  Limit.rlim_cur = Data.size() + 10;
+  setrlimit(RLIMIT_FSIZE, &Limit);
+  auto Written = UnderTest.write(Data.data(), Data.size());
+  setrlimit(RLIMIT_FSIZE, &PreviousLimit);
+  std::signal(SIGXFSZ, PreviousHandler);
+  EXPECT_EQ(Written, 0u);
+  EXPECT_EQ(UnderTest.error(), EFBIG);
+  EXPECT_EQ(UnderTest.size(), Data.size());
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), Data);
+}
+
+TEST_F(LogFileTest, MappedFileWritesAcrossChunks) {
+  MappedFile UnderTest(4096);
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  auto Data = numberedLines(0, 10000);
+  // Uneven writes, so that they straddle the ends of the windows.
+  for (size_t Offset = 0; Offset < Data.size(); Offset += 1000) {
+    auto Length = std::min<size_t>(1000, Data.size() - Offset);
+    ASSERT_EQ(UnderTest.write(Data.data() + Offset, Length), Length);
+  }
+  EXPECT_EQ(UnderTest.size(), Data.size());
+  // Space is allocated ahead of the data.
+  EXPECT_GE(sizeOnDisk(LogFileTestName), Data.size());
+  UnderTest.close();
+  EXPECT_EQ(sizeOnDisk(LogFileTestName), Data.size());
+  EXPECT_EQ(readFile(LogFileTestName), Data);
+}
+
+TEST_F(LogFileTest, MappedFileAppendsToExistingFile) {
+  auto Data = numberedLines(0, 100);
+  {
+    MappedFile UnderTest(4096);
+    ASSERT_TRUE(UnderTest.open(LogFileTestName));
+    UnderTest.write(Data.data(), Data.size());
+  }
+  auto MoreData = numberedLines(100, 200);
+  MappedFile UnderTest(4096);
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  EXPECT_EQ(UnderTest.size(), Data.size());
+  UnderTest.write(MoreData.data(), MoreData.size());
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), Data + MoreData);
+}
+
+TEST_F(LogFileTest, MappedFileSkipsUnusedSpaceOfUnclosedFile) {
+  // As left by a process that exited without closing the file.
+  auto Data = numberedLines(0, 100);
+  {
+    std::ofstream OutStream(LogFileTestName, std::ios::binary);
+    OutStream << Data << std::string(5000, '\0');
+  }
+  MappedFile UnderTest(8192);
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  EXPECT_EQ(UnderTest.size(), Data.size());
+  std::string MoreData{"Next line\n"};
+  UnderTest.write(MoreData.data(), MoreData.size());
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), Data + MoreData);
+}
+
+TEST_F(LogFileTest, MappedFileFailsToOpenInvalidPath) {
+  MappedFile UnderTest(4096);
+  EXPECT_FALSE(UnderTest.open("/non_existing_directory/file.log"));
+  std::string Data{"Some data\n"};
+  EXPECT_EQ(UnderTest.write(Data.data(), Data.size()), 0u);
+}
+
+#ifdef HAVE_IO_URING
+TEST_F(LogFileTest, UringFileWritesInOrder) {
+  UringFile UnderTest(4);
+  if (not UnderTest.available()) {
+    // io_uring is disabled or not supported by the kernel.
+    return;
+  }
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  std::string Data;
+  for (int i = 0; i < 1000; ++i) {
+    auto Batch = numberedLines(i * 10, (i + 1) * 10);
+    EXPECT_EQ(UnderTest.write(Batch.data(), Batch.size()), Batch.size());
+    Data += Batch;
+  }
+  EXPECT_EQ(UnderTest.size(), Data.size());
+  UnderTest.wait();
+  EXPECT_EQ(readFile(LogFileTestName), Data);
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), Data);
+}
+
+TEST_F(LogFileTest, UringFileAppendsToExistingFile) {
+  {
+    std::ofstream(LogFileTestName) << "Existing\n";
+  }
+  UringFile UnderTest(2);
+  if (not UnderTest.available()) {
+    return;
+  }
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  EXPECT_EQ(UnderTest.size(), 9u);
+  std::string Data{"New\n"};
+  UnderTest.write(Data.data(), Data.size());
+  UnderTest.close();
+  EXPECT_EQ(readFile(LogFileTestName), "Existing\nNew\n");
+}
+#endif
+
+#ifdef WITH_ZLIB
+TEST_F(LogFileTest, GzipFileWritesFrames) {
+  auto Lines = numberedLines(0, 20000);
+  {
+    GzipFile UnderTest(std::make_unique<AppendFile>(), -1, 16 * 1024);
+    ASSERT_TRUE(UnderTest.open(LogFileTestName));
+    for (size_t Offset = 0; Offset < Lines.size(); Offset += 1000) {
+      auto Length = std::min<size_t>(1000, Lines.size() - Offset);
+      ASSERT_EQ(UnderTest.write(Lines.data() + Offset, Length), Length);
+    }
+    auto Statistics = UnderTest.statistics();
+    EXPECT_EQ(Statistics.BytesIn, Lines.size());
+    EXPECT_GT(Statistics.ratio(), 2.0);
+  }
+  auto Compressed = readFile(LogFileTestName);
+  EXPECT_LT(Compressed.size(), Lines.size() / 2);
+  // Starts with a complete gzip member.
+  EXPECT_FALSE(Decompress(Compressed).empty());
+  EXPECT_EQ(DecompressMembers(Compressed), Lines);
+}
+
+TEST_F(LogFileTest, GzipFileCanBeReadAfterEachWrite) {
+  GzipFile UnderTest(std::make_unique<AppendFile>(), -1, 1024 * 1024);
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  auto FirstLines = numberedLines(0, 100);
+  UnderTest.write(FirstLines.data(), FirstLines.size());
+  auto FirstSize = UnderTest.size();
+  EXPECT_EQ(sizeOnDisk(LogFileTestName), FirstSize);
+  EXPECT_EQ(DecompressMembers(readFile(LogFileTestName)), FirstLines);
+  auto SecondLines = numberedLines(100, 200);
+  UnderTest.write(SecondLines.data(), SecondLines.size());
+  auto Compressed = readFile(LogFileTestName);
+  EXPECT_EQ(DecompressMembers(Compressed), FirstLines + SecondLines);
+  // A file cut short in the middle of a write.
+  auto Truncated = Compressed.substr(0, (FirstSize + Compressed.size()) / 2);
+  auto Decompressed = DecompressMembers(Truncated);
+  EXPECT_EQ(Decompressed.substr(0, FirstLines.size()), FirstLines);
+}
+
+TEST_F(LogFileTest, GzipFileAppendsFrameToExistingFile) {
+  auto FirstLines = numberedLines(0, 100);
+  auto SecondLines = numberedLines(100, 200);
+  for (auto &Lines : {FirstLines, SecondLines}) {
+    GzipFile UnderTest(std::make_unique<AppendFile>(), 1, 1024 * 1024);
+    ASSERT_TRUE(UnderTest.open(LogFileTestName));
+    UnderTest.write(Lines.data(), Lines.size());
+  }
+  EXPECT_EQ(DecompressMembers(readFile(LogFileTestName)),
+            FirstLines + SecondLines);
+}
+
+namespace {
+/// \brief Keeps the data in memory and fails the writes once Full is set.
+class FullFile : public LogFile {
+public:
+  bool open(const std::string &) override {
+    Error = 0;
+    return true;
+  }
+  size_t write(const char *Data, size_t Size) override {
+    if (Full) {
+      Error = ENOSPC;
+      return 0;
+    }
+    Contents.append(Data, Size);
+    return Size;
+  }
+  void close() override {}
+  bool isOpen() const override { return true; }
+  size_t size() const override { return Contents.size(); }
+  std::string Contents;
+  bool Full{false};
+};
+} // namespace
+
+TEST_F(LogFileTest, GzipFileRecoversFromFailedWrite) {
+  auto Inner = std::make_unique<FullFile>();
+  auto &File = *Inner;
+  GzipFile UnderTest(std::move(Inner), -1, 1024 * 1024);
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  auto FirstLines = numberedLines(0, 100);
+  ASSERT_EQ(UnderTest.write(FirstLines.data(), FirstLines.size()),
+            FirstLines.size());
+  File.Full = true;
+  auto SecondLines = numberedLines(100, 200);
+  EXPECT_EQ(UnderTest.write(SecondLines.data(), SecondLines.size()), 0u);
+  EXPECT_EQ(UnderTest.error(), ENOSPC);
+  File.Full = false;
+  // Nothing is written until the file is reopened.
+  auto Written = File.Contents;
+  EXPECT_EQ(UnderTest.write(SecondLines.data(), SecondLines.size()), 0u);
+  EXPECT_EQ(File.Contents, Written);
+  // The member is finished after the data that was written.
+  UnderTest.close();
+  EXPECT_EQ(DecompressMembers(File.Contents), FirstLines);
+  // Reopening starts a new gzip member.
+  ASSERT_TRUE(UnderTest.open(LogFileTestName));
+  EXPECT_EQ(UnderTest.error(), 0);
+  ASSERT_EQ(UnderTest.write(SecondLines.data(), SecondLines.size()),
+            SecondLines.size());
+  UnderTest.close();
+  EXPECT_EQ(DecompressMembers(File.Contents), FirstLines + SecondLines);
+}
+#endif
+
+namespace {
+class SyncCounter : public LogFile {
+public:
+  bool open(const std::string &) override { return true; }
+  size_t write(const char *, size_t Size) override { return Size; }
+  void close() override {}
+  bool isOpen() const override { return true; }
+  size_t size() const override { return 0; }
+  void sync() override { ++Syncs; }
+  std::atomic<int> Syncs{0};
+};
+
+bool waitForSyncs(SyncCounter &File, int Syncs) {
+  auto Deadline = std::chrono::steady_clock::now() + 5s;
+  while (File.Syncs < Syncs and std::chrono::steady_clock::now() < Deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  return File.Syncs >= Syncs;
+}
+} // namespace
+
+TEST(FileSyncer, SyncsWhenRequested) {
+  SyncCounter File;
+  FileSyncer UnderTest(File, 0ms);
+  UnderTest.dataWritten();
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(File.Syncs, 0);
+  UnderTest.requestSync();
+  EXPECT_TRUE(waitForSyncs(File, 1));
+  EXPECT_EQ(UnderTest.syncs(), 1u);
+}
+
+TEST(FileSyncer, SyncsAfterIntervalOnlyIfDataWasWritten) {
+  SyncCounter File;
+  FileSyncer UnderTest(File, 20ms);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(File.Syncs, 0);
+  auto WriteTime = std::chrono::steady_clock::now();
+  UnderTest.dataWritten();
+  EXPECT_TRUE(waitForSyncs(File, 1));
+  EXPECT_GE(std::chrono::steady_clock::now() - WriteTime, 20ms);
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(File.Syncs, 1);
+}
+
+TEST(FileSyncer, RequestsAreCombined) {
+  SyncCounter File;
+  FileSyncer UnderTest(File, 0ms);
+  std::unique_lock<std::mutex> Lock(UnderTest.fileMutex());
+  UnderTest.requestSync();
+  // The first sync is waiting for the file; the rest are combined.
+  std::this_thread::sleep_for(20ms);
+  for (int i = 0; i < 10; ++i) {
+    UnderTest.requestSync();
+  }
+  Lock.unlock();
+  EXPECT_TRUE(waitForSyncs(File, 2));
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(File.Syncs, 2);
+}
@@ -0,0 +1,185 @@
+//
+//  LogTestHttpServer.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "LogTestHttpServer.hpp"
+#include "Decompress.hpp"
+#include <algorithm>
+#include <cctype>
+#include <ciso646>
+#include <sstream>
+
+namespace {
+std::string ToLower(std::string Text) {
+  std::transform(Text.begin(), Text.end(), Text.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return Text;
+}
+
+size_t GetContentLength(const std::string &Header) {
+  auto Lower = ToLower(Header);
+  auto Start = Lower.find("content-length:");
+  if (Start == std::string::npos) {
+    return 0;
+  }
+  return std::stoul(Lower.substr(Start + 15));
+}
+} // namespace
+
+LogTestHttpServer::LogTestHttpServer(short port)
+    : service(),
+      acceptor(service, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {
+  WaitForNewConnection();
+  asioThread = std::thread([this]() { service.run(); });
+}
+
+LogTestHttpServer::~LogTestHttpServer() {
+  service.post([this]() {
+    acceptor.close();
+    for (auto &WeakSession : sessions) {
+      if (auto CSession = WeakSession.lock()) {
+        asio::error_code Ignored;
+        CSession->Socket.close(Ignored);
+      }
+    }
+  });
+  asioThread.join();
+}
+
+void LogTestHttpServer::WaitForNewConnection() {
+  auto NewSession = std::make_shared<Session>(service);
+  acceptor.async_accept(NewSession->Socket,
+                        [this, NewSession](const std::error_code &ec) {
+                          if (ec) {
+                            return;
+                          }
+                          ++connections;
+                          sessions.push_back(NewSession);
+                          ReadRequest(NewSession);
+                          WaitForNewConnection();
+                        });
+}
+
+void LogTestHttpServer::ReadRequest(SessionPtr CSession) {
+  asio::async_read_until(
+      CSession->Socket, CSession->Buffer, "\r\n\r\n",
+      [this, CSession](const std::error_code &ec, std::size_t Size) {
+        if (ec) {
+          return;
+        }
+        auto Begin = asio::buffers_begin(CSession->Buffer.data());
+        std::string Header(Begin, Begin + Size);
+        CSession->Buffer.consume(Size);
+        auto ContentLength = GetContentLength(Header);
+        if (CSession->Buffer.size() >= ContentLength) {
+          HandleRequest(CSession, Header, ContentLength);
+          return;
+        }
+        asio::async_read(
+            CSession->Socket, CSession->Buffer,
+            asio::transfer_exactly(ContentLength - CSession->Buffer.size()),
+            [this, CSession, Header,
+             ContentLength](const std::error_code &ec, std::size_t) {
+              if (not ec) {
+                HandleRequest(CSession, Header, ContentLength);
+              }
+            });
+      });
+}
+
+void LogTestHttpServer::HandleRequest(SessionPtr CSession,
+                                      const std::string &Header,
+                                      size_t ContentLength) {
+  ++requests;
+  auto Begin = asio::buffers_begin(CSession->Buffer.data());
+  std::string Body(Begin, Begin + ContentLength);
+  CSession->Buffer.consume(ContentLength);
+  if (ToLower(Header).find("content-encoding:") != std::string::npos) {
+    ++compressedRequests;
+    Body = Decompress(Body);
+  }
+  int ResponseCode{0};
+  bool Chunked{false};
+  {
+    std::lock_guard<std::mutex> Lock(messageMutex);
+    if (responseCodes.empty()) {
+      ResponseCode = defaultResponseCode;
+    } else {
+      ResponseCode = responseCodes.front();
+      responseCodes.pop_front();
+    }
+    Chunked = chunkedResponses;
+    if (ResponseCode >= 200 and ResponseCode < 300) {
+      std::istringstream Lines(Body);
+      std::string Line;
+      while (std::getline(Lines, Line)) {
+        messages.push_back(Line);
+      }
+    }
+  }
+  CSession->Response =
+      "HTTP/1.1 " + std::to_string(ResponseCode) + " Status\r\n";
+  if (Chunked) {
+    CSession->Response += "Transfer-Encoding: chunked\r\n\r\n"
+                          "4\r\nSome\r\n5\r\n body\r\n0\r\n\r\n";
+  } else {
+    CSession->Response += "Content-Length: 9\r\n\r\nSome body";
+  }
+  SendResponse(CSession);
+}
+
+void LogTestHttpServer::SendResponse(SessionPtr CSession) {
+  asio::async_write(CSession->Socket, asio::buffer(CSession->Response),
+                    [this, CSession](const std::error_code &ec, std::size_t) {
+                      if (not ec) {
+                        ReadRequest(CSession);
+                      }
+                    });
+}
+
+std::vector<std::string> LogTestHttpServer::GetMessages() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  return messages;
+}
+
+int LogTestHttpServer::GetNrOfMessages() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  return static_cast<int>(messages.size());
+}
+
+int LogTestHttpServer::GetNrOfRequests() { return requests; }
+
+int LogTestHttpServer::GetNrOfConnections() { return connections; }
+
+int LogTestHttpServer::GetNrOfCompressedRequests() {
+  return compressedRequests;
+}
+
+void LogTestHttpServer::QueueResponseCodes(std::vector<int> Codes) {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  responseCodes.insert(responseCodes.end(), Codes.begin(), Codes.end());
+}
+
+void LogTestHttpServer::SetDefaultResponseCode(int Code) {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  defaultResponseCode = Code;
+}
+
+void LogTestHttpServer::SetChunkedResponses(bool Chunked) {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  chunkedResponses = Chunked;
+}
+
+void LogTestHttpServer::Clear() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  messages.clear();
+  responseCodes.clear();
+  defaultResponseCode = 202;
+  chunkedResponses = false;
+  requests = 0;
+  connections = 0;
+  compressedRequests = 0;
+}
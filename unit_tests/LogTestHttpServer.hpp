@@ -0,0 +1,66 @@
+//
+//  LogTestHttpServer.hpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \brief Stand-in for a GELF HTTP input. Decompresses request bodies and
+/// splits them into newline separated messages.
+class LogTestHttpServer {
+public:
+  explicit LogTestHttpServer(short port);
+  ~LogTestHttpServer();
+  std::vector<std::string> GetMessages();
+  int GetNrOfMessages();
+  int GetNrOfRequests();
+  int GetNrOfConnections();
+  int GetNrOfCompressedRequests();
+  /// \brief Status codes returned for the next requests, before returning to
+  /// the default (202).
+  void QueueResponseCodes(std::vector<int> Codes);
+  void SetDefaultResponseCode(int Code);
+  /// \brief Send responses using chunked transfer encoding.
+  void SetChunkedResponses(bool Chunked);
+  void Clear();
+
+private:
+  struct Session {
+    explicit Session(asio::io_service &Service) : Socket(Service) {}
+    asio::ip::tcp::socket Socket;
+    asio::streambuf Buffer;
+    std::string Response;
+  };
+  using SessionPtr = std::shared_ptr<Session>;
+
+  void WaitForNewConnection();
+  void ReadRequest(SessionPtr CSession);
+  void HandleRequest(SessionPtr CSession, const std::string &Header,
+                     size_t ContentLength);
+  void SendResponse(SessionPtr CSession);
+
+  asio::io_service service;
+  asio::ip::tcp::acceptor acceptor;
+  std::thread asioThread;
+
+  std::mutex messageMutex;
+  std::vector<std::string> messages;
+  std::deque<int> responseCodes;
+  int defaultResponseCode{202};
+  bool chunkedResponses{false};
+  std::vector<std::weak_ptr<Session>> sessions;
+  std::atomic_int requests{0};
+  std::atomic_int connections{0};
+  std::atomic_int compressedRequests{0};
+};
@@ -0,0 +1,81 @@
+//
+//  LogTestProxy.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "LogTestProxy.hpp"
+#include <array>
+#include <ciso646>
+
+using namespace std::chrono_literals;
+
+struct LogTestProxy::Link {
+  explicit Link(asio::io_service &Service)
+      : Client(Service), Server(Service), RetryTimer(Service) {}
+  asio::ip::tcp::socket Client;
+  asio::ip::tcp::socket Server;
+  asio::steady_timer RetryTimer;
+  std::array<char, 1024> Buffer;
+};
+
+LogTestProxy::LogTestProxy(short ListenPort, short TargetPort,
+                           int ReceiveBufferSize)
+    : Acceptor(Service), TargetPort(TargetPort) {
+  asio::ip::tcp::endpoint Endpoint(asio::ip::address_v4::loopback(),
+                                   ListenPort);
+  Acceptor.open(Endpoint.protocol());
+  Acceptor.set_option(asio::socket_base::reuse_address(true));
+  Acceptor.set_option(
+      asio::socket_base::receive_buffer_size(ReceiveBufferSize));
+  Acceptor.bind(Endpoint);
+  Acceptor.listen();
+  waitForConnection();
+  ProxyThread = std::thread([this]() { Service.run(); });
+}
+
+LogTestProxy::~LogTestProxy() {
+  Service.stop();
+  ProxyThread.join();
+}
+
+void LogTestProxy::waitForConnection() {
+  auto NewLink = std::make_shared<Link>(Service);
+  Acceptor.async_accept(NewLink->Client, [this, NewLink](auto &Error) {
+    if (Error) {
+      return;
+    }
+    asio::error_code ConnectError;
+    NewLink->Server.connect(
+        asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TargetPort),
+        ConnectError);
+    if (not ConnectError) {
+      forward(NewLink);
+    }
+    waitForConnection();
+  });
+}
+
+void LogTestProxy::forward(Link_P CLink) {
+  if (Blackhole) {
+    // Neither read nor forward data until the blackhole is disabled.
+    CLink->RetryTimer.expires_after(10ms);
+    CLink->RetryTimer.async_wait([this, CLink](auto &) { forward(CLink); });
+    return;
+  }
+  CLink->Client.async_read_some(
+      asio::buffer(CLink->Buffer), [this, CLink](auto &Error, auto Size) {
+        if (Error) {
+          asio::error_code Ignored;
+          CLink->Server.close(Ignored);
+          return;
+        }
+        asio::error_code WriteError;
+        asio::write(CLink->Server, asio::buffer(CLink->Buffer.data(), Size),
+                    WriteError);
+        if (not WriteError) {
+          forward(CLink);
+        }
+      });
+}
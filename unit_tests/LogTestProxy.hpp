@@ -0,0 +1,41 @@
+//
+//  LogTestProxy.hpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/// \brief TCP proxy which can be made to stop forwarding (and reading) data,
+/// simulating a half-open connection.
+class LogTestProxy {
+public:
+  /// \param[in] ListenPort Port to accept connections on.
+  /// \param[in] TargetPort Port (on localhost) to forward connections to.
+  /// \param[in] ReceiveBufferSize Receive buffer size of the accepted
+  /// connections. A small buffer makes the writes of the client stall soon
+  /// after the proxy has stopped reading.
+  LogTestProxy(short ListenPort, short TargetPort,
+               int ReceiveBufferSize = 4096);
+  ~LogTestProxy();
+  /// \brief Stop (true) or resume (false) forwarding data.
+  void setBlackhole(bool Enable) { Blackhole = Enable; }
+
+private:
+  struct Link;
+  using Link_P = std::shared_ptr<Link>;
+  void waitForConnection();
+  void forward(Link_P CLink);
+
+  asio::io_service Service;
+  asio::ip::tcp::acceptor Acceptor;
+  short TargetPort;
+  std::atomic_bool Blackhole{false};
+  std::thread ProxyThread;
+};
@@ -0,0 +1,107 @@
+//
+//  LogTestUdpServer.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "LogTestUdpServer.hpp"
+#include "Decompress.hpp"
+#include <ciso646>
+
+LogTestUdpServer::LogTestUdpServer(short port)
+    : service(),
+      socket(service, asio::ip::udp::endpoint(asio::ip::udp::v4(), port)) {
+  // Make losses caused by a slow receiver less likely.
+  asio::error_code Ignored;
+  socket.set_option(asio::socket_base::receive_buffer_size(8 * 1024 * 1024),
+                    Ignored);
+  WaitForDatagram();
+  asioThread = std::thread([this]() { service.run(); });
+}
+
+LogTestUdpServer::~LogTestUdpServer() {
+  service.post([this]() { socket.close(); });
+  asioThread.join();
+}
+
+void LogTestUdpServer::WaitForDatagram() {
+  socket.async_receive_from(asio::buffer(receiveBuffer), remoteEndpoint,
+                            [this](auto &ec, auto bytesReceived) {
+                              HandleReceive(ec, bytesReceived);
+                            });
+}
+
+void LogTestUdpServer::HandleReceive(const std::error_code &ec,
+                                     std::size_t bytesReceived) {
+  if (ec) {
+    return;
+  }
+  ++datagrams;
+  auto Data = receiveBuffer.data();
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  if (bytesReceived >= 12 and static_cast<unsigned char>(Data[0]) == 0x1e and
+      static_cast<unsigned char>(Data[1]) == 0x0f) {
+    ++chunks;
+    std::uint64_t MessageId{0};
+    for (int i = 0; i < 8; ++i) {
+      MessageId = (MessageId << 8) | static_cast<unsigned char>(Data[2 + i]);
+    }
+    auto SequenceNumber = static_cast<unsigned char>(Data[10]);
+    auto SequenceCount = static_cast<unsigned char>(Data[11]);
+    auto &Partial = partialMessages[MessageId];
+    if (Partial.Chunks.empty()) {
+      Partial.Chunks.resize(SequenceCount);
+    }
+    if (SequenceNumber < Partial.Chunks.size() and
+        Partial.Chunks[SequenceNumber].empty()) {
+      Partial.Chunks[SequenceNumber] =
+          std::string(Data + 12, bytesReceived - 12);
+      ++Partial.ChunksReceived;
+    }
+    if (Partial.ChunksReceived == Partial.Chunks.size()) {
+      std::string Message;
+      for (auto &Chunk : Partial.Chunks) {
+        Message += Chunk;
+      }
+      AddMessage(std::move(Message));
+      partialMessages.erase(MessageId);
+    }
+  } else {
+    AddMessage(std::string(Data, bytesReceived));
+  }
+  WaitForDatagram();
+}
+
+void LogTestUdpServer::AddMessage(std::string Message) {
+  if (IsCompressed(Message)) {
+    ++compressedMessages;
+    Message = Decompress(Message);
+  }
+  messages.push_back(std::move(Message));
+}
+
+std::vector<std::string> LogTestUdpServer::GetMessages() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  return messages;
+}
+
+int LogTestUdpServer::GetNrOfMessages() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  return static_cast<int>(messages.size());
+}
+
+int LogTestUdpServer::GetNrOfDatagrams() { return datagrams; }
+
+int LogTestUdpServer::GetNrOfChunks() { return chunks; }
+
+int LogTestUdpServer::GetNrOfCompressedMessages() { return compressedMessages; }
+
+void LogTestUdpServer::Clear() {
+  std::lock_guard<std::mutex> Lock(messageMutex);
+  messages.clear();
+  partialMessages.clear();
+  datagrams = 0;
+  chunks = 0;
+  compressedMessages = 0;
+}
@@ -0,0 +1,56 @@
+//
+//  LogTestUdpServer.hpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#pragma once
+
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \brief Receives GELF messages over UDP, re-assembles chunked messages and
+/// decompresses compressed messages.
+class LogTestUdpServer {
+public:
+  explicit LogTestUdpServer(short port);
+  ~LogTestUdpServer();
+  std::vector<std::string> GetMessages();
+  int GetNrOfMessages();
+  int GetNrOfDatagrams();
+  int GetNrOfChunks();
+  int GetNrOfCompressedMessages();
+  void Clear();
+
+private:
+  struct PartialMessage {
+    std::vector<std::string> Chunks;
+    size_t ChunksReceived{0};
+  };
+
+  void WaitForDatagram();
+  void HandleReceive(const std::error_code &ec, std::size_t bytesReceived);
+  void AddMessage(std::string Message);
+
+  asio::io_service service;
+  asio::ip::udp::socket socket;
+  asio::ip::udp::endpoint remoteEndpoint;
+  std::thread asioThread;
+
+  std::array<char, 65536> receiveBuffer{};
+
+  std::mutex messageMutex;
+  std::vector<std::string> messages;
+  std::map<std::uint64_t, PartialMessage> partialMessages;
+  std::atomic_int datagrams{0};
+  std::atomic_int chunks{0};
+  std::atomic_int compressedMessages{0};
+};
@@ -7,8 +7,10 @@
 
 #include "graylog_logger/Logger.hpp"
 #include "graylog_logger/ConsoleInterface.hpp"
+#include "graylog_logger/Log.hpp"
 #include <ciso646>
 #include <gtest/gtest.h>
+#include <iostream>
 #include <thread>
 
 class LoggerStandIn : public Log::Logger {
@@ -38,3 +40,29 @@ TEST(Logger, ReplaceConsoleInterface) {
   EXPECT_GT(StdString.find("Static string"),
             StdString.find("Some error string."));
 }
+
+namespace {
+class ExitRecorder : public Log::BaseLogHandler {
+public:
+  void addMessage(const Log::LogMessage &Message) override {
+    std::this_thread::sleep_for(50ms);
+    std::cerr << "Delivered: " << Message.MessageString << std::endl;
+  }
+  bool flush(std::chrono::system_clock::duration) override { return true; }
+  bool emptyQueue() override { return true; }
+  size_t queueSize() override { return 0; }
+};
+} // namespace
+
+TEST(LoggerDeathTest, ShutdownAtExitDeliversMessages) {
+  EXPECT_EXIT(
+      {
+        Log::AddLogHandler(std::make_shared<ExitRecorder>());
+        Log::ShutdownAtExit(2000ms);
+        for (int i = 0; i < 5; ++i) {
+          Log::Msg(Log::Severity::Error, "Message " + std::to_string(i));
+        }
+        std::exit(0);
+      },
+      testing::ExitedWithCode(0), "Delivered: Message 4");
+}
@@ -11,11 +11,18 @@
 #include "graylog_logger/LibConfig.hpp"
 #include "graylog_logger/LogUtil.hpp"
 #include <asio.hpp>
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <ciso646>
 #include <gtest/gtest.h>
 #include <thread>
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 class LoggingBaseStandIn : public LoggingBase {
 public:
   using LoggingBase::BaseMsg;
@@ -228,6 +235,29 @@ TEST(LoggingBase, MachineInfoTest) {
   ASSERT_EQ(msg.ProcessId, getpid()) << "Incorrect process id.";
 }
 
+#ifndef _WIN32
+TEST(LoggingBase, ForkedChildReportsItsProcessId) {
+  LoggingBase ParentLog;
+  ParentLog.log(Severity::Critical, "No message");
+  ParentLog.flush(10s);
+  auto Child = fork();
+  ASSERT_NE(Child, -1);
+  if (Child == 0) {
+    // The executor of the parent does not exist in the child.
+    LoggingBase log;
+    auto standIn = std::make_shared<BaseLogHandlerStandIn>();
+    log.addLogHandler(standIn);
+    log.log(Severity::Critical, "No message");
+    log.flush(10s);
+    _exit(standIn->CurrentMessage.ProcessId == getpid() ? 0 : 1);
+  }
+  int Status{-1};
+  ASSERT_EQ(waitpid(Child, &Status, 0), Child);
+  ASSERT_TRUE(WIFEXITED(Status));
+  EXPECT_EQ(WEXITSTATUS(Status), 0) << "Incorrect process id in child.";
+}
+#endif
+
 TEST(LoggingBase, TimestampTest) {
   LoggingBase log;
   auto standIn = std::make_shared<BaseLogHandlerStandIn>();
@@ -240,6 +270,157 @@ TEST(LoggingBase, TimestampTest) {
   ASSERT_NEAR(time_diff.count(), 0.0, 0.1) << "Time stamp is incorrect.";
 }
 
+#ifdef __linux__
+namespace {
+int NrOfThreads() {
+  std::ifstream Status("/proc/self/status");
+  std::string Line;
+  while (std::getline(Status, Line)) {
+    if (Line.find("Threads:") == 0) {
+      return std::stoi(Line.substr(8));
+    }
+  }
+  return -1;
+}
+} // namespace
+
+TEST(LoggingBase, ThreadIsStartedOnFirstUse) {
+  auto ThreadsBefore = NrOfThreads();
+  auto log = std::make_unique<LoggingBase>();
+  EXPECT_EQ(NrOfThreads(), ThreadsBefore);
+  log->log(Severity::Error, "A message");
+  EXPECT_EQ(NrOfThreads(), ThreadsBefore + 1);
+  log.reset();
+  EXPECT_EQ(NrOfThreads(), ThreadsBefore);
+}
+#endif
+
+namespace {
+class ShutdownRecorder : public BaseLogHandlerStandIn {
+public:
+  explicit ShutdownRecorder(std::chrono::milliseconds Delay = 0ms,
+                            size_t Undelivered = 0)
+      : Delay(Delay), Undelivered(Undelivered) {}
+  void addMessage(const LogMessage &Message) override {
+    ++Messages;
+    BaseLogHandlerStandIn::addMessage(Message);
+  }
+  ShutdownReport shutdown(std::chrono::system_clock::duration) override {
+    std::this_thread::sleep_for(Delay);
+    ++Shutdowns;
+    return {Undelivered == 0, Undelivered};
+  }
+  size_t queueSize() override { return Queued; }
+  std::atomic<int> Messages{0};
+  std::atomic<int> Shutdowns{0};
+  std::atomic<size_t> Queued{0};
+
+private:
+  std::chrono::milliseconds Delay;
+  size_t Undelivered;
+};
+} // namespace
+
+TEST(LoggingBase, ShutdownDeliversQueuedMessages) {
+  LoggingBase log;
+  auto Handler = std::make_shared<ShutdownRecorder>();
+  log.addLogHandler(Handler);
+  for (int i = 0; i < 100; ++i) {
+    log.log(Severity::Error, "A message");
+  }
+  auto Report = log.shutdown(1s);
+  EXPECT_TRUE(Report.Completed);
+  EXPECT_EQ(Handler->Messages, 100);
+  EXPECT_EQ(Handler->Shutdowns, 1);
+}
+
+TEST(LoggingBase, MessagesAfterShutdownAreDiscarded) {
+  LoggingBase log;
+  auto Handler = std::make_shared<ShutdownRecorder>();
+  log.addLogHandler(Handler);
+  log.shutdown(1s);
+  log.log(Severity::Error, "A message");
+  log.flush(1s);
+  EXPECT_EQ(Handler->Messages, 0);
+}
+
+TEST(LoggingBase, ShutdownCombinesReports) {
+  LoggingBase log;
+  log.addLogHandler(std::make_shared<ShutdownRecorder>(0ms, 3));
+  log.addLogHandler(std::make_shared<ShutdownRecorder>(0ms, 4));
+  log.addLogHandler(std::make_shared<ShutdownRecorder>());
+  auto Report = log.shutdown(1s);
+  EXPECT_FALSE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 7u);
+}
+
+TEST(LoggingBase, ShutdownOfHandlersIsParallel) {
+  LoggingBase log;
+  for (int i = 0; i < 4; ++i) {
+    log.addLogHandler(std::make_shared<ShutdownRecorder>(200ms));
+  }
+  auto Start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(log.shutdown(2s).Completed);
+  EXPECT_LT(std::chrono::steady_clock::now() - Start, 700ms);
+}
+
+TEST(LoggingBase, ShutdownIsBounded) {
+  LoggingBase log;
+  log.addLogHandler(std::make_shared<ShutdownRecorder>(1000ms));
+  auto Start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(log.shutdown(100ms).Completed);
+  EXPECT_LT(std::chrono::steady_clock::now() - Start, 500ms);
+}
+
+TEST(LoggingBase, SlowHandlerShutdownDoesNotBlockExecutor) {
+  LoggingBase log;
+  log.addLogHandler(std::make_shared<ShutdownRecorder>(2000ms));
+  auto Start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(log.shutdown(100ms).Completed);
+  log.removeAllHandlers();
+  EXPECT_LT(std::chrono::steady_clock::now() - Start, 1000ms);
+}
+
+TEST(LoggingBase, TimedOutHandlerReportsQueuedMessages) {
+  LoggingBase log;
+  auto Handler = std::make_shared<ShutdownRecorder>(1000ms);
+  Handler->Queued = 5;
+  log.addLogHandler(Handler);
+  log.addLogHandler(std::make_shared<ShutdownRecorder>(0ms, 3));
+  auto Report = log.shutdown(100ms);
+  EXPECT_FALSE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 8u);
+}
+
+TEST(LoggingBase, BusyExecutorReportsQueuedMessages) {
+  class SlowReceiver : public ShutdownRecorder {
+  public:
+    void addMessage(const LogMessage &Message) override {
+      std::this_thread::sleep_for(500ms);
+      ShutdownRecorder::addMessage(Message);
+    }
+  };
+  LoggingBase log;
+  auto Handler = std::make_shared<SlowReceiver>();
+  Handler->Queued = 5;
+  log.addLogHandler(Handler);
+  log.log(Severity::Error, "A message");
+  auto Report = log.shutdown(10ms);
+  EXPECT_FALSE(Report.Completed);
+  EXPECT_EQ(Report.UndeliveredMessages, 5u);
+}
+
+TEST(LoggingBase, HandlerShutdownEndsBeforeDestruction) {
+  auto log = std::make_unique<LoggingBase>();
+  auto Handler = std::make_shared<ShutdownRecorder>(300ms);
+  log->addLogHandler(Handler);
+  EXPECT_FALSE(log->shutdown(10ms).Completed);
+  EXPECT_EQ(Handler->Shutdowns, 0);
+  log.reset();
+  EXPECT_EQ(Handler->Shutdowns, 1);
+  EXPECT_EQ(Handler.use_count(), 1);
+}
+
 #ifdef WITH_FMT
 
 TEST(LoggingBase, FmtLogMessage) {
@@ -0,0 +1,156 @@
+//
+//  MessageSpoolTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "MessageSpool.hpp"
+#include <ciso646>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace Log;
+
+namespace {
+const std::string SpoolDirectory{"message_spool_test"};
+
+std::vector<std::string> GetSpoolFiles() {
+  std::vector<std::string> Files;
+  if (auto Directory = opendir(SpoolDirectory.c_str())) {
+    while (auto Entry = readdir(Directory)) {
+      std::string Name(Entry->d_name);
+      if (Name != "." and Name != "..") {
+        Files.push_back(SpoolDirectory + "/" + Name);
+      }
+    }
+    closedir(Directory);
+  }
+  return Files;
+}
+
+void RemoveSpoolDirectory() {
+  for (auto &File : GetSpoolFiles()) {
+    std::remove(File.c_str());
+  }
+  rmdir(SpoolDirectory.c_str());
+}
+} // namespace
+
+class MessageSpoolTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    RemoveSpoolDirectory();
+    Settings.Directory = SpoolDirectory;
+  }
+  void TearDown() override { RemoveSpoolDirectory(); }
+  SpoolSettings Settings;
+};
+
+TEST_F(MessageSpoolTest, DisabledWithoutDirectory) {
+  MessageSpool UnderTest(SpoolSettings{});
+  EXPECT_FALSE(UnderTest.push("Some message"));
+  EXPECT_TRUE(UnderTest.empty());
+  EXPECT_EQ(UnderTest.messagesDropped(), 1u);
+}
+
+TEST_F(MessageSpoolTest, FirstInFirstOut) {
+  MessageSpool UnderTest(Settings);
+  EXPECT_TRUE(UnderTest.empty());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(UnderTest.push("Message " + std::to_string(i)));
+  }
+  EXPECT_FALSE(UnderTest.empty());
+  std::string Message;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(UnderTest.pop(Message));
+    EXPECT_EQ(Message, "Message " + std::to_string(i));
+  }
+  EXPECT_FALSE(UnderTest.pop(Message));
+  EXPECT_TRUE(UnderTest.empty());
+}
+
+TEST_F(MessageSpoolTest, InterleavedPushAndPop) {
+  MessageSpool UnderTest(Settings);
+  std::string Message;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(UnderTest.push("Message " + std::to_string(i)));
+    EXPECT_TRUE(UnderTest.push(std::string(i, 'a')));
+    ASSERT_TRUE(UnderTest.pop(Message));
+    EXPECT_EQ(Message, "Message " + std::to_string(i));
+    ASSERT_TRUE(UnderTest.pop(Message));
+    EXPECT_EQ(Message, std::string(i, 'a'));
+  }
+  EXPECT_TRUE(UnderTest.empty());
+}
+
+TEST_F(MessageSpoolTest, SegmentsAreRemovedWhenRead) {
+  Settings.SegmentSize = 100;
+  MessageSpool UnderTest(Settings);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_TRUE(UnderTest.push(std::string(40, 'a' + i)));
+  }
+  EXPECT_EQ(GetSpoolFiles().size(), 7u);
+  EXPECT_EQ(UnderTest.size(), 20u * 44);
+  std::string Message;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(UnderTest.pop(Message));
+    EXPECT_EQ(Message, std::string(40, 'a' + i));
+  }
+  EXPECT_FALSE(UnderTest.pop(Message));
+  EXPECT_EQ(UnderTest.size(), 0u);
+  EXPECT_TRUE(GetSpoolFiles().empty());
+}
+
+TEST_F(MessageSpoolTest, MaxSize) {
+  Settings.MaxSize = 100;
+  MessageSpool UnderTest(Settings);
+  EXPECT_TRUE(UnderTest.push(std::string(46, 'a')));
+  EXPECT_TRUE(UnderTest.push(std::string(46, 'b')));
+  EXPECT_FALSE(UnderTest.push(std::string(46, 'c')));
+  EXPECT_EQ(UnderTest.messagesDropped(), 1u);
+  std::string Message;
+  ASSERT_TRUE(UnderTest.pop(Message));
+  EXPECT_TRUE(UnderTest.push(std::string(46, 'c')));
+}
+
+TEST_F(MessageSpoolTest, MessagesSurviveRestart) {
+  {
+    MessageSpool UnderTest(Settings);
+    UnderTest.push("First message");
+    UnderTest.push("Second message");
+  }
+  MessageSpool UnderTest(Settings);
+  EXPECT_FALSE(UnderTest.empty());
+  UnderTest.push("Third message");
+  std::string Message;
+  ASSERT_TRUE(UnderTest.pop(Message));
+  EXPECT_EQ(Message, "First message");
+  ASSERT_TRUE(UnderTest.pop(Message));
+  EXPECT_EQ(Message, "Second message");
+  ASSERT_TRUE(UnderTest.pop(Message));
+  EXPECT_EQ(Message, "Third message");
+  EXPECT_FALSE(UnderTest.pop(Message));
+}
+
+TEST_F(MessageSpoolTest, TruncatedRecordIsSkipped) {
+  {
+    MessageSpool UnderTest(Settings);
+    UnderTest.push("First message");
+    UnderTest.push("Second message");
+  }
+  auto Files = GetSpoolFiles();
+  ASSERT_EQ(Files.size(), 1u);
+  // Simulate a crash while writing the second message.
+  ASSERT_EQ(truncate(Files[0].c_str(), 4 + 13 + 6), 0);
+  MessageSpool UnderTest(Settings);
+  std::string Message;
+  ASSERT_TRUE(UnderTest.pop(Message));
+  EXPECT_EQ(Message, "First message");
+  EXPECT_FALSE(UnderTest.pop(Message));
+  EXPECT_TRUE(UnderTest.empty());
+}
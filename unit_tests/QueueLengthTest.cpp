@@ -23,8 +23,7 @@ public:
 
 class FileInterfaceStandIn : public FileInterface {
 public:
-  FileInterfaceStandIn(int queueSize)
-      : FileInterface("messages.log", queueSize) {};
+  FileInterfaceStandIn() : FileInterface("messages.log") {};
 };
 
 class QueueLength : public ::testing::Test {
@@ -72,11 +71,10 @@ TEST_F(QueueLength, ConsoleInterfaceTest) {
 
 TEST_F(QueueLength, FileInterfaceTest) {
   std::atomic_int MsgCounter{0};
-  int QueueLength = 50;
   int TestLimit{50};
   testing::internal::CaptureStdout();
   {
-    FileInterfaceStandIn CLogger(QueueLength);
+    FileInterfaceStandIn CLogger;
     CLogger.setMessageStringCreatorFunction([&MsgCounter](auto Msg) {
       MsgCounter++;
       return "";
@@ -0,0 +1,141 @@
+//
+//  RelayServerTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "RelayServer.hpp"
+#include <ciso646>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace Log;
+using namespace std::chrono_literals;
+
+namespace {
+const std::string RelaySocketPath{"graylog_relay_test.sock"};
+
+class MessageCollector {
+public:
+  void add(std::string Message) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Messages.push_back(std::move(Message));
+  }
+  std::vector<std::string> get() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Messages;
+  }
+  bool waitFor(size_t NrOfMessages) {
+    auto EndTime = std::chrono::steady_clock::now() + 2s;
+    while (get().size() < NrOfMessages) {
+      if (std::chrono::steady_clock::now() > EndTime) {
+        return false;
+      }
+      std::this_thread::sleep_for(5ms);
+    }
+    return true;
+  }
+
+private:
+  std::mutex Mutex;
+  std::vector<std::string> Messages;
+};
+
+int ConnectClient(const std::string &Path) {
+  sockaddr_un Address{};
+  Address.sun_family = AF_UNIX;
+  Path.copy(Address.sun_path, sizeof(Address.sun_path) - 1);
+  int Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (connect(Socket, reinterpret_cast<sockaddr *>(&Address),
+              sizeof(Address)) == -1) {
+    close(Socket);
+    return -1;
+  }
+  return Socket;
+}
+
+void Write(int Socket, const std::string &Data) {
+  ASSERT_EQ(write(Socket, Data.data(), Data.size()),
+            static_cast<ssize_t>(Data.size()));
+}
+} // namespace
+
+TEST(RelayServer, ReceivesMessages) {
+  MessageCollector Collector;
+  RelayServer UnderTest(RelaySocketPath,
+                        [&](std::string Msg) { Collector.add(Msg); });
+  auto Socket = ConnectClient(RelaySocketPath);
+  ASSERT_NE(Socket, -1);
+  Write(Socket, std::string("first\0second\0", 13));
+  ASSERT_TRUE(Collector.waitFor(2));
+  EXPECT_EQ(Collector.get()[0], "first");
+  EXPECT_EQ(Collector.get()[1], "second");
+  EXPECT_EQ(UnderTest.messagesReceived(), 2u);
+  close(Socket);
+}
+
+TEST(RelayServer, MessageSplitOverWrites) {
+  MessageCollector Collector;
+  RelayServer UnderTest(RelaySocketPath,
+                        [&](std::string Msg) { Collector.add(Msg); });
+  auto Socket = ConnectClient(RelaySocketPath);
+  ASSERT_NE(Socket, -1);
+  Write(Socket, "a split");
+  std::this_thread::sleep_for(20ms);
+  Write(Socket, std::string(" message\0", 9));
+  ASSERT_TRUE(Collector.waitFor(1));
+  EXPECT_EQ(Collector.get()[0], "a split message");
+  close(Socket);
+}
+
+TEST(RelayServer, MultipleClients) {
+  MessageCollector Collector;
+  RelayServer UnderTest(RelaySocketPath,
+                        [&](std::string Msg) { Collector.add(Msg); });
+  std::vector<int> Sockets;
+  for (int i = 0; i < 10; ++i) {
+    Sockets.push_back(ConnectClient(RelaySocketPath));
+    ASSERT_NE(Sockets.back(), -1);
+  }
+  for (auto Socket : Sockets) {
+    Write(Socket, std::string("message\0", 8));
+  }
+  EXPECT_TRUE(Collector.waitFor(Sockets.size()));
+  EXPECT_EQ(UnderTest.clientCount(), Sockets.size());
+  for (auto Socket : Sockets) {
+    close(Socket);
+  }
+}
+
+TEST(RelayServer, IncompleteMessageOfClosedClientIsDiscarded) {
+  MessageCollector Collector;
+  RelayServer UnderTest(RelaySocketPath,
+                        [&](std::string Msg) { Collector.add(Msg); });
+  auto Socket = ConnectClient(RelaySocketPath);
+  ASSERT_NE(Socket, -1);
+  Write(Socket, std::string("complete\0incomplete", 19));
+  close(Socket);
+  ASSERT_TRUE(Collector.waitFor(1));
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(Collector.get().size(), 1u);
+  EXPECT_EQ(UnderTest.clientCount(), 0u);
+}
+
+TEST(RelayServer, TooLargeMessageIsDiscarded) {
+  MessageCollector Collector;
+  RelayServer UnderTest(
+      RelaySocketPath, [&](std::string Msg) { Collector.add(Msg); }, 10);
+  auto Socket = ConnectClient(RelaySocketPath);
+  ASSERT_NE(Socket, -1);
+  Write(Socket, std::string("much too large message\0small\0", 29));
+  ASSERT_TRUE(Collector.waitFor(1));
+  EXPECT_EQ(Collector.get()[0], "small");
+  EXPECT_EQ(UnderTest.messagesDiscarded(), 1u);
+  close(Socket);
+}
@@ -0,0 +1,166 @@
+//
+//  SharedFileTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "Decompress.hpp"
+#include "FileRotation.hpp"
+#include "graylog_logger/FileInterface.hpp"
+#include "graylog_logger/LibConfig.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ciso646>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Log;
+
+namespace {
+const std::string SharedTestName("sharedFileTest.log");
+
+/// \brief Line i of process p: "p i xxx..." with a varying number of x.
+std::string testLine(int Process, int Number) {
+  return std::to_string(Process) + " " + std::to_string(Number) + " " +
+         std::string(static_cast<size_t>(Number * 37 % 300), 'x');
+}
+
+/// \brief Write messages from several processes at the same time.
+/// \return Lines written per second.
+double writeFromProcesses(const FileConfig &Config, int NrOfProcesses,
+                          int MessagesPerProcess) {
+  auto Start = std::chrono::steady_clock::now();
+  std::vector<pid_t> Children;
+  for (int p = 0; p < NrOfProcesses; ++p) {
+    auto Child = fork();
+    if (Child == 0) {
+      {
+        FileInterface UnderTest(Config);
+        UnderTest.setMessageStringCreatorFunction(
+            [](const LogMessage &Msg) { return Msg.MessageString; });
+        for (int i = 0; i < MessagesPerProcess; ++i) {
+          auto Msg = std::make_shared<LogMessage>();
+          Msg->MessageString = testLine(p, i);
+          UnderTest.addSharedMessage(Msg);
+        }
+      }
+      _exit(0);
+    }
+    Children.push_back(Child);
+  }
+  for (auto Child : Children) {
+    int Status{0};
+    EXPECT_EQ(waitpid(Child, &Status, 0), Child);
+    EXPECT_TRUE(WIFEXITED(Status) and WEXITSTATUS(Status) == 0);
+  }
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  return NrOfProcesses * MessagesPerProcess / Elapsed.count();
+}
+
+/// \brief Check that every line of the (rotated) files is intact and that
+/// every process wrote all its lines, in order.
+void checkLines(int NrOfProcesses, int MessagesPerProcess) {
+  auto Files = findRotatedFiles(SharedTestName);
+  Files.push_back(SharedTestName);
+  std::vector<int> NextNumber(static_cast<size_t>(NrOfProcesses), 0);
+  for (auto &File : Files) {
+    std::ifstream InStream(File, std::ios::binary);
+    std::stringstream Contents;
+    Contents << InStream.rdbuf();
+    std::istringstream Lines(isCompressedFile(File)
+                                 ? DecompressMembers(Contents.str())
+                                 : Contents.str());
+    std::string Line;
+    while (std::getline(Lines, Line)) {
+      std::istringstream Fields(Line);
+      int Process{-1};
+      int Number{-1};
+      Fields >> Process >> Number;
+      ASSERT_TRUE(Process >= 0 and Process < NrOfProcesses) << Line;
+      ASSERT_EQ(Number, NextNumber[static_cast<size_t>(Process)]) << Line;
+      ASSERT_EQ(Line, testLine(Process, Number));
+      ++NextNumber[static_cast<size_t>(Process)];
+    }
+  }
+  for (auto Number : NextNumber) {
+    EXPECT_EQ(Number, MessagesPerProcess);
+  }
+}
+} // namespace
+
+class SharedFile : public ::testing::Test {
+public:
+  void SetUp() override { removeTestFiles(); }
+  void TearDown() override { removeTestFiles(); }
+  void removeTestFiles() {
+    std::remove(SharedTestName.c_str());
+    for (auto &File : findRotatedFiles(SharedTestName)) {
+      std::remove(File.c_str());
+    }
+  }
+};
+
+TEST_F(SharedFile, ProcessesDoNotTearLines) {
+  FileConfig Config{SharedTestName};
+  Config.SharedFile = true;
+  const int NrOfProcesses{4};
+  const int MessagesPerProcess{20000};
+  auto LinesPerSecond =
+      writeFromProcesses(Config, NrOfProcesses, MessagesPerProcess);
+  RecordProperty("LinesPerSecond", static_cast<int>(LinesPerSecond));
+  checkLines(NrOfProcesses, MessagesPerProcess);
+}
+
+TEST_F(SharedFile, LockedWritesWithSmallBuffers) {
+  FileConfig Config{SharedTestName};
+  Config.SharedFile = true;
+  Config.LockLargeWrites = true;
+  Config.BufferSize = 8 * 1024;
+  const int NrOfProcesses{4};
+  const int MessagesPerProcess{10000};
+  auto LinesPerSecond =
+      writeFromProcesses(Config, NrOfProcesses, MessagesPerProcess);
+  RecordProperty("LinesPerSecond", static_cast<int>(LinesPerSecond));
+  checkLines(NrOfProcesses, MessagesPerProcess);
+}
+
+TEST_F(SharedFile, OnlyOneProcessRotatesTheFile) {
+  FileConfig Config{SharedTestName};
+  Config.SharedFile = true;
+  Config.BufferSize = 4 * 1024;
+  Config.MaxFileSize = 256 * 1024;
+  Config.MaxRotatedFiles = 0;
+  const int NrOfProcesses{4};
+  const int MessagesPerProcess{5000};
+  writeFromProcesses(Config, NrOfProcesses, MessagesPerProcess);
+  auto Files = findRotatedFiles(SharedTestName);
+  // About 3.2 MB of lines, i.e. at least 12 files.
+  EXPECT_GE(Files.size(), 11u);
+  checkLines(NrOfProcesses, MessagesPerProcess);
+}
+
+#ifdef WITH_ZLIB
+TEST_F(SharedFile, RotatedFilesAreCompressedWithoutLosingLines) {
+  FileConfig Config{SharedTestName};
+  Config.SharedFile = true;
+  Config.BufferSize = 4 * 1024;
+  Config.MaxFileSize = 128 * 1024;
+  Config.MaxRotatedFiles = 0;
+  Config.CompressRotatedFiles = true;
+  const int NrOfProcesses{4};
+  const int MessagesPerProcess{5000};
+  writeFromProcesses(Config, NrOfProcesses, MessagesPerProcess);
+  auto Files = findRotatedFiles(SharedTestName);
+  ASSERT_GE(Files.size(), 20u);
+  // All but the files rotated last are compressed.
+  auto Compressed = std::count_if(Files.begin(), Files.end(), isCompressedFile);
+  EXPECT_GE(Compressed, static_cast<long>(Files.size()) - NrOfProcesses);
+  checkLines(NrOfProcesses, MessagesPerProcess);
+}
+#endif
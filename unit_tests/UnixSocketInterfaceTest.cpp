@@ -0,0 +1,93 @@
+//
+//  UnixSocketInterfaceTest.cpp
+//  graylog-logger
+//
+//  Copyright © 2026 European Spallation Source. All rights reserved.
+//
+
+#include "graylog_logger/UnixSocketInterface.hpp"
+#include "RelayServer.hpp"
+#include <atomic>
+#include <ciso646>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+using namespace Log;
+using namespace std::chrono_literals;
+
+namespace {
+const std::string UnixTestSocketPath{"graylog_unix_interface_test.sock"};
+
+template <typename Predicate>
+bool WaitFor(Predicate Pred, std::chrono::milliseconds TimeOut = 2000ms) {
+  auto EndTime = std::chrono::steady_clock::now() + TimeOut;
+  while (not Pred()) {
+    if (std::chrono::steady_clock::now() > EndTime) {
+      return false;
+    }
+    std::this_thread::sleep_for(5ms);
+  }
+  return true;
+}
+} // namespace
+
+TEST(UnixSocketInterface, MessageIsSentAsGelf) {
+  std::string LastMessage;
+  std::atomic<int> NrOfMessages{0};
+  RelayServer Relay(UnixTestSocketPath, [&](std::string Msg) {
+    LastMessage = std::move(Msg);
+    ++NrOfMessages;
+  });
+  UnixSocketInterface UnderTest(UnixTestSocketPath);
+  EXPECT_TRUE(UnderTest.isConnected());
+  LogMessage Message;
+  Message.MessageString = "A message sent to the relay.";
+  Message.SeverityLevel = Severity::Error;
+  Message.addField("a_field", std::int64_t(42));
+  UnderTest.addMessage(Message);
+  ASSERT_TRUE(WaitFor([&]() { return NrOfMessages == 1; }));
+  auto Json = nlohmann::json::parse(LastMessage);
+  EXPECT_EQ(Json["short_message"], Message.MessageString);
+  EXPECT_EQ(Json["level"], int(Severity::Error));
+  EXPECT_EQ(Json["_a_field"], 42);
+  EXPECT_TRUE(UnderTest.emptyQueue());
+  EXPECT_EQ(UnderTest.messagesDropped(), 0u);
+}
+
+TEST(UnixSocketInterface, MessagesAreDroppedWithoutRelay) {
+  UnixSocketInterface UnderTest("no_such_socket.sock");
+  EXPECT_FALSE(UnderTest.isConnected());
+  UnderTest.addMessage(LogMessage());
+  EXPECT_EQ(UnderTest.messagesDropped(), 1u);
+  EXPECT_TRUE(UnderTest.flush(10ms));
+}
+
+TEST(UnixSocketInterface, ManyMessages) {
+  std::atomic<int> NrOfMessages{0};
+  RelayServer Relay(UnixTestSocketPath, [&](std::string) { ++NrOfMessages; });
+  UnixSocketInterface UnderTest(UnixTestSocketPath);
+  LogMessage Message;
+  const int MessagesToSend{10000};
+  for (int i = 0; i < MessagesToSend; ++i) {
+    Message.MessageString = "Message number " + std::to_string(i);
+    UnderTest.addMessage(Message);
+  }
+  EXPECT_TRUE(UnderTest.flush(1s));
+  EXPECT_TRUE(WaitFor([&]() {
+    return NrOfMessages + UnderTest.messagesDropped() == MessagesToSend;
+  }));
+}
+
+TEST(UnixSocketInterface, ReconnectsToRestartedRelay) {
+  std::atomic<int> NrOfMessages{0};
+  UnixSocketInterface UnderTest(UnixTestSocketPath + ".restart");
+  EXPECT_FALSE(UnderTest.isConnected());
+  RelayServer Relay(UnixTestSocketPath + ".restart",
+                    [&](std::string) { ++NrOfMessages; });
+  // Re-connection attempts are made at most once per second.
+  std::this_thread::sleep_for(1100ms);
+  UnderTest.addMessage(LogMessage());
+  EXPECT_TRUE(UnderTest.isConnected());
+  EXPECT_TRUE(WaitFor([&]() { return NrOfMessages == 1; }));
+}